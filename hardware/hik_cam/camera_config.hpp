@@ -0,0 +1,30 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef RMCV_CAMERA_CONFIG_HPP
+#define RMCV_CAMERA_CONFIG_HPP
+
+// C system headers
+
+// C++ system headers
+#include <string>
+
+// Third-party library headers
+
+// Project headers
+#include "plugin/param/config_schema.hpp"
+
+namespace camera {
+    // hardware.toml 中的 [Camera]，[Camera.config] 是 MVS 的键值，键不固定，不在此声明
+#define RMCV_CAMERA_FIELDS(FIELD)                                          \
+    FIELD(bool, use_camera_sn, false, ::config_schema::any)                \
+    FIELD(std::string, camera_sn, "", ::config_schema::any)                \
+    FIELD(bool, use_config_from_file, false, ::config_schema::any)         \
+    FIELD(std::string, config_file_path, "", ::config_schema::any)         \
+    FIELD(bool, use_camera_config, true, ::config_schema::any)
+
+    RMCV_CONFIG_STRUCT(CameraConfig, "Camera", RMCV_CAMERA_FIELDS)
+} // namespace camera
+
+#endif //RMCV_CAMERA_CONFIG_HPP
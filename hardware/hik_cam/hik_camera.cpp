@@ -31,10 +31,14 @@
 
 // C++ system headers
 #include <algorithm>
+#include <chrono>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 
 // Third-party library headers
 #include <toml++/toml.hpp>
@@ -42,8 +46,13 @@
 // Project headers
 #include "hik_log.hpp"
 #include "plugin/debug/logger.hpp"
+#include "plugin/debug/metrics.hpp"
+#include "plugin/debug/profile.hpp"
+#include "plugin/debug/trace.hpp"
 
 namespace camera {
+    constexpr const char *CONFIG_TABLE = "Camera.config";
+
     auto convert_to_cam_info = [](const std::vector<std::pair<std::string, Param> > &param_vec)
         -> std::vector<std::pair<std::string, CAM_INFO> > {
         std::vector<std::pair<std::string, CAM_INFO> > result;
@@ -51,11 +60,11 @@ namespace camera {
         for (const auto &[key, param_value]: param_vec) {
             std::visit([&](const auto &value) {
                 using T = std::decay_t<decltype(value)>;
-                if constexpr (!std::is_same_v<T, std::vector<int64_t> >) {
-                    // 只有当类型不是 vector<int64_t> 时才添加
+                if constexpr (param_types::is_scalar_v<T>) {
+                    // 只有标量能写入相机
                     result.emplace_back(key, static_cast<CAM_INFO>(value));
                 } else {
-                    // 跳过 vector 类型，可以记录日志
+                    // 跳过数组和矩阵类型，可以记录日志
                     // debug::print(debug::PrintMode::WARNING, "Skipping vector parameter: {}", key);
                 }
             }, param_value);
@@ -64,15 +73,15 @@ namespace camera {
     };
 
     HikCam::HikCam() {
-        const auto param = toml::parse_file(CONFIG_DIR"/hardware.toml");
-        this->_param_from_toml = convert_to_cam_info(static_param::get_param_table(param, "Camera.config"));
-        this->_use_camera_sn = static_param::get_param<bool>(param, "Camera", "use_camera_sn");
-        this->_camera_sn = static_param::get_param<std::string>(param, "Camera", "camera_sn");
-        this->_use_config_from_file = static_param::get_param<bool>(param, "Camera", "use_config_from_file");
-        this->_config_file_path = static_param::get_param<std::string>(param, "Camera", "config_file_path");
-        this->_use_camera_config = static_param::get_param<bool>(param, "Camera", "use_camera_config");
-
-        this->_config_file_path = std::string(CONFIG_DIR) + "/" + _config_file_path;
+        const auto file = static_param::open_file("hardware.toml");
+        const auto &param = file->table();
+        this->_param_from_toml = convert_to_cam_info(static_param::get_param_table(param, CONFIG_TABLE));
+        // 一次报告 [Camera] 中的全部错误，出错的字段使用默认值
+        config_schema::ConfigErrors errors;
+        this->_config = CameraConfig::load(param, errors);
+        config_schema::report("Camera", errors);
+
+        this->_config_file_path = std::string(CONFIG_DIR) + "/" + _config.config_file_path;
     }
 
     bool HikCam::print_device_info(MV_CC_DEVICE_INFO *pstMVDevInfo) {
@@ -123,7 +132,7 @@ namespace camera {
             char device_sn[INFO_MAX_BUFFER_SIZE];
 
             if (sn.empty()) {
-                debug::print("warning", "camera", "Camera SN is empty");
+                debug::print(debug::PrintMode::WARNING, "camera", "Camera SN is empty");
                 return false;
             }
 
@@ -144,7 +153,7 @@ namespace camera {
 
                 if (std::strncmp(device_sn, sn.c_str(), INFO_MAX_BUFFER_SIZE) == 0) {
                     deviceIndex = i;
-                    debug::print("info", "camera", "Found camera with SN:{}", device_sn);
+                    debug::print(debug::PrintMode::INFO, "camera", "Found camera with SN:{}", device_sn);
                     return true;
                 }
             }
@@ -155,8 +164,8 @@ namespace camera {
         int device_index_to_use = 0;
 
         // 如果配置使用 SN，尝试按 SN 查找并打开（最多3次）
-        if (_use_camera_sn) {
-            debug::print("info", "camera", "Attempting to find camera by SN:{}", _camera_sn);
+        if (_config.use_camera_sn) {
+            debug::print(debug::PrintMode::INFO, "camera", "Attempting to find camera by SN:{}", _config.camera_sn);
 
             int sn_index = -1;
             bool found = false;
@@ -168,16 +177,16 @@ namespace camera {
                 HIKCAM_FATAL(MV_CC_EnumDevices(MV_USB_DEVICE, &stDeviceList));
 
                 if (stDeviceList.nDeviceNum == 0) {
-                    debug::print("warning", "camera", "No devices found in attempt {}", attempt + 1);
+                    debug::print(debug::PrintMode::WARNING, "camera", "No devices found in attempt {}", attempt + 1);
                     std::this_thread::sleep_for(std::chrono::seconds(5));
                     continue;
                 }
 
-                found = find_device_by_sn(_camera_sn, stDeviceList, sn_index);
+                found = find_device_by_sn(_config.camera_sn, stDeviceList, sn_index);
 
                 if (!found) {
-                    debug::print("warning", "camera", "Camera with SN {} not found in attempt {}",
-                                 _camera_sn, attempt + 1);
+                    debug::print(debug::PrintMode::WARNING, "camera", "Camera with SN {} not found in attempt {}",
+                                 _config.camera_sn, attempt + 1);
                     std::this_thread::sleep_for(std::chrono::milliseconds(500));
                 }
             }
@@ -193,17 +202,17 @@ namespace camera {
 
                     HIKCAM_FATAL(MV_CC_CreateHandle(&_handle, stDeviceList.pDeviceInfo[sn_index]));
                     HIKCAM_FATAL(MV_CC_OpenDevice(_handle));
-                    debug::print("info", "camera", "Successfully opened camera with SN: {}", _camera_sn);
+                    debug::print(debug::PrintMode::INFO, "camera", "Successfully opened camera with SN: {}", _config.camera_sn);
                     device_index_to_use = sn_index;
                     camera_opened = true;
                 } catch (const std::exception &e) {
-                    debug::print("error", "camera", "Failed to open found camera: {}", e.what());
+                    debug::print(debug::PrintMode::ERROR, "camera", "Failed to open found camera: {}", e.what());
                     camera_opened = false;
                 }
             } else {
-                debug::print("warning", "camera",
+                debug::print(debug::PrintMode::WARNING, "camera",
                              "Camera with SN {} not found after 3 attempts, will use default camera\n",
-                             _camera_sn);
+                             _config.camera_sn);
             }
         }
 
@@ -238,11 +247,11 @@ namespace camera {
                 debug::print(debug::PrintMode::WARNING, "Camera", "Get Packet Size fail nRet [0x{:X}]", nPacketSize);
             }
         }
-        if (_use_config_from_file)
+        if (_config.use_config_from_file)
             HIKCAM_WARN(MV_CC_FeatureLoad(this->_handle, this->_config_file_path.c_str()));
 
 
-        if (_use_camera_config) {
+        if (_config.use_camera_config) {
             this->set_camera_info_batch();
 
             this->check_and_print();
@@ -251,10 +260,25 @@ namespace camera {
 
         // 开始取流
         HIKCAM_FATAL(MV_CC_StartGrabbing(_handle));
+
+        if (_config.use_camera_config && _config_subscription == 0) {
+            _config_subscription = runtime_param::subscribe(
+                CONFIG_TABLE, [this](const runtime_param::ParamChanges &changes) { on_config_changed(changes); });
+        }
     }
 
 
     auto HikCam::capture() -> cv::Mat & {
+        TRACE_SCOPE("camera.capture");
+        PROFILE_REGION("camera.capture");
+        static auto &frames = debug::metrics::counter("camera_frames_total", "成功取到的帧数");
+        static auto &retries = debug::metrics::counter("camera_capture_retries_total", "取图失败后的重试次数");
+        static auto &failures = debug::metrics::counter("camera_capture_failures_total", "重试用尽后放弃的次数");
+        static auto &latency = debug::metrics::histogram("camera_capture_us", "capture() 耗时，含等待曝光和转换");
+        const auto start = std::chrono::steady_clock::now();
+        if (_has_pending_config.load(std::memory_order_acquire)) {
+            apply_pending_config();
+        }
         MV_FRAME_OUT stImageInfo = {0};
         const int maxRetries = 5;
         int numRetries = 0;
@@ -269,21 +293,28 @@ namespace camera {
                     CV_8UC1,
                     _pDstData
                 );
+                TRACE_SCOPE("camera.convert");
+                PROFILE_REGION("camera.debayer");
                 if (PixelType_Gvsp_Mono8 == stImageInfo.stFrameInfo.enPixelType) {
                     cv::cvtColor(rawData, _srcImage, cv::COLOR_GRAY2RGB);
                 } else if (PixelType_Gvsp_BayerRG8 == stImageInfo.stFrameInfo.enPixelType) {
                     cv::cvtColor(rawData, _srcImage, cv::COLOR_BayerRG2RGB);
                 } else {
-                    debug::print(debug::PrintMode::ERROR, "Camera", "Unsupported pixel format");
+                    RMCV_LOG_EVERY_MS(ERROR, 1000, "Camera", "Unsupported pixel format 0x{:x}",
+                                      static_cast<unsigned>(stImageInfo.stFrameInfo.enPixelType));
                 }
                 HIKCAM_WARN(MV_CC_FreeImageBuffer(_handle, &stImageInfo));
+                frames.add();
                 break;
             } else {
                 HIKCAM_WARN(_nRet);
+                retries.add();
                 numRetries++;
             }
         }
+        latency.observe(std::chrono::steady_clock::now() - start);
         if (numRetries == maxRetries) {
+            failures.add();
             throw std::runtime_error(fmt::format("Get Image failed after {} retries, last error code: 0x{:x}",
                                                  maxRetries, _nRet));
         }
@@ -397,7 +428,59 @@ namespace camera {
         }
     }
 
+    void HikCam::on_config_changed(const runtime_param::ParamChanges &changes) {
+        const std::string prefix = std::string(CONFIG_TABLE) + ".";
+        std::vector<std::pair<std::string, Param> > changed;
+        changed.reserve(changes.size());
+        for (const auto &change: changes) {
+            // 从配置文件中删除的参数保持相机当前的设置
+            if (change.removed) {
+                continue;
+            }
+            changed.emplace_back(change.name.substr(prefix.size()), change.new_value);
+        }
+
+        std::lock_guard<std::mutex> lock(_pending_mut);
+        for (auto &[key, value_variant]: convert_to_cam_info(changed)) {
+            // 取流线程还没下发的同名参数以最新值为准
+            auto iter = std::find_if(_pending_config.begin(), _pending_config.end(),
+                                     [&key](const auto &item) { return item.first == key; });
+            if (iter != _pending_config.end()) {
+                iter->second = std::move(value_variant);
+            } else {
+                _pending_config.emplace_back(key, std::move(value_variant));
+            }
+        }
+        _has_pending_config.store(!_pending_config.empty(), std::memory_order_release);
+    }
+
+    void HikCam::apply_pending_config() {
+        std::vector<std::pair<std::string, CAM_INFO> > pending;
+        {
+            std::lock_guard<std::mutex> lock(_pending_mut);
+            pending.swap(_pending_config);
+            _has_pending_config.store(false, std::memory_order_relaxed);
+        }
+        for (const auto &[key, value_variant]: pending) {
+            std::visit([this, &key](auto &&value) { this->set_camera_info(key, value); }, value_variant);
+
+            auto iter = std::find_if(_param_from_toml.begin(), _param_from_toml.end(),
+                                     [&key](const auto &item) { return item.first == key; });
+            if (iter != _param_from_toml.end()) {
+                iter->second = value_variant;
+            } else {
+                _param_from_toml.emplace_back(key, value_variant);
+            }
+            debug::print(debug::PrintMode::INFO, "Camera", "Camera.config.{} reloaded", key);
+        }
+    }
+
     HikCam::~HikCam() {
+        // 先取消订阅，保证析构过程中不会再有参数下发
+        if (_config_subscription != 0) {
+            runtime_param::unsubscribe(_config_subscription);
+            _config_subscription = 0;
+        }
         if (_handle != NULL) {
             HIKCAM_ERROR(MV_CC_StopGrabbing(_handle));
             HIKCAM_ERROR(MV_CC_RegisterImageCallBackEx(_handle, NULL, NULL));
@@ -5,10 +5,13 @@
 #include <cstdio>
 
 // C++ system headers
+#include <atomic>
 #include <iostream>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <variant>
+#include <vector>
 
 // Third-party library headers
 #include <MvCameraControl.h>
@@ -17,8 +20,10 @@
 #include <opencv2/imgproc.hpp>
 
 // Project headers
+#include "camera_config.hpp"
 #include "hik_log.hpp"
 #include "plugin/debug/logger.hpp"
+#include "plugin/param/runtime_parameter.hpp"
 #include "plugin/param/static_config.hpp"
 
 namespace camera {
@@ -43,11 +48,15 @@ namespace camera {
         cv::Mat _srcImage;
         std::vector<std::pair<std::string, CAM_INFO> > _param_from_toml;
 
-        bool _use_camera_sn;
-        std::string _camera_sn;
-        bool _use_config_from_file;
+        CameraConfig _config;
+        // CONFIG_DIR 下的完整路径
         std::string _config_file_path;
-        bool _use_camera_config;
+        // Camera.config 的参数变化订阅，0表示未订阅
+        uint64_t _config_subscription = 0;
+        // 参数线程收到的变化，由取流线程在 capture() 中下发
+        std::mutex _pending_mut;
+        std::vector<std::pair<std::string, CAM_INFO> > _pending_config;
+        std::atomic<bool> _has_pending_config{false};
 
         bool print_device_info(MV_CC_DEVICE_INFO *pstMVDevInfo);
 
@@ -55,6 +64,18 @@ namespace camera {
 
         void set_camera_info_batch();
 
+        /**
+         * @brief 运行时 Camera.config 变化后只记录变化的参数，在参数线程中调用
+         * 相机句柄、_nRet 和 _param_from_toml 只在取流线程中访问，实际下发由 apply_pending_config 完成
+         */
+        void on_config_changed(const runtime_param::ParamChanges &changes);
+
+        /**
+         * @brief 在取流线程中下发 on_config_changed 记录的参数
+         * 取流中无法修改的参数(如Width)会由HIKCAM_WARN报出，需重启生效
+         */
+        void apply_pending_config();
+
         template<typename T>
         auto get_camera_param(std::string_view param_name) -> std::optional<T>;
 
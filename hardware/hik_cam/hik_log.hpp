@@ -13,15 +13,12 @@
 // Project headers
 #include "plugin/debug/logger.hpp"
 // 注意：使用以下宏前，请确保已定义变量 `_nRet`，例如: int _nRet;
-// 警告处理宏定义
+// 警告处理宏定义，取图重试等热路径上调用，每个调用点每秒最多输出一次
 #define HIKCAM_WARN(func) \
 do { \
     _nRet = func; \
     if (_nRet != MV_OK) { \
-        debug::print(debug::PrintMode::WARNING, \
-                    #func, \
-                    " failed!, error code: 0x{:x}", \
-                    static_cast<unsigned>(_nRet)); \
+        RMCV_LOG_EVERY_MS(WARNING, 1000, #func, " failed!, error code: 0x{:x}", static_cast<unsigned>(_nRet)); \
     } \
 } while(0)
 
@@ -30,10 +27,7 @@ do { \
 do { \
     _nRet = func; \
     if (_nRet != MV_OK) { \
-        debug::print(debug::PrintMode::ERROR, \
-                    #func, \
-                    " failed!, error code: 0x{:x}", \
-                    static_cast<unsigned>(_nRet)); \
+        RMCV_LOG(ERROR, #func, " failed!, error code: 0x{:x}", static_cast<unsigned>(_nRet)); \
     } \
 } while(0)
 // 致命错误处理宏定义
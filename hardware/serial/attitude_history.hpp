@@ -0,0 +1,285 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef ATTITUDE_HISTORY_HPP
+#define ATTITUDE_HISTORY_HPP
+
+// C system headers
+
+// C++ system headers
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+// Third-party library headers
+#include <Eigen/Geometry>
+
+// Project headers
+#include "gimbal_packets.hpp"
+
+namespace serial {
+
+/**
+ * @brief 带时间戳的云台姿态历史
+ * 定长环形缓冲区，单写多读且读写均无锁：每个槽位用序号做seqlock，
+ * 读者发现槽位在读取过程中被覆盖时整体重试。
+ * 写者(串口接收线程)的时间戳需单调不减，查询按时间二分，O(log n)。
+ */
+class AttitudeHistory {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Sample {
+        Clock::time_point stamp;
+        Eigen::Quaterniond q;
+    };
+
+    /**
+     * @brief 构造函数
+     * @param capacity 保存的样本数，向上取整为2的幂
+     * @param max_extrapolation 查询时间晚于最新样本时允许外推的最长时间
+     */
+    explicit AttitudeHistory(
+        std::size_t capacity = 1024,
+        Clock::duration max_extrapolation = std::chrono::milliseconds(20))
+        : _max_extrapolation_ns(std::chrono::duration_cast<std::chrono::nanoseconds>(max_extrapolation).count()) {
+        std::size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        _mask = size - 1;
+        _slots = std::make_unique<Slot[]>(size);
+    }
+
+    AttitudeHistory(const AttitudeHistory&) = delete;
+    AttitudeHistory& operator=(const AttitudeHistory&) = delete;
+
+    /**
+     * @brief 写入一个样本，仅允许一个写线程调用
+     * @param stamp 接收时间
+     * @param q 云台姿态
+     * @return false 时间戳早于上一个样本，样本被丢弃
+     */
+    bool push(Clock::time_point stamp, const Eigen::Quaterniond& q) noexcept {
+        const int64_t stamp_ns = to_ns(stamp);
+        const uint64_t index = _count.load(std::memory_order_relaxed);
+        if (index > 0 && stamp_ns < _last_stamp_ns) {
+            return false;
+        }
+        Slot& slot = _slots[index & _mask];
+        slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.stamp_ns.store(stamp_ns, std::memory_order_relaxed);
+        slot.w.store(q.w(), std::memory_order_relaxed);
+        slot.x.store(q.x(), std::memory_order_relaxed);
+        slot.y.store(q.y(), std::memory_order_relaxed);
+        slot.z.store(q.z(), std::memory_order_relaxed);
+        slot.seq.store(2 * index + 2, std::memory_order_release);
+        _count.store(index + 1, std::memory_order_release);
+        _last_stamp_ns = stamp_ns;
+        return true;
+    }
+
+    bool push(Clock::time_point stamp, double yaw, double pitch, double roll) noexcept {
+        return push(stamp, from_euler(yaw, pitch, roll));
+    }
+
+    bool push(Clock::time_point stamp, const GimbalAttitude& attitude) noexcept {
+        return push(stamp, attitude.yaw, attitude.pitch, attitude.roll);
+    }
+
+    /**
+     * @brief 最新的样本
+     */
+    [[nodiscard]] std::optional<Sample> latest() const noexcept {
+        for (int attempt = 0; attempt < MAX_RETRIES; ++attempt) {
+            const uint64_t count = _count.load(std::memory_order_acquire);
+            if (count == 0) {
+                return std::nullopt;
+            }
+            Sample sample;
+            if (read_slot(count - 1, sample)) {
+                return sample;
+            }
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * @brief 查询t时刻的姿态
+     * 落在两个样本之间时球面插值；晚于最新样本且不超过外推上限时按最近两个样本的角速度外推；
+     * 早于最旧样本、超过外推上限或缓冲区为空时返回空
+     */
+    [[nodiscard]] std::optional<Eigen::Quaterniond> query(Clock::time_point t) const noexcept {
+        const int64_t t_ns = to_ns(t);
+        for (int attempt = 0; attempt < MAX_RETRIES; ++attempt) {
+            const uint64_t count = _count.load(std::memory_order_acquire);
+            if (count == 0) {
+                return std::nullopt;
+            }
+            // 最旧的一个槽位随时可能被覆盖，留出余量
+            const uint64_t capacity = _mask + 1;
+            const uint64_t oldest = count > capacity - 1 ? count - (capacity - 1) : 0;
+            const uint64_t newest = count - 1;
+
+            Sample last;
+            if (!read_slot(newest, last)) {
+                continue;
+            }
+            const int64_t last_ns = to_ns(last.stamp);
+            if (t_ns >= last_ns) {
+                if (t_ns - last_ns > _max_extrapolation_ns) {
+                    return std::nullopt;
+                }
+                if (t_ns == last_ns || newest == oldest) {
+                    return last.q;
+                }
+                Sample prev;
+                if (!read_slot(newest - 1, prev)) {
+                    continue;
+                }
+                return extrapolate(prev, last, t_ns);
+            }
+
+            // 二分查找第一个时间戳大于t的样本
+            uint64_t lo = oldest;
+            uint64_t hi = newest;
+            Sample upper = last;
+            bool torn = false;
+            while (lo < hi) {
+                const uint64_t mid = lo + (hi - lo) / 2;
+                Sample sample;
+                if (!read_slot(mid, sample)) {
+                    torn = true;
+                    break;
+                }
+                if (to_ns(sample.stamp) > t_ns) {
+                    hi = mid;
+                    upper = sample;
+                } else {
+                    lo = mid + 1;
+                }
+            }
+            if (torn) {
+                continue;
+            }
+            if (hi == oldest) {
+                // 早于最旧样本
+                return std::nullopt;
+            }
+            Sample lower;
+            if (!read_slot(hi - 1, lower)) {
+                continue;
+            }
+            const int64_t span = to_ns(upper.stamp) - to_ns(lower.stamp);
+            if (span <= 0) {
+                return upper.q;
+            }
+            const double ratio = static_cast<double>(t_ns - to_ns(lower.stamp)) / static_cast<double>(span);
+            return lower.q.slerp(ratio, upper.q);
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * @brief 查询t时刻的姿态，返回(yaw, pitch, roll)，弧度
+     */
+    [[nodiscard]] std::optional<Eigen::Vector3d> query_euler(Clock::time_point t) const noexcept {
+        const auto q = query(t);
+        if (!q) {
+            return std::nullopt;
+        }
+        return to_euler(*q);
+    }
+
+    /**
+     * @brief 当前保存的样本数
+     */
+    [[nodiscard]] std::size_t size() const noexcept {
+        const uint64_t count = _count.load(std::memory_order_acquire);
+        return static_cast<std::size_t>(std::min<uint64_t>(count, _mask + 1));
+    }
+
+    static Eigen::Quaterniond from_euler(double yaw, double pitch, double roll) noexcept {
+        return Eigen::Quaterniond(
+            Eigen::AngleAxisd(yaw, Eigen::Vector3d::UnitZ())
+            * Eigen::AngleAxisd(pitch, Eigen::Vector3d::UnitY())
+            * Eigen::AngleAxisd(roll, Eigen::Vector3d::UnitX())
+        );
+    }
+
+    static Eigen::Vector3d to_euler(const Eigen::Quaterniond& q) noexcept {
+        const double yaw = std::atan2(2.0 * (q.w() * q.z() + q.x() * q.y()),
+                                      1.0 - 2.0 * (q.y() * q.y() + q.z() * q.z()));
+        const double sin_pitch = std::clamp(2.0 * (q.w() * q.y() - q.z() * q.x()), -1.0, 1.0);
+        const double roll = std::atan2(2.0 * (q.w() * q.x() + q.y() * q.z()),
+                                       1.0 - 2.0 * (q.x() * q.x() + q.y() * q.y()));
+        return { yaw, std::asin(sin_pitch), roll };
+    }
+
+private:
+    constexpr static int MAX_RETRIES = 8;
+
+    struct Slot {
+        std::atomic<uint64_t> seq { 0 };
+        std::atomic<int64_t> stamp_ns { 0 };
+        std::atomic<double> w { 1.0 };
+        std::atomic<double> x { 0.0 };
+        std::atomic<double> y { 0.0 };
+        std::atomic<double> z { 0.0 };
+    };
+
+    static int64_t to_ns(Clock::time_point t) noexcept {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+    }
+
+    /**
+     * @brief 读取第index个样本
+     * @return false 槽位尚未写入或已被新样本覆盖
+     */
+    bool read_slot(uint64_t index, Sample& out) const noexcept {
+        const Slot& slot = _slots[index & _mask];
+        const uint64_t expected = 2 * index + 2;
+        if (slot.seq.load(std::memory_order_acquire) != expected) {
+            return false;
+        }
+        const int64_t stamp_ns = slot.stamp_ns.load(std::memory_order_relaxed);
+        const double w = slot.w.load(std::memory_order_relaxed);
+        const double x = slot.x.load(std::memory_order_relaxed);
+        const double y = slot.y.load(std::memory_order_relaxed);
+        const double z = slot.z.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != expected) {
+            return false;
+        }
+        out.stamp = Clock::time_point(std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(stamp_ns)));
+        out.q = Eigen::Quaterniond(w, x, y, z);
+        return true;
+    }
+
+    static Eigen::Quaterniond extrapolate(const Sample& prev, const Sample& last, int64_t t_ns) noexcept {
+        const int64_t span = to_ns(last.stamp) - to_ns(prev.stamp);
+        if (span <= 0) {
+            return last.q;
+        }
+        // 以最近两个样本间的旋转作为角速度，按时间比例外推
+        const Eigen::AngleAxisd delta(last.q * prev.q.conjugate());
+        const double ratio = static_cast<double>(t_ns - to_ns(last.stamp)) / static_cast<double>(span);
+        return (Eigen::Quaterniond(Eigen::AngleAxisd(delta.angle() * ratio, delta.axis())) * last.q).normalized();
+    }
+
+    std::unique_ptr<Slot[]> _slots;
+    std::size_t _mask { 0 };
+    int64_t _max_extrapolation_ns;
+    alignas(64) std::atomic<uint64_t> _count { 0 };
+    // 仅写线程访问
+    int64_t _last_stamp_ns { 0 };
+};
+
+} // namespace serial
+#endif //ATTITUDE_HISTORY_HPP
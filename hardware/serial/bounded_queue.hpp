@@ -0,0 +1,134 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+// C system headers
+
+// C++ system headers
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+// Third-party library headers
+
+// Project headers
+
+namespace serial {
+
+/**
+ * @brief 有界无锁队列(Dmitry Vyukov的环形序号算法)
+ * 多生产者安全；消费者通常只有一个写线程，但生产者在队列满时也可以弹出最旧元素腾出空间，
+ * 因此pop同样按多消费者实现。push/pop均不加锁、不分配内存。
+ * @tparam T 元素类型，需可默认构造和拷贝赋值
+ */
+template<typename T>
+class BoundedQueue {
+public:
+    static_assert(std::is_default_constructible_v<T>, "Queue element must be default constructible");
+
+    /**
+     * @brief 构造函数
+     * @param capacity 期望容量，向上取整为2的幂
+     */
+    explicit BoundedQueue(std::size_t capacity) {
+        std::size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        _mask = size - 1;
+        _cells = std::make_unique<Cell[]>(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * @brief 入队
+     * @return false 队列已满
+     */
+    bool try_push(const T& value) noexcept(std::is_nothrow_copy_assignable_v<T>) {
+        std::size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &_cells[pos & _mask];
+            const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 出队
+     * @return false 队列为空
+     */
+    bool try_pop(T& value) noexcept(std::is_nothrow_copy_assignable_v<T>) {
+        std::size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &_cells[pos & _mask];
+            const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        value = cell->data;
+        cell->sequence.store(pos + _mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 近似元素个数，包含已占位但尚未写完的元素
+     */
+    [[nodiscard]] std::size_t size_approx() const noexcept {
+        const std::size_t tail = _dequeue_pos.load(std::memory_order_acquire);
+        const std::size_t head = _enqueue_pos.load(std::memory_order_acquire);
+        return head > tail ? head - tail : 0;
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size_approx() == 0;
+    }
+
+    [[nodiscard]] std::size_t capacity() const noexcept {
+        return _mask + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence { 0 };
+        T data {};
+    };
+
+    std::unique_ptr<Cell[]> _cells;
+    std::size_t _mask { 0 };
+    alignas(64) std::atomic<std::size_t> _enqueue_pos { 0 };
+    alignas(64) std::atomic<std::size_t> _dequeue_pos { 0 };
+};
+
+} // namespace serial
+#endif //BOUNDED_QUEUE_HPP
@@ -78,6 +78,15 @@ public:
         return _buffer.data();
     }
 
+    /**
+     * @brief Get mutable buffer
+     * 获取可写的缓存buffer，供PacketSchema等编解码器直接写入数据区
+     * @return uint8_t*
+     */
+    [[nodiscard]] uint8_t* data() noexcept {
+        return _buffer.data();
+    }
+
     /**
      * @brief Self-define data loader
      * 自定义装载数据
@@ -0,0 +1,313 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef FRAME_PROTOCOL_HPP
+#define FRAME_PROTOCOL_HPP
+
+// C system headers
+
+// C++ system headers
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <type_traits>
+#include <vector>
+
+// Third-party library headers
+
+// Project headers
+
+namespace serial {
+
+// 变长帧封装，与裁判系统串口协议保持一致，下位机可直接复用其CRC实现
+// [SOF(0xa5), data_len(u16), seq(u8), crc8] [msg_id(u16)] [...data...] [crc16]
+// 多字节字段均为小端；seq按msg_id分别计数，用于统计每类消息的丢包
+namespace frame {
+
+constexpr uint8_t SOF_BYTE = 0xa5;
+constexpr std::size_t HEADER_SIZE = 5;
+constexpr std::size_t MSG_ID_SIZE = 2;
+constexpr std::size_t TAIL_SIZE = 2;
+constexpr std::size_t OVERHEAD = HEADER_SIZE + MSG_ID_SIZE + TAIL_SIZE;
+constexpr std::size_t DEFAULT_MAX_PAYLOAD = 1024;
+// data_len字段为u16
+constexpr std::size_t MAX_PAYLOAD_LIMIT = 0xffff;
+// seq落后不超过该值视为重传或乱序，落后更多说明下位机重启或长时间断流，直接以新seq为准
+constexpr int SEQ_REORDER_WINDOW = 16;
+// 连续这么多帧都是重复时同样以新seq为准
+constexpr uint32_t SEQ_RESYNC_DUPLICATES = 8;
+
+namespace detail {
+
+// CRC-8/MAXIM，初值0xff
+constexpr std::array<uint8_t, 256> make_crc8_table() {
+    std::array<uint8_t, 256> table {};
+    for (int i = 0; i < 256; ++i) {
+        uint8_t crc = static_cast<uint8_t>(i);
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x01) ? static_cast<uint8_t>((crc >> 1) ^ 0x8c) : static_cast<uint8_t>(crc >> 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+// CRC-16/MCRF4XX，初值0xffff
+constexpr std::array<uint16_t, 256> make_crc16_table() {
+    std::array<uint16_t, 256> table {};
+    for (int i = 0; i < 256; ++i) {
+        uint16_t crc = static_cast<uint16_t>(i);
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x0001) ? static_cast<uint16_t>((crc >> 1) ^ 0x8408)
+                                 : static_cast<uint16_t>(crc >> 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr auto CRC8_TABLE = make_crc8_table();
+constexpr auto CRC16_TABLE = make_crc16_table();
+
+} // namespace detail
+
+inline uint8_t crc8(const uint8_t* data, std::size_t len, uint8_t crc = 0xff) noexcept {
+    while (len-- > 0) {
+        crc = detail::CRC8_TABLE[crc ^ *data++];
+    }
+    return crc;
+}
+
+inline uint16_t crc16(const uint8_t* data, std::size_t len, uint16_t crc = 0xffff) noexcept {
+    while (len-- > 0) {
+        crc = static_cast<uint16_t>((crc >> 8) ^ detail::CRC16_TABLE[(crc ^ *data++) & 0xff]);
+    }
+    return crc;
+}
+
+} // namespace frame
+
+/**
+ * @brief 解码出的一帧数据，payload指向解码器内部缓存，仅在回调内有效
+ */
+struct FrameView {
+    uint16_t msg_id;
+    uint8_t seq;
+    const uint8_t* payload;
+    std::size_t size;
+};
+
+/**
+ * @brief 单一消息类型的链路统计
+ */
+struct MessageStats {
+    uint64_t received { 0 };
+    // 由seq跳变推算出的丢失帧数
+    uint64_t lost { 0 };
+    // seq未前进(重传或乱序到达)的帧数，这类帧不计入丢失
+    uint64_t duplicates { 0 };
+    // 因seq大幅后退或持续重复而重新对齐的次数
+    uint64_t resyncs { 0 };
+    uint8_t last_seq { 0 };
+    // 当前连续重复的帧数
+    uint32_t duplicate_run { 0 };
+};
+
+/**
+ * @brief 变长帧链路统计
+ */
+struct FrameStats {
+    uint64_t frames { 0 };
+    uint64_t header_crc_errors { 0 };
+    uint64_t frame_crc_errors { 0 };
+    uint64_t oversize { 0 };
+    // 为重新同步帧头而丢弃的字节数
+    uint64_t dropped_bytes { 0 };
+    std::map<uint16_t, MessageStats> messages;
+};
+
+/**
+ * @brief 变长帧编码器
+ * 每个msg_id维护独立的seq，非线程安全，由调用者加锁
+ */
+class FrameEncoder {
+public:
+    /**
+     * @param max_payload 允许的最大数据区长度，应与对端解码器一致，不超过frame::MAX_PAYLOAD_LIMIT
+     */
+    explicit FrameEncoder(std::size_t max_payload = frame::DEFAULT_MAX_PAYLOAD):
+        _max_payload(std::min(max_payload, frame::MAX_PAYLOAD_LIMIT)) {}
+
+    /**
+     * @brief 编码一帧
+     * @param msg_id 消息id
+     * @param payload 数据区
+     * @param len 数据区长度
+     * @param out 输出缓存，帧会追加到末尾
+     * @return 本帧的总长度，数据区超过max_payload时返回0且不写入out、不消耗seq
+     */
+    std::size_t encode(uint16_t msg_id, const void* payload, std::size_t len, std::vector<uint8_t>& out) {
+        if (len > _max_payload) {
+            return 0;
+        }
+        const std::size_t begin = out.size();
+        out.resize(begin + frame::OVERHEAD + len);
+        uint8_t* dst = out.data() + begin;
+
+        dst[0] = frame::SOF_BYTE;
+        dst[1] = static_cast<uint8_t>(len & 0xff);
+        dst[2] = static_cast<uint8_t>((len >> 8) & 0xff);
+        dst[3] = _seq[msg_id]++;
+        dst[4] = frame::crc8(dst, frame::HEADER_SIZE - 1);
+        dst[5] = static_cast<uint8_t>(msg_id & 0xff);
+        dst[6] = static_cast<uint8_t>((msg_id >> 8) & 0xff);
+        if (len > 0) {
+            std::memcpy(dst + frame::HEADER_SIZE + frame::MSG_ID_SIZE, payload, len);
+        }
+        const std::size_t crc_pos = frame::HEADER_SIZE + frame::MSG_ID_SIZE + len;
+        const uint16_t crc = frame::crc16(dst, crc_pos);
+        dst[crc_pos] = static_cast<uint8_t>(crc & 0xff);
+        dst[crc_pos + 1] = static_cast<uint8_t>((crc >> 8) & 0xff);
+        return frame::OVERHEAD + len;
+    }
+
+    template<typename T>
+    std::size_t encode(uint16_t msg_id, const T& payload, std::vector<uint8_t>& out) {
+        static_assert(std::is_trivially_copyable_v<T>, "Frame payload must be trivially copyable");
+        return encode(msg_id, &payload, sizeof(T), out);
+    }
+
+private:
+    std::size_t _max_payload;
+    std::map<uint16_t, uint8_t> _seq;
+};
+
+/**
+ * @brief 流式变长帧解码器
+ * 可逐字节或成块喂入数据；帧头CRC8、整帧CRC16任一失败都只丢弃1字节后重新搜索SOF，
+ * 因此丢字节、插入噪声后能在下一帧自动恢复同步。非线程安全。
+ */
+class FrameDecoder {
+public:
+    explicit FrameDecoder(std::size_t max_payload = frame::DEFAULT_MAX_PAYLOAD):
+        _max_payload(max_payload) {
+        _buffer.reserve(2 * (max_payload + frame::OVERHEAD));
+    }
+
+    /**
+     * @brief 喂入数据并解析出所有完整帧
+     * @param data 新收到的字节
+     * @param len 字节数
+     * @param on_frame 每解析出一帧调用一次，签名 void(const FrameView&)
+     * @return 本次解析出的帧数
+     */
+    template<typename Handler>
+    std::size_t feed(const uint8_t* data, std::size_t len, Handler&& on_frame) {
+        _buffer.insert(_buffer.end(), data, data + len);
+
+        std::size_t parsed = 0;
+        std::size_t pos = 0;
+        while (true) {
+            // 搜索帧头
+            const std::size_t sof = find_sof(pos);
+            _stats.dropped_bytes += sof - pos;
+            pos = sof;
+
+            const std::size_t available = _buffer.size() - pos;
+            if (available < frame::HEADER_SIZE) {
+                break;
+            }
+            const uint8_t* head = _buffer.data() + pos;
+            if (frame::crc8(head, frame::HEADER_SIZE - 1) != head[4]) {
+                ++_stats.header_crc_errors;
+                ++_stats.dropped_bytes;
+                ++pos;
+                continue;
+            }
+            const std::size_t payload_len = static_cast<std::size_t>(head[1]) | (static_cast<std::size_t>(head[2]) << 8);
+            if (payload_len > _max_payload) {
+                ++_stats.oversize;
+                ++_stats.dropped_bytes;
+                ++pos;
+                continue;
+            }
+            const std::size_t frame_len = frame::OVERHEAD + payload_len;
+            if (available < frame_len) {
+                // 等待剩余数据
+                break;
+            }
+            const std::size_t crc_pos = frame_len - frame::TAIL_SIZE;
+            const uint16_t expected = static_cast<uint16_t>(head[crc_pos] | (head[crc_pos + 1] << 8));
+            if (frame::crc16(head, crc_pos) != expected) {
+                ++_stats.frame_crc_errors;
+                ++_stats.dropped_bytes;
+                ++pos;
+                continue;
+            }
+
+            FrameView view {
+                static_cast<uint16_t>(head[5] | (head[6] << 8)),
+                head[3],
+                head + frame::HEADER_SIZE + frame::MSG_ID_SIZE,
+                payload_len
+            };
+            account(view);
+            on_frame(view);
+            ++parsed;
+            pos += frame_len;
+        }
+
+        // 丢弃已消费的数据
+        _buffer.erase(_buffer.begin(), _buffer.begin() + static_cast<std::ptrdiff_t>(pos));
+        return parsed;
+    }
+
+    [[nodiscard]] const FrameStats& stats() const noexcept {
+        return _stats;
+    }
+
+    void reset() noexcept {
+        _buffer.clear();
+    }
+
+private:
+    [[nodiscard]] std::size_t find_sof(std::size_t from) const noexcept {
+        const auto* begin = _buffer.data() + from;
+        const auto* found = static_cast<const uint8_t*>(std::memchr(begin, frame::SOF_BYTE, _buffer.size() - from));
+        return found == nullptr ? _buffer.size() : static_cast<std::size_t>(found - _buffer.data());
+    }
+
+    void account(const FrameView& view) {
+        ++_stats.frames;
+        auto [it, inserted] = _stats.messages.try_emplace(view.msg_id);
+        MessageStats& msg = it->second;
+        ++msg.received;
+        if (!inserted) {
+            // seq为u8，按有符号差值判断前进还是后退，回绕后依然正确
+            const auto delta = static_cast<int8_t>(static_cast<uint8_t>(view.seq - msg.last_seq));
+            if (delta <= 0 && delta >= -frame::SEQ_REORDER_WINDOW
+                && ++msg.duplicate_run < frame::SEQ_RESYNC_DUPLICATES) {
+                ++msg.duplicates;
+                return;
+            }
+            if (delta > 0) {
+                msg.lost += static_cast<uint64_t>(delta - 1);
+            } else {
+                // 下位机重启或丢失超过127帧，无法推算丢失数
+                ++msg.resyncs;
+            }
+        }
+        msg.duplicate_run = 0;
+        msg.last_seq = view.seq;
+    }
+
+    std::size_t _max_payload;
+    std::vector<uint8_t> _buffer;
+    FrameStats _stats;
+};
+
+} // namespace serial
+#endif //FRAME_PROTOCOL_HPP
@@ -0,0 +1,299 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef FRAME_TRANSCEIVER_HPP
+#define FRAME_TRANSCEIVER_HPP
+
+// C++ system headers
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Third-party library headers
+
+// Project headers
+#include "frame_protocol.hpp"
+#include "link_supervisor.hpp"
+#include "protocol/protocol_interface.hpp"
+#include "plugin/debug/logger.hpp"
+#include "plugin/debug/profile.hpp"
+#include "plugin/debug/trace.hpp"
+#include "umt/umt.hpp"
+
+namespace serial {
+
+/**
+ * @brief 未指定类型的消息，按原始字节发布
+ */
+struct FramePayload {
+    uint16_t msg_id;
+    uint8_t seq;
+    std::vector<uint8_t> data;
+};
+
+/**
+ * @brief 变长多消息帧收发器
+ * 与TransceiverManager共用ProtocolInterface，一条链路上二者择一使用。
+ * 接收线程解码出的每一帧按msg_id分发到各自的umt话题。
+ */
+class FrameTransceiver {
+public:
+    using SharedPtr = std::shared_ptr<FrameTransceiver>;
+
+    FrameTransceiver() = delete;
+
+    /**
+     * @brief 构造函数
+     * @param transporter transport interface
+     * @param max_payload 允许的最大数据区长度，超出的帧视为噪声
+     * @param link_options 断线重连参数，重连由LinkSupervisor的后台线程完成
+     * @throws std::invalid_argument if transporter is nullptr
+     */
+    explicit FrameTransceiver(
+        std::shared_ptr<ProtocolInterface> transporter,
+        std::size_t max_payload = frame::DEFAULT_MAX_PAYLOAD,
+        LinkSupervisor::Options link_options = LinkSupervisor::Options {})
+        : _link(std::make_shared<LinkSupervisor>(std::move(transporter), link_options)),
+          _encoder(max_payload),
+          _decoder(max_payload) {
+        _send_buffer.reserve(frame::OVERHEAD + max_payload);
+    }
+
+    ~FrameTransceiver() {
+        enable_realtime_read(false);
+    }
+
+    [[nodiscard]] bool is_open() const noexcept {
+        return _link->is_up();
+    }
+
+    /**
+     * @brief 获取链路健康统计
+     */
+    [[nodiscard]] LinkStats link_stats() const noexcept {
+        return _link->stats();
+    }
+
+    /**
+     * @brief 发送一帧
+     * 线程安全
+     * @param msg_id 消息id
+     * @param payload 数据区
+     * @param len 数据区长度
+     * @return true 发送成功，false 失败或数据区超过max_payload
+     */
+    bool send(uint16_t msg_id, const void* payload, std::size_t len);
+
+    template<typename T>
+    bool send(uint16_t msg_id, const T& payload) {
+        static_assert(std::is_trivially_copyable_v<T>, "Frame payload must be trivially copyable");
+        return send(msg_id, &payload, sizeof(T));
+    }
+
+    /**
+     * @brief 将某个msg_id路由到umt话题，数据区按T逐字节拷贝
+     * 请在enable_realtime_read之前完成全部路由注册
+     * @tparam T 数据区结构体，需与下位机的packed结构体逐字节一致
+     * @param msg_id 消息id
+     * @param topic umt话题名
+     */
+    template<typename T>
+    void route(uint16_t msg_id, const std::string& topic) {
+        static_assert(std::is_trivially_copyable_v<T>, "Frame payload must be trivially copyable");
+        auto publisher = std::make_shared<umt::Publisher<T>>(topic);
+        std::lock_guard<std::mutex> lock(_route_mut);
+        _routes[msg_id] = [this, publisher](const FrameView& view) {
+            if (view.size != sizeof(T)) {
+                ++_size_mismatch;
+                return;
+            }
+            T value;
+            std::memcpy(&value, view.payload, sizeof(T));
+            publisher->push(value);
+        };
+    }
+
+    /**
+     * @brief 将某个msg_id路由到umt话题，按FramePayload原样发布
+     */
+    void route_raw(uint16_t msg_id, const std::string& topic) {
+        auto publisher = std::make_shared<umt::Publisher<FramePayload>>(topic);
+        std::lock_guard<std::mutex> lock(_route_mut);
+        _routes[msg_id] = [publisher](const FrameView& view) {
+            publisher->push(FramePayload { view.msg_id, view.seq, { view.payload, view.payload + view.size } });
+        };
+    }
+
+    /**
+     * @brief 读取一次串口并分发解析出的所有帧
+     * @return 本次分发的帧数，读取失败返回-1
+     */
+    int poll();
+
+    /**
+     * @brief 启用/禁用实时接收模式
+     */
+    void enable_realtime_read(bool enable);
+
+    /**
+     * @brief 获取链路统计快照
+     * 只在调用时拷贝；不要在路由回调中调用，回调运行时接收线程持有统计锁
+     */
+    [[nodiscard]] FrameStats stats() const {
+        std::lock_guard<std::mutex> lock(_stats_mut);
+        return _decoder.stats();
+    }
+
+    /**
+     * @brief 收到但没有注册路由的帧数
+     */
+    [[nodiscard]] uint64_t unrouted() const noexcept {
+        return _unrouted;
+    }
+
+    /**
+     * @brief 数据区长度与路由类型不一致而丢弃的帧数
+     */
+    [[nodiscard]] uint64_t size_mismatch() const noexcept {
+        return _size_mismatch;
+    }
+
+private:
+    void dispatch(const FrameView& view);
+
+    static uint64_t decoder_errors(const FrameStats& stats) noexcept {
+        return stats.header_crc_errors + stats.frame_crc_errors + stats.oversize;
+    }
+
+    // 所有读写都经过链路看护，断线时立即失败，不在收发线程中重连
+    LinkSupervisor::SharedPtr _link;
+
+    // 发送相关
+    std::mutex _send_mut;
+    FrameEncoder _encoder;
+    std::vector<uint8_t> _send_buffer;
+
+    // 接收相关，仅在接收线程中访问；解码器的统计在 feed 期间由 _stats_mut 保护，供 stats() 读取
+    FrameDecoder _decoder;
+    std::array<uint8_t, 256> _read_buffer {};
+    mutable std::mutex _stats_mut;
+
+    std::mutex _route_mut;
+    std::unordered_map<uint16_t, std::function<void(const FrameView&)>> _routes;
+    std::atomic<uint64_t> _unrouted { 0 };
+    std::atomic<uint64_t> _size_mismatch { 0 };
+
+    std::atomic<bool> _use_realtime_read { false };
+    std::unique_ptr<std::thread> _realtime_read_thread;
+};
+
+inline bool FrameTransceiver::send(uint16_t msg_id, const void* payload, std::size_t len) {
+    TRACE_SCOPE("serial.send");
+    PROFILE_REGION("serial.send");
+    try {
+        std::lock_guard<std::mutex> lock(_send_mut);
+        _send_buffer.clear();
+        const auto frame_len = _encoder.encode(msg_id, payload, len, _send_buffer);
+        if (frame_len == 0) {
+            RMCV_LOG_EVERY_MS(ERROR, 1000, "FrameTransceiver", "payload of msg {:#06x} too large: {} bytes", msg_id, len);
+            return false;
+        }
+        const auto bytes_written =
+            _link->write(reinterpret_cast<const std::byte*>(_send_buffer.data()), frame_len);
+        if (bytes_written == static_cast<int>(frame_len)) {
+            _link->report_packet_tx();
+            return true;
+        }
+        // 链路断开，由LinkSupervisor在后台重连
+        return false;
+    } catch (const std::exception& e) {
+        RMCV_LOG_EVERY_MS(ERROR, 1000, "FrameTransceiver", "Error sending frame: {}", e.what());
+        return false;
+    }
+}
+
+inline void FrameTransceiver::dispatch(const FrameView& view) {
+    std::lock_guard<std::mutex> lock(_route_mut);
+    const auto it = _routes.find(view.msg_id);
+    if (it == _routes.end()) {
+        ++_unrouted;
+        return;
+    }
+    it->second(view);
+}
+
+inline int FrameTransceiver::poll() {
+    try {
+        const int recv_len =
+            _link->read(reinterpret_cast<std::byte*>(_read_buffer.data()), _read_buffer.size());
+        if (recv_len <= 0) {
+            // 链路断开，由LinkSupervisor在后台重连，丢弃不完整的帧
+            _decoder.reset();
+            return -1;
+        }
+        // 只计解码和分发，不计阻塞在 read 上的时间
+        TRACE_SCOPE("serial.recv");
+        PROFILE_REGION("serial.recv");
+        const auto errors_before = decoder_errors(_decoder.stats());
+        std::size_t parsed;
+        {
+            // 无竞争时只是一次加解锁，统计只在 stats() 被调用时拷贝
+            std::lock_guard<std::mutex> lock(_stats_mut);
+            parsed = _decoder.feed(
+                _read_buffer.data(),
+                static_cast<std::size_t>(recv_len),
+                [this](const FrameView& view) { dispatch(view); }
+            );
+        }
+        _link->report_packet_rx(parsed);
+        if (const auto resyncs = decoder_errors(_decoder.stats()) - errors_before; resyncs > 0) {
+            _link->report_resync(resyncs);
+        }
+        return static_cast<int>(parsed);
+    } catch (const std::exception& e) {
+        RMCV_LOG_EVERY_MS(ERROR, 1000, "FrameTransceiver", "Error receiving frame: {}", e.what());
+        return -1;
+    }
+}
+
+inline void FrameTransceiver::enable_realtime_read(bool enable) {
+    // 如果状态未改变，直接返回
+    if (enable == _use_realtime_read) {
+        return;
+    }
+
+    if (enable) {
+        _use_realtime_read = true;
+        _realtime_read_thread = std::make_unique<std::thread>([this]() {
+            using namespace std::chrono_literals;
+            while (_use_realtime_read) {
+                if (poll() < 0) {
+                    // 读取失败时短暂休眠以避免CPU占用过高
+                    std::this_thread::sleep_for(1ms);
+                }
+            }
+        });
+    } else {
+        _use_realtime_read = false;
+        if (_realtime_read_thread && _realtime_read_thread->joinable()) {
+            // 对端静默时读线程阻塞在read中，唤醒后它才能看到运行标志
+            _link->interrupt();
+            _realtime_read_thread->join();
+            _realtime_read_thread.reset();
+        }
+    }
+}
+
+} // namespace serial
+#endif //FRAME_TRANSCEIVER_HPP
@@ -0,0 +1,52 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef GIMBAL_PACKETS_HPP
+#define GIMBAL_PACKETS_HPP
+
+// C system headers
+
+// C++ system headers
+#include <cstdint>
+
+// Third-party library headers
+
+// Project headers
+#include "packet_schema.hpp"
+
+namespace serial {
+
+/**
+ * @brief 下位机上报的云台姿态，角度为弧度，ZYX(yaw-pitch-roll)顺序
+ */
+struct GimbalAttitude {
+    float yaw;
+    float pitch;
+    float roll;
+    // 下位机时间戳，毫秒
+    uint32_t mcu_stamp_ms;
+};
+
+/**
+ * @brief 上位机下发的云台指令，角度为弧度
+ */
+struct GimbalCommand {
+    float yaw;
+    float pitch;
+    uint8_t fire;
+};
+
+using GimbalAttitudeLayout = PacketSchema<
+    GimbalAttitude, ByteOrder::Little,
+    &GimbalAttitude::yaw, &GimbalAttitude::pitch, &GimbalAttitude::roll, &GimbalAttitude::mcu_stamp_ms>;
+
+using GimbalCommandLayout = PacketSchema<
+    GimbalCommand, ByteOrder::Little,
+    &GimbalCommand::yaw, &GimbalCommand::pitch, &GimbalCommand::fire>;
+
+static_assert(GimbalAttitudeLayout::fits<32>(), "GimbalAttitude must fit into FixedPacket32");
+static_assert(GimbalCommandLayout::fits<16>(), "GimbalCommand must fit into FixedPacket16");
+
+} // namespace serial
+#endif //GIMBAL_PACKETS_HPP
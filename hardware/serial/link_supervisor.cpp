@@ -0,0 +1,211 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// Source file corresponding header
+#include "link_supervisor.hpp"
+
+// C system headers
+
+// C++ system headers
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+// Third-party library headers
+#include <fmt/core.h>
+
+// Project headers
+#include "plugin/debug/logger.hpp"
+#include "plugin/debug/metrics.hpp"
+
+namespace serial {
+
+LinkSupervisor::LinkSupervisor(std::shared_ptr<ProtocolInterface> transporter, Options options):
+    _transporter(std::move(transporter)),
+    _options(options) {
+    if (!_transporter) {
+        throw std::invalid_argument("transporter is nullptr");
+    }
+    _up.store(_transporter->is_open(), std::memory_order_release);
+    register_metrics();
+    _thread = std::thread([this]() { supervise(); });
+}
+
+LinkSupervisor::~LinkSupervisor() {
+    debug::metrics::remove_collector(_metrics_collector);
+    {
+        std::lock_guard<std::mutex> lock(_mut);
+        _stop = true;
+    }
+    _cv.notify_one();
+    // 后台线程可能正在reopen()中等待阻塞的读写返回
+    _transporter->interrupt();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+int LinkSupervisor::read(std::byte* buffer, std::size_t len) {
+    if (!_up.load(std::memory_order_acquire)) {
+        return -1;
+    }
+    // 登记后再次确认，与后台线程的 "置 _up 为 false，再读 _in_flight" 构成 Dekker 式握手，
+    // 两边都需要顺序一致，保证要么这里看到断开，要么后台线程看到这次读取
+    _in_flight.fetch_add(1, std::memory_order_seq_cst);
+    if (!_up.load(std::memory_order_seq_cst)) {
+        _in_flight.fetch_sub(1, std::memory_order_release);
+        return -1;
+    }
+    const int ret = _transporter->read(buffer, len);
+    _in_flight.fetch_sub(1, std::memory_order_release);
+
+    if (ret <= 0) {
+        mark_down("read returned " + std::to_string(ret));
+        return -1;
+    }
+    _bytes_rx.fetch_add(static_cast<uint64_t>(ret), std::memory_order_relaxed);
+    return ret;
+}
+
+int LinkSupervisor::write(const std::byte* buffer, std::size_t len) {
+    if (!_up.load(std::memory_order_acquire)) {
+        return -1;
+    }
+    _in_flight.fetch_add(1, std::memory_order_seq_cst);
+    if (!_up.load(std::memory_order_seq_cst)) {
+        _in_flight.fetch_sub(1, std::memory_order_release);
+        return -1;
+    }
+    const int ret = _transporter->write(buffer, len);
+    _in_flight.fetch_sub(1, std::memory_order_release);
+
+    if (ret > 0) {
+        _bytes_tx.fetch_add(static_cast<uint64_t>(ret), std::memory_order_relaxed);
+    }
+    if (ret != static_cast<int>(len)) {
+        mark_down("short write " + std::to_string(ret) + "/" + std::to_string(len));
+        return -1;
+    }
+    return ret;
+}
+
+void LinkSupervisor::mark_down(const std::string& reason) {
+    _errors.fetch_add(1, std::memory_order_relaxed);
+    mark_fault();
+    // 只有第一个发现故障的线程负责唤醒后台线程
+    if (_up.exchange(false, std::memory_order_seq_cst)) {
+        debug::print(debug::PrintMode::WARNING, "LinkSupervisor", "link down: {}, {}", reason, _transporter->error_message());
+        std::lock_guard<std::mutex> lock(_mut);
+        _cv.notify_one();
+    }
+}
+
+LinkState LinkSupervisor::state() const noexcept {
+    if (!_up.load(std::memory_order_acquire)) {
+        return LinkState::DOWN;
+    }
+    const int64_t last_fault = _last_fault_ns.load(std::memory_order_relaxed);
+    const int64_t window =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(_options.degraded_window).count();
+    if (last_fault != 0 && now_ns() - last_fault < window) {
+        return LinkState::DEGRADED;
+    }
+    return LinkState::UP;
+}
+
+LinkStats LinkSupervisor::stats() const noexcept {
+    LinkStats stats;
+    stats.state = state();
+    stats.bytes_tx = _bytes_tx.load(std::memory_order_relaxed);
+    stats.bytes_rx = _bytes_rx.load(std::memory_order_relaxed);
+    stats.packets_tx = _packets_tx.load(std::memory_order_relaxed);
+    stats.packets_rx = _packets_rx.load(std::memory_order_relaxed);
+    stats.resyncs = _resyncs.load(std::memory_order_relaxed);
+    stats.errors = _errors.load(std::memory_order_relaxed);
+    stats.reopen_attempts = _reopen_attempts.load(std::memory_order_relaxed);
+    stats.reopen_successes = _reopen_successes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void LinkSupervisor::register_metrics() {
+    static std::atomic<int> next_link { 0 };
+    const std::string label = fmt::format("{{link=\"{}\"}}", next_link.fetch_add(1));
+    _metrics_collector = debug::metrics::add_collector([this, label](std::vector<debug::metrics::Sample>& samples) {
+        const LinkStats current = stats();
+        const auto add = [&](const char* name, const char* help, debug::metrics::Type type, double value) {
+            debug::metrics::Sample sample;
+            sample.name = name + label;
+            sample.help = help;
+            sample.type = type;
+            sample.value = value;
+            samples.push_back(std::move(sample));
+        };
+        using debug::metrics::Type;
+        add("serial_link_up", "链路是否打开", Type::GAUGE, current.state != LinkState::DOWN ? 1 : 0);
+        add("serial_link_degraded", "最近是否出现过重同步或读写错误", Type::GAUGE,
+            current.state == LinkState::DEGRADED ? 1 : 0);
+        add("serial_bytes_tx_total", "发送字节数", Type::COUNTER, static_cast<double>(current.bytes_tx));
+        add("serial_bytes_rx_total", "接收字节数", Type::COUNTER, static_cast<double>(current.bytes_rx));
+        add("serial_packets_tx_total", "发送包数", Type::COUNTER, static_cast<double>(current.packets_tx));
+        add("serial_packets_rx_total", "接收包数", Type::COUNTER, static_cast<double>(current.packets_rx));
+        add("serial_resyncs_total", "重同步次数", Type::COUNTER, static_cast<double>(current.resyncs));
+        add("serial_errors_total", "读写错误次数", Type::COUNTER, static_cast<double>(current.errors));
+        add("serial_reopen_attempts_total", "重连尝试次数", Type::COUNTER,
+            static_cast<double>(current.reopen_attempts));
+        add("serial_reopen_successes_total", "重连成功次数", Type::COUNTER,
+            static_cast<double>(current.reopen_successes));
+    });
+}
+
+bool LinkSupervisor::reopen() {
+    // 唤醒阻塞中的读写，等它们全部返回后再关闭，没有线程会在关闭或重新打开时仍在使用接口
+    _transporter->interrupt();
+    auto next_warning = std::chrono::steady_clock::now() + _options.drain_timeout;
+    while (_in_flight.load(std::memory_order_seq_cst) > 0) {
+        if (std::chrono::steady_clock::now() >= next_warning) {
+            debug::print(debug::PrintMode::WARNING, "LinkSupervisor", "still waiting for {} in-flight read/write calls",
+                         _in_flight.load(std::memory_order_relaxed));
+            next_warning += _options.drain_timeout;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    _transporter->close();
+
+    _reopen_attempts.fetch_add(1, std::memory_order_relaxed);
+    if (!_transporter->open()) {
+        return false;
+    }
+    _reopen_successes.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void LinkSupervisor::supervise() {
+    auto backoff = _options.initial_backoff;
+    std::unique_lock<std::mutex> lock(_mut);
+    while (!_stop) {
+        if (_up.load(std::memory_order_acquire)) {
+            // 链路正常，等待故障通知
+            _cv.wait(lock, [this]() { return _stop || !_up.load(std::memory_order_acquire); });
+            backoff = _options.initial_backoff;
+            continue;
+        }
+
+        lock.unlock();
+        const bool ok = reopen();
+        lock.lock();
+
+        if (ok) {
+            _up.store(true, std::memory_order_release);
+            debug::print(debug::PrintMode::INFO, "LinkSupervisor", "link up (reopen attempts: {})", _reopen_attempts.load());
+            continue;
+        }
+
+        // 指数退避，可被析构打断
+        _cv.wait_for(lock, backoff, [this]() { return _stop; });
+        backoff = std::min(backoff * 2, _options.max_backoff);
+    }
+}
+
+} // namespace serial
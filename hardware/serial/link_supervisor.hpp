@@ -0,0 +1,182 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef LINK_SUPERVISOR_HPP
+#define LINK_SUPERVISOR_HPP
+
+// C system headers
+
+// C++ system headers
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Third-party library headers
+
+// Project headers
+#include "protocol/protocol_interface.hpp"
+
+namespace serial {
+
+enum class LinkState {
+    UP,         // 链路正常
+    DEGRADED,   // 链路打开，但最近出现过重同步或读写错误
+    DOWN        // 链路断开，正在后台重连
+};
+
+/**
+ * @brief 链路健康统计快照
+ */
+struct LinkStats {
+    LinkState state { LinkState::DOWN };
+    uint64_t bytes_tx { 0 };
+    uint64_t bytes_rx { 0 };
+    uint64_t packets_tx { 0 };
+    uint64_t packets_rx { 0 };
+    uint64_t resyncs { 0 };
+    uint64_t errors { 0 };
+    uint64_t reopen_attempts { 0 };
+    uint64_t reopen_successes { 0 };
+};
+
+/**
+ * @brief 串口链路看护
+ * 收发线程只通过read/write访问底层接口，链路断开时立即返回-1，不在热路径上重连；
+ * 关闭与重新打开由独立线程按指数退避完成。需要按序列号重新枚举的设备由
+ * ProtocolInterface::open()自行处理(UartProtocol::set_serial_number、UsbBulkProtocol)。
+ */
+class LinkSupervisor {
+public:
+    using SharedPtr = std::shared_ptr<LinkSupervisor>;
+
+    struct Options {
+        // 首次重连等待时间
+        std::chrono::milliseconds initial_backoff { 50 };
+        // 重连等待时间上限
+        std::chrono::milliseconds max_backoff { 2000 };
+        // 出现故障后保持DEGRADED状态的时间
+        std::chrono::milliseconds degraded_window { 1000 };
+        // 标记断开后等待正在进行的读写返回，每超过这么久打印一次警告
+        std::chrono::milliseconds drain_timeout { 200 };
+    };
+
+    LinkSupervisor() = delete;
+
+    /**
+     * @brief 构造函数，若底层接口尚未打开，则由后台线程负责打开
+     * @param transporter transport interface
+     * @param options 重连参数
+     * @throws std::invalid_argument if transporter is nullptr
+     */
+    explicit LinkSupervisor(std::shared_ptr<ProtocolInterface> transporter, Options options);
+
+    explicit LinkSupervisor(std::shared_ptr<ProtocolInterface> transporter):
+        LinkSupervisor(std::move(transporter), Options {}) {}
+
+    ~LinkSupervisor();
+
+    LinkSupervisor(const LinkSupervisor&) = delete;
+    LinkSupervisor& operator=(const LinkSupervisor&) = delete;
+
+    /**
+     * @brief 读取数据，链路断开时立即返回-1；读取失败会将链路标记为断开
+     */
+    [[nodiscard]] int read(std::byte* buffer, std::size_t len);
+
+    /**
+     * @brief 写入数据，链路断开时立即返回-1；短写或失败会将链路标记为断开
+     */
+    [[nodiscard]] int write(const std::byte* buffer, std::size_t len);
+
+    /**
+     * @brief 上层协议统计
+     */
+    void report_packet_rx(uint64_t count = 1) noexcept {
+        _packets_rx.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void report_packet_tx(uint64_t count = 1) noexcept {
+        _packets_tx.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void report_resync(uint64_t count = 1) noexcept {
+        _resyncs.fetch_add(count, std::memory_order_relaxed);
+        mark_fault();
+    }
+
+    /**
+     * @brief 唤醒阻塞在read/write中的线程，被唤醒的调用返回-1
+     * 停止收发线程时先清除线程的运行标志再调用，否则对端静默时线程无法退出
+     */
+    void interrupt() noexcept {
+        _transporter->interrupt();
+    }
+
+    /**
+     * @brief 主动将链路标记为断开，交由后台线程重连
+     */
+    void mark_down(const std::string& reason);
+
+    [[nodiscard]] bool is_up() const noexcept {
+        return _up.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] LinkState state() const noexcept;
+
+    [[nodiscard]] LinkStats stats() const noexcept;
+
+    [[nodiscard]] std::string error_message() const {
+        return _transporter->error_message();
+    }
+
+private:
+    void supervise();
+
+    bool reopen();
+
+    void register_metrics();
+
+    void mark_fault() noexcept {
+        _last_fault_ns.store(now_ns(), std::memory_order_relaxed);
+    }
+
+    static int64_t now_ns() noexcept {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::shared_ptr<ProtocolInterface> _transporter;
+    Options _options;
+
+    std::atomic<bool> _up { false };
+    // 正在进行中的读写数，后台线程关闭接口前等待其归零
+    std::atomic<int> _in_flight { 0 };
+    std::atomic<int64_t> _last_fault_ns { 0 };
+
+    std::atomic<uint64_t> _bytes_tx { 0 };
+    std::atomic<uint64_t> _bytes_rx { 0 };
+    std::atomic<uint64_t> _packets_tx { 0 };
+    std::atomic<uint64_t> _packets_rx { 0 };
+    std::atomic<uint64_t> _resyncs { 0 };
+    std::atomic<uint64_t> _errors { 0 };
+    std::atomic<uint64_t> _reopen_attempts { 0 };
+    std::atomic<uint64_t> _reopen_successes { 0 };
+
+    // 以标签 link="<编号>" 导出stats()的指标回调
+    uint64_t _metrics_collector { 0 };
+
+    std::mutex _mut;
+    std::condition_variable _cv;
+    bool _stop { false };
+    std::thread _thread;
+};
+
+} // namespace serial
+#endif //LINK_SUPERVISOR_HPP
@@ -0,0 +1,232 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef PACKET_SCHEMA_HPP
+#define PACKET_SCHEMA_HPP
+
+// C system headers
+
+// C++ system headers
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+// Third-party library headers
+
+// Project headers
+#include "fixed_packet.hpp"
+
+namespace serial {
+
+/**
+ * @brief 线上字节序
+ * 下位机(STM32)默认为小端，与x86/aarch64主机一致时编解码退化为纯memcpy
+ */
+enum class ByteOrder {
+    Little,
+    Big
+};
+
+namespace detail {
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+constexpr ByteOrder HOST_BYTE_ORDER = ByteOrder::Big;
+#else
+constexpr ByteOrder HOST_BYTE_ORDER = ByteOrder::Little;
+#endif
+
+// 从成员指针中萃取所属结构体与成员类型
+template<typename Member>
+struct MemberPointerTraits;
+
+template<typename Struct, typename T>
+struct MemberPointerTraits<T Struct::*> {
+    using struct_type = Struct;
+    using value_type = T;
+};
+
+template<auto Member>
+using member_value_t = typename MemberPointerTraits<decltype(Member)>::value_type;
+
+// 与值宽度相同的无符号整型，用于浮点数/枚举的字节交换
+template<std::size_t Size>
+struct UnsignedOfSize;
+template<>
+struct UnsignedOfSize<1> {
+    using type = uint8_t;
+};
+template<>
+struct UnsignedOfSize<2> {
+    using type = uint16_t;
+};
+template<>
+struct UnsignedOfSize<4> {
+    using type = uint32_t;
+};
+template<>
+struct UnsignedOfSize<8> {
+    using type = uint64_t;
+};
+
+template<typename U>
+constexpr U byte_swap(U value) noexcept {
+    if constexpr (sizeof(U) == 1) {
+        return value;
+    } else if constexpr (sizeof(U) == 2) {
+        return __builtin_bswap16(value);
+    } else if constexpr (sizeof(U) == 4) {
+        return __builtin_bswap32(value);
+    } else {
+        return __builtin_bswap64(value);
+    }
+}
+
+template<ByteOrder Order, typename T>
+inline void store(uint8_t* dst, const T& value) noexcept {
+    if constexpr (Order == HOST_BYTE_ORDER || sizeof(T) == 1) {
+        std::memcpy(dst, &value, sizeof(T));
+    } else {
+        using U = typename UnsignedOfSize<sizeof(T)>::type;
+        U raw;
+        std::memcpy(&raw, &value, sizeof(T));
+        raw = byte_swap(raw);
+        std::memcpy(dst, &raw, sizeof(T));
+    }
+}
+
+template<ByteOrder Order, typename T>
+inline void load(const uint8_t* src, T& value) noexcept {
+    if constexpr (Order == HOST_BYTE_ORDER || sizeof(T) == 1) {
+        std::memcpy(&value, src, sizeof(T));
+    } else {
+        using U = typename UnsignedOfSize<sizeof(T)>::type;
+        U raw;
+        std::memcpy(&raw, src, sizeof(T));
+        raw = byte_swap(raw);
+        std::memcpy(&value, &raw, sizeof(T));
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief 编译期数据包布局
+ * 按成员指针的声明顺序紧凑排列(无对齐填充)到FixedPacket的数据区，
+ * 数据区从下标1开始，到check_byte(Capacity - 2)之前结束。
+ *
+ * 用法:
+ * @code
+ * struct GimbalCmd { float yaw; float pitch; uint8_t fire; };
+ * using GimbalCmdLayout = serial::PacketSchema<GimbalCmd, serial::ByteOrder::Little,
+ *                                              &GimbalCmd::yaw, &GimbalCmd::pitch, &GimbalCmd::fire>;
+ * serial::FixedPacket16 packet;
+ * GimbalCmdLayout::encode(cmd, packet);
+ * @endcode
+ *
+ * @tparam Struct 描述数据包内容的结构体
+ * @tparam Order 线上字节序
+ * @tparam Members 参与编解码的成员指针，按线上顺序排列
+ */
+template<typename Struct, ByteOrder Order, auto... Members>
+class PacketSchema {
+public:
+    static_assert(sizeof...(Members) > 0, "Packet schema must contain at least one field");
+    static_assert(
+        (std::is_same_v<typename detail::MemberPointerTraits<decltype(Members)>::struct_type, Struct>
+         && ...),
+        "All fields must be members of the schema struct"
+    );
+    static_assert(
+        ((std::is_arithmetic_v<detail::member_value_t<Members>>
+          || std::is_enum_v<detail::member_value_t<Members>>)
+         && ...),
+        "Schema fields must be arithmetic or enum types"
+    );
+
+    using StructType = Struct;
+
+    // 字段数量
+    constexpr static std::size_t FIELD_COUNT = sizeof...(Members);
+    // 各字段在线上的宽度
+    constexpr static std::array<std::size_t, FIELD_COUNT> FIELD_SIZES = {
+        sizeof(detail::member_value_t<Members>)...
+    };
+    // 数据区总长度
+    constexpr static std::size_t PAYLOAD_SIZE = (sizeof(detail::member_value_t<Members>) + ...);
+    // 各字段在整个数据包中的偏移(已计入帧头)
+    constexpr static std::array<std::size_t, FIELD_COUNT> OFFSETS = [] {
+        std::array<std::size_t, FIELD_COUNT> offsets {};
+        std::size_t offset = 1;
+        for (std::size_t i = 0; i < FIELD_COUNT; ++i) {
+            offsets[i] = offset;
+            offset += FIELD_SIZES[i];
+        }
+        return offsets;
+    }();
+
+    /**
+     * @brief 布局能否放入指定容量的数据包
+     * 帧头、校验字节、帧尾共占3字节
+     */
+    template<std::size_t Capacity>
+    constexpr static bool fits() noexcept {
+        return PAYLOAD_SIZE + 3 <= Capacity;
+    }
+
+    /**
+     * @brief 第I个字段在数据包中的偏移
+     */
+    template<std::size_t I>
+    constexpr static std::size_t offset_of() noexcept {
+        static_assert(I < FIELD_COUNT, "Field index out of range");
+        return OFFSETS[I];
+    }
+
+    /**
+     * @brief Encode struct into packet
+     * 将结构体编码进数据包，越界在编译期检查，运行期无分支
+     * @param value 源结构体
+     * @param packet 目标数据包，帧头/帧尾/校验字节保持不变
+     */
+    template<std::size_t Capacity>
+    static void encode(const Struct& value, FixedPacket<Capacity>& packet) noexcept {
+        static_assert(fits<Capacity>(), "Packet schema does not fit into FixedPacket capacity");
+        encode_impl(value, packet.data(), std::make_index_sequence<FIELD_COUNT> {});
+    }
+
+    /**
+     * @brief Decode struct from packet
+     * 从数据包中解码结构体，越界在编译期检查，运行期无分支
+     * @param packet 源数据包
+     * @param value 输出结构体
+     */
+    template<std::size_t Capacity>
+    static void decode(const FixedPacket<Capacity>& packet, Struct& value) noexcept {
+        static_assert(fits<Capacity>(), "Packet schema does not fit into FixedPacket capacity");
+        decode_impl(packet.buffer(), value, std::make_index_sequence<FIELD_COUNT> {});
+    }
+
+    template<std::size_t Capacity>
+    [[nodiscard]] static Struct decode(const FixedPacket<Capacity>& packet) noexcept {
+        Struct value {};
+        decode(packet, value);
+        return value;
+    }
+
+private:
+    template<std::size_t... I>
+    static void encode_impl(const Struct& value, uint8_t* dst, std::index_sequence<I...>) noexcept {
+        (detail::store<Order>(dst + OFFSETS[I], value.*Members), ...);
+    }
+
+    template<std::size_t... I>
+    static void decode_impl(const uint8_t* src, Struct& value, std::index_sequence<I...>) noexcept {
+        (detail::load<Order>(src + OFFSETS[I], value.*Members), ...);
+    }
+};
+
+} // namespace serial
+#endif //PACKET_SCHEMA_HPP
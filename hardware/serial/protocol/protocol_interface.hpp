@@ -22,6 +22,11 @@ public:
     [[nodiscard]] virtual bool open() = 0;
     virtual void close() noexcept = 0;
     [[nodiscard]] virtual bool is_open() const noexcept = 0;
+    /**
+     * @brief 唤醒阻塞中的read/write并使之后的读写立即返回-1，直到下一次open()
+     * 由其他线程在close()之前调用；读写本身带超时的接口可以不实现
+     */
+    virtual void interrupt() noexcept {}
 
     /*数据传输*/
     [[nodiscard]] virtual int read(std::byte *buffer, std::size_t len) = 0;
@@ -4,10 +4,12 @@
 // C system headers
 #include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <sys/eventfd.h>
 #include <sys/types.h>
 #include <termios.h>
 #include <unistd.h>
@@ -16,13 +18,20 @@
 #include <algorithm>
 #include <array>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <system_error>
+#include <utility>
 
 bool UartProtocol::set_param(int speed, int flow_ctrl, int databits, int stopbits, int parity) {
     // 设置串口数据帧格式
     constexpr std::array<std::pair<int, int>, 14> baud_rates = {
-        { //{B1152000, 1152000}, {B1000000, 1000000}, {B921600, 921600},
-          //{B576000, 576000},   {B500000, 500000},   {B460800, 460800},
+        { { B1152000, 1152000 },
+          { B1000000, 1000000 },
+          { B921600, 921600 },
+          { B576000, 576000 },
+          { B500000, 500000 },
+          { B460800, 460800 },
           { B230400, 230400 },
           { B115200, 115200 },
           { B19200, 19200 },
@@ -35,7 +44,7 @@ bool UartProtocol::set_param(int speed, int flow_ctrl, int databits, int stopbit
 
     termios options;
     if (tcgetattr(_fd, &options) != 0) {
-        _error_message = "tcgetattr failed: " + std::string(strerror(errno));
+        set_error("tcgetattr failed: " + std::string(strerror(errno)));
         return false;
     }
 
@@ -50,7 +59,7 @@ bool UartProtocol::set_param(int speed, int flow_ctrl, int databits, int stopbit
         }
     }
     if (!baud_found) {
-        _error_message = "Unsupported baud rate: " + std::to_string(speed);
+        set_error("Unsupported baud rate: " + std::to_string(speed));
         return false;
     }
 
@@ -72,14 +81,14 @@ bool UartProtocol::set_param(int speed, int flow_ctrl, int databits, int stopbit
             options.c_iflag |= (IXON | IXOFF | IXANY);
             break;
         default:
-            _error_message = "Invalid flow control: " + std::to_string(flow_ctrl);
+            set_error("Invalid flow control: " + std::to_string(flow_ctrl));
             return false;
     }
 
     // 数据位设置
     constexpr std::array<int, 4> valid_databits = { 5, 6, 7, 8 };
     if (std::find(valid_databits.begin(), valid_databits.end(), databits) == valid_databits.end()) {
-        _error_message = "Invalid data bits: " + std::to_string(databits);
+        set_error("Invalid data bits: " + std::to_string(databits));
         return false;
     }
     // 屏蔽其他标志位
@@ -118,7 +127,7 @@ bool UartProtocol::set_param(int speed, int flow_ctrl, int databits, int stopbit
             options.c_cflag &= ~PARENB;
             break;
         default:
-            _error_message = "Invalid parity: " + std::string(1, parity);
+            set_error("Invalid parity: " + std::string(1, parity));
             return false;
     }
 
@@ -131,7 +140,7 @@ bool UartProtocol::set_param(int speed, int flow_ctrl, int databits, int stopbit
             options.c_cflag |= CSTOPB;
             break;
         default:
-            _error_message = "Invalid stop bits: " + std::to_string(stopbits);
+            set_error("Invalid stop bits: " + std::to_string(stopbits));
             return false;
     }
 
@@ -146,35 +155,100 @@ bool UartProtocol::set_param(int speed, int flow_ctrl, int databits, int stopbit
     options.c_cc[VMIN] = 1; // 至少读取1字符
 
     if (tcflush(_fd, TCIFLUSH) != 0) {
-        _error_message = "tcflush failed: " + std::string(strerror(errno));
+        set_error("tcflush failed: " + std::string(strerror(errno)));
         return false;
     }
 
     // 激活配置 (将修改后的termios数据设置到串口中）
     if (tcsetattr(_fd, TCSANOW, &options) != 0) {
-        _error_message = "tcsetattr failed: " + std::string(strerror(errno));
+        set_error("tcsetattr failed: " + std::string(strerror(errno)));
         return false;
     }
 
     return true;
 }
 
+std::optional<std::string> UartProtocol::find_device_by_serial(std::string_view serial_number) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    for (const auto& entry: fs::directory_iterator("/sys/class/tty", ec)) {
+        const std::string name = entry.path().filename().string();
+        if (name.rfind("ttyUSB", 0) != 0 && name.rfind("ttyACM", 0) != 0) {
+            continue;
+        }
+        // 从tty设备向上查找USB设备目录中的serial属性
+        fs::path dir = fs::canonical(entry.path() / "device", ec);
+        while (!ec && dir.has_parent_path() && dir != dir.root_path()) {
+            std::ifstream file(dir / "serial");
+            if (file.is_open()) {
+                std::string value;
+                std::getline(file, value);
+                if (value == serial_number) {
+                    return "/dev/" + name;
+                }
+                break;
+            }
+            dir = dir.parent_path();
+        }
+        ec.clear();
+    }
+    return std::nullopt;
+}
+
+void UartProtocol::set_error(std::string message) {
+    std::lock_guard<std::mutex> lock(_error_mut);
+    _error_message = std::move(message);
+}
+
+UartProtocol::~UartProtocol() {
+    close();
+    if (_wake_fd >= 0) {
+        ::close(_wake_fd);
+    }
+}
+
 bool UartProtocol::open() {
     if (_is_open) {
         return true;
     }
-    _fd = ::open(_device_path.c_str(), O_RDWR | O_NOCTTY | O_NDELAY);
-    if (-1 == _fd) {
-        _error_message = "can't open uart device: " + _device_path;
+    if (_wake_fd < 0) {
+        _wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (_wake_fd < 0) {
+            set_error("eventfd failed: " + std::string(strerror(errno)));
+            return false;
+        }
+    } else {
+        // 清除上一次interrupt()留下的唤醒
+        uint64_t value;
+        if (::read(_wake_fd, &value, sizeof(value)) < 0) {
+            // 没有未处理的唤醒
+        }
+    }
+    if (!_serial_number.empty()) {
+        const auto device = find_device_by_serial(_serial_number);
+        if (!device) {
+            set_error("can't find uart device with serial number: " + _serial_number);
+            return false;
+        }
+        _device_path = *device;
+    }
+    const int fd = ::open(_device_path.c_str(), O_RDWR | O_NOCTTY | O_NDELAY);
+    if (-1 == fd) {
+        set_error("can't open uart device: " + _device_path);
         return false;
     }
+    _fd = fd;
     // 恢复串口为阻塞状态
-    if (fcntl(_fd, F_SETFL, 0) < 0) {
-        _error_message = "fcntl failed";
+    if (fcntl(fd, F_SETFL, 0) < 0) {
+        set_error("fcntl failed");
+        ::close(fd);
+        _fd = -1;
         return false;
     }
     // 设置串口数据帧格式
     if (!set_param(_speed, _flow_ctrl, _databits, _stopbits, _parity)) {
+        ::close(fd);
+        _fd = -1;
         return false;
     }
     _is_open = true;
@@ -191,25 +265,61 @@ void UartProtocol::close() noexcept {
 
     // 检查 ::close 返回值并记录错误
     if (::close(_fd) == -1) {
-        _error_message = std::strerror(errno);
+        set_error(std::strerror(errno));
     }
     _fd = -1;
     _is_open = false;
 }
 
+void UartProtocol::interrupt() noexcept {
+    if (_wake_fd >= 0) {
+        const uint64_t value = 1;
+        if (::write(_wake_fd, &value, sizeof(value)) < 0) {
+            // 计数器已满时读写同样会被唤醒
+        }
+    }
+}
+
+bool UartProtocol::wait_ready(short events) noexcept {
+    const int fd = _fd.load();
+    if (fd < 0) {
+        set_error("uart is not open");
+        return false;
+    }
+    pollfd fds[2] = { { fd, events, 0 }, { _wake_fd, POLLIN, 0 } };
+    while (poll(fds, 2, -1) < 0) {
+        if (errno != EINTR) {
+            set_error(std::strerror(errno));
+            return false;
+        }
+    }
+    if (fds[1].revents & POLLIN) {
+        set_error("interrupted");
+        return false;
+    }
+    return true;
+}
+
 // 使用 std::byte 增强类型安全
 [[nodiscard]] int UartProtocol::read(std::byte* buffer, std::size_t len) noexcept {
+    // 先poll再read，阻塞中的读取可以被interrupt()唤醒
+    if (!wait_ready(POLLIN)) {
+        return -1;
+    }
     const int ret = ::read(_fd, buffer, len);
     if (ret < 0) {
-        _error_message = std::strerror(errno);
+        set_error(std::strerror(errno));
     }
     return ret;
 }
 
 [[nodiscard]] int UartProtocol::write(const std::byte* buffer, std::size_t len) noexcept {
+    if (!wait_ready(POLLOUT)) {
+        return -1;
+    }
     const int ret = ::write(_fd, buffer, len);
     if (ret < 0) {
-        _error_message = std::strerror(errno);
+        set_error(std::strerror(errno));
     }
     return ret;
 }
@@ -8,6 +8,9 @@
 // C system headers
 
 // C++ system headers
+#include <atomic>
+#include <mutex>
+#include <optional>
 #include <string>
 
 // Third-party library headers
@@ -31,19 +34,37 @@ public:
         _databits(databits),
         _stopbits(stopbits),
         _parity(parity) {}
-    ~UartProtocol() override = default;
+    ~UartProtocol() override;
 
     [[nodiscard]] bool open() override;
     void close() noexcept override;
     [[nodiscard]] bool is_open() const noexcept override;
+    void interrupt() noexcept override;
 
     [[nodiscard]] int read(std::byte* buffer, std::size_t len) noexcept override;
     [[nodiscard]] int write(const std::byte* buffer, std::size_t len) noexcept override;
 
     [[nodiscard]] std::string error_message() const override {
+        std::lock_guard<std::mutex> lock(_error_mut);
         return _error_message;
     }
 
+    /**
+     * @brief 设置USB串口适配器的序列号
+     * 设置后每次open()都会按序列号重新查找设备节点，拔插后ttyUSB编号变化也能找回
+     * @param serial_number 序列号，为空时直接使用构造时的设备路径
+     */
+    void set_serial_number(std::string_view serial_number) {
+        _serial_number = serial_number;
+    }
+
+    /**
+     * @brief 在sysfs中按USB序列号查找tty设备节点(ttyUSB*、ttyACM*)
+     * @param serial_number 序列号
+     * @return 设备路径，如"/dev/ttyUSB1"，找不到时返回空
+     */
+    [[nodiscard]] static std::optional<std::string> find_device_by_serial(std::string_view serial_number);
+
 private:
     bool set_param(
         int speed = 115200,
@@ -52,13 +73,24 @@ private:
         int stopbits = 1,
         int parity = 'N'
     );
-    // 设备文件描述符
-    int _fd { -1 };
+    /**
+     * @brief 等待fd可读或可写，被interrupt()唤醒时返回false
+     */
+    bool wait_ready(short events) noexcept;
+    void set_error(std::string message);
+
+    // 设备文件描述符，读写线程与关闭线程都会访问
+    std::atomic<int> _fd { -1 };
     // 设备状态
-    bool _is_open { false };
+    std::atomic<bool> _is_open { false };
+    // interrupt()写入的eventfd，读写时与_fd一起poll，open()时清零
+    int _wake_fd { -1 };
+    // 读写线程与LinkSupervisor都会写入错误信息
+    mutable std::mutex _error_mut;
     std::string _error_message;
     // 设备参数
     std::string _device_path;
+    std::string _serial_number;
     int _speed;
     int _flow_ctrl;
     int _databits;
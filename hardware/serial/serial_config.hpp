@@ -0,0 +1,30 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef SERIAL_CONFIG_HPP
+#define SERIAL_CONFIG_HPP
+
+// C system headers
+
+// C++ system headers
+#include <string>
+
+// Third-party library headers
+
+// Project headers
+#include "plugin/param/config_schema.hpp"
+
+namespace serial {
+
+// hardware.toml 中的 [Serial]
+#define RMCV_SERIAL_FIELDS(FIELD)                                                      \
+    FIELD(std::string, port_name, "/dev/ttyUSB0", ::config_schema::any)                \
+    FIELD(int64_t, baudrate, 115200, ::config_schema::range<int64_t>(300, 4000000))    \
+    FIELD(std::string, serial_number, "", ::config_schema::any)                        \
+    FIELD(bool, use_fake_serial_data, false, ::config_schema::any)
+
+RMCV_CONFIG_STRUCT(SerialConfig, "Serial", RMCV_SERIAL_FIELDS)
+
+} // namespace serial
+#endif //SERIAL_CONFIG_HPP
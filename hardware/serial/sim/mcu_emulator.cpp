@@ -0,0 +1,245 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// Source file corresponding header
+#include "mcu_emulator.hpp"
+
+// C system headers
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+
+// C++ system headers
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+// Third-party library headers
+
+// Project headers
+#include "../fixed_packet.hpp"
+#include "plugin/debug/logger.hpp"
+
+namespace serial::sim {
+
+namespace {
+    constexpr double DEG_TO_RAD = M_PI / 180.0;
+    // 接收线程的poll超时，决定stop()的最长等待时间
+    constexpr int RECEIVE_POLL_TIMEOUT_MS = 50;
+} // namespace
+
+McuEmulator::McuEmulator(Options options):
+    _options(std::move(options)),
+    _rng(_options.seed != 0 ? _options.seed : std::random_device {}()),
+    _loss_probability(_options.loss_probability),
+    _drop_probability(_options.drop_probability),
+    _corrupt_probability(_options.corrupt_probability) {}
+
+McuEmulator::~McuEmulator() {
+    stop();
+}
+
+bool McuEmulator::start() {
+    if (is_running()) {
+        return true;
+    }
+
+    termios options {};
+    cfmakeraw(&options);
+    char slave_name[128] = {};
+    if (openpty(&_master_fd, &_slave_fd, slave_name, &options, nullptr) != 0) {
+        std::lock_guard<std::mutex> lock(_state_mut);
+        _error_message = std::string("openpty failed: ") + std::strerror(errno);
+        return false;
+    }
+    // 上位机不读时写满缓冲区即丢包，与真实串口溢出一致，也保证stop()不会卡在write上
+    const int flags = fcntl(_master_fd, F_GETFL);
+    fcntl(_master_fd, F_SETFL, flags | O_NONBLOCK);
+
+    {
+        std::lock_guard<std::mutex> lock(_state_mut);
+        _slave_path = slave_name;
+        _error_message.clear();
+    }
+
+    if (!_options.link_path.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(_options.link_path, ec);
+        std::filesystem::create_symlink(slave_name, _options.link_path, ec);
+        if (ec) {
+            debug::print(debug::PrintMode::WARNING, "McuEmulator", "Failed to link {} -> {}: {}", _options.link_path, slave_name, ec.message());
+        }
+    }
+
+    _start_time = std::chrono::steady_clock::now();
+    _running.store(true, std::memory_order_release);
+    _receive_thread = std::thread([this]() { receive_loop(); });
+    if (_options.rate_hz > 0.0) {
+        _stream_thread = std::thread([this]() { stream_loop(); });
+    }
+    debug::print(debug::PrintMode::INFO, "McuEmulator", "Emulating MCU on {} at {} Hz", slave_name, _options.rate_hz);
+    return true;
+}
+
+void McuEmulator::stop() {
+    if (!_running.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    if (_stream_thread.joinable()) {
+        _stream_thread.join();
+    }
+    if (_receive_thread.joinable()) {
+        _receive_thread.join();
+    }
+    ::close(_master_fd);
+    ::close(_slave_fd);
+    _master_fd = -1;
+    _slave_fd = -1;
+
+    if (!_options.link_path.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(_options.link_path, ec);
+    }
+}
+
+McuEmulator::Stats McuEmulator::stats() const noexcept {
+    Stats stats;
+    stats.packets_sent = _packets_sent.load(std::memory_order_relaxed);
+    stats.packets_lost = _packets_lost.load(std::memory_order_relaxed);
+    stats.bytes_dropped = _bytes_dropped.load(std::memory_order_relaxed);
+    stats.bytes_corrupted = _bytes_corrupted.load(std::memory_order_relaxed);
+    stats.bytes_received = _bytes_received.load(std::memory_order_relaxed);
+    stats.bytes_echoed = _bytes_echoed.load(std::memory_order_relaxed);
+    stats.commands_received = _commands_received.load(std::memory_order_relaxed);
+    return stats;
+}
+
+GimbalAttitude McuEmulator::current_attitude(std::chrono::steady_clock::time_point now) const noexcept {
+    const double elapsed = std::chrono::duration<double>(now - _start_time).count();
+    GimbalAttitude attitude {};
+    if (_has_command.load(std::memory_order_acquire)) {
+        attitude.yaw = _command_yaw.load(std::memory_order_relaxed);
+        attitude.pitch = _command_pitch.load(std::memory_order_relaxed);
+    } else {
+        attitude.yaw = static_cast<float>(_options.yaw_deg * DEG_TO_RAD);
+        attitude.pitch = static_cast<float>(_options.pitch_deg * DEG_TO_RAD);
+    }
+    if (_options.sweep_amplitude_deg != 0.0 && _options.sweep_period_s > 0.0) {
+        attitude.yaw += static_cast<float>(
+            _options.sweep_amplitude_deg * DEG_TO_RAD * std::sin(2.0 * M_PI * elapsed / _options.sweep_period_s));
+    }
+    attitude.roll = 0.0f;
+    attitude.mcu_stamp_ms = static_cast<uint32_t>(elapsed * 1000.0);
+    return attitude;
+}
+
+void McuEmulator::stream_loop() {
+    using Clock = std::chrono::steady_clock;
+    const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / _options.rate_hz));
+    const auto jitter_us = _options.jitter.count();
+    std::uniform_int_distribution<int64_t> jitter_dist(-jitter_us, jitter_us);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    std::uniform_int_distribution<std::size_t> byte_dist(0, ATTITUDE_PACKET_SIZE - 1);
+    std::uniform_int_distribution<int> bit_dist(0, 7);
+
+    FixedPacket<ATTITUDE_PACKET_SIZE> packet;
+    std::array<uint8_t, ATTITUDE_PACKET_SIZE> buffer {};
+    auto next = Clock::now();
+    while (_running.load(std::memory_order_acquire)) {
+        // 抖动只作用于单个周期，不累积
+        next += period;
+        std::this_thread::sleep_until(next + std::chrono::microseconds(jitter_us > 0 ? jitter_dist(_rng) : 0));
+
+        GimbalAttitudeLayout::encode(current_attitude(Clock::now()), packet);
+        if (chance(_rng) < _loss_probability.load(std::memory_order_relaxed)) {
+            _packets_lost.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        std::memcpy(buffer.data(), packet.buffer(), ATTITUDE_PACKET_SIZE);
+        std::size_t len = ATTITUDE_PACKET_SIZE;
+        if (chance(_rng) < _corrupt_probability.load(std::memory_order_relaxed)) {
+            buffer[byte_dist(_rng)] ^= static_cast<uint8_t>(1u << bit_dist(_rng));
+            _bytes_corrupted.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (chance(_rng) < _drop_probability.load(std::memory_order_relaxed)) {
+            const auto pos = byte_dist(_rng);
+            std::memmove(buffer.data() + pos, buffer.data() + pos + 1, len - pos - 1);
+            --len;
+            _bytes_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (write_master(buffer.data(), len)) {
+            _packets_sent.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            // 上位机未及时读取，pty缓冲区已满
+            _packets_lost.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void McuEmulator::receive_loop() {
+    std::array<uint8_t, 4096> buffer {};
+    std::vector<uint8_t> pending;
+    pending.reserve(buffer.size() + COMMAND_PACKET_SIZE);
+    pollfd pfd { _master_fd, POLLIN, 0 };
+
+    while (_running.load(std::memory_order_acquire)) {
+        if (::poll(&pfd, 1, RECEIVE_POLL_TIMEOUT_MS) <= 0) {
+            continue;
+        }
+        const auto len = ::read(_master_fd, buffer.data(), buffer.size());
+        if (len <= 0) {
+            // 从端无人打开时主端返回EIO，稍后重试
+            std::this_thread::sleep_for(std::chrono::milliseconds(RECEIVE_POLL_TIMEOUT_MS));
+            continue;
+        }
+        _bytes_received.fetch_add(static_cast<uint64_t>(len), std::memory_order_relaxed);
+        if (_options.echo && write_master(buffer.data(), static_cast<std::size_t>(len))) {
+            _bytes_echoed.fetch_add(static_cast<uint64_t>(len), std::memory_order_relaxed);
+        }
+
+        // 按帧头帧尾从字节流中找出指令包
+        pending.insert(pending.end(), buffer.begin(), buffer.begin() + len);
+        std::size_t pos = 0;
+        while (pending.size() - pos >= COMMAND_PACKET_SIZE) {
+            if (pending[pos] == FixedPacket<COMMAND_PACKET_SIZE>::HEAD_BYTE
+                && pending[pos + COMMAND_PACKET_SIZE - 1] == FixedPacket<COMMAND_PACKET_SIZE>::TAIL_BYTE) {
+                handle_command(pending.data() + pos);
+                pos += COMMAND_PACKET_SIZE;
+            } else {
+                ++pos;
+            }
+        }
+        pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(pos));
+    }
+}
+
+void McuEmulator::handle_command(const uint8_t* buffer) {
+    FixedPacket<COMMAND_PACKET_SIZE> packet;
+    packet.copy_from(buffer);
+    const auto command = GimbalCommandLayout::decode(packet);
+
+    _command_yaw.store(command.yaw, std::memory_order_relaxed);
+    _command_pitch.store(command.pitch, std::memory_order_relaxed);
+    _has_command.store(true, std::memory_order_release);
+    _commands_received.fetch_add(1, std::memory_order_relaxed);
+
+    if (_options.log_commands) {
+        RMCV_LOG_DEBUG("McuEmulator", "command yaw {:.3f} pitch {:.3f} fire {}", command.yaw, command.pitch, command.fire);
+    }
+    if (_command_callback) {
+        _command_callback(command);
+    }
+}
+
+bool McuEmulator::write_master(const uint8_t* buffer, std::size_t len) {
+    std::lock_guard<std::mutex> lock(_write_mut);
+    return ::write(_master_fd, buffer, len) == static_cast<ssize_t>(len);
+}
+
+} // namespace serial::sim
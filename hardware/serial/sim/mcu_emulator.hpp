@@ -0,0 +1,188 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef MCU_EMULATOR_HPP
+#define MCU_EMULATOR_HPP
+
+// C system headers
+
+// C++ system headers
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+// Third-party library headers
+
+// Project headers
+#include "../gimbal_packets.hpp"
+
+namespace serial::sim {
+
+/**
+ * @brief 基于伪终端的下位机模拟器
+ * 打开一对pty，从端交给上位机(UartProtocol或SimProtocol)，主端由模拟器读写：
+ * 按设定频率发送FixedPacket<32>格式的GimbalAttitude，可注入发送抖动、整包丢失、
+ * 丢字节和错字节；收到的FixedPacket<16>按GimbalCommand解析，可原样回传或打印。
+ * 不接下位机时用于串口链路的功能测试和性能测试。
+ */
+class McuEmulator {
+public:
+    using SharedPtr = std::shared_ptr<McuEmulator>;
+    using CommandCallback = std::function<void(const GimbalCommand&)>;
+
+    constexpr static std::size_t ATTITUDE_PACKET_SIZE = 32;
+    constexpr static std::size_t COMMAND_PACKET_SIZE = 16;
+
+    struct Options {
+        // 姿态包发送频率，Hz，<=0时不主动发送
+        double rate_hz { 1000.0 };
+        // 每个发送周期叠加的均匀随机抖动上限
+        std::chrono::microseconds jitter { 0 };
+        // 整包丢失的概率
+        double loss_probability { 0.0 };
+        // 丢失包内一个随机字节的概率
+        double drop_probability { 0.0 };
+        // 翻转包内一个随机比特的概率
+        double corrupt_probability { 0.0 };
+        // 将收到的数据原样回传，用于往返延迟测试
+        bool echo { false };
+        // 打印收到的云台指令
+        bool log_commands { true };
+        // 未收到指令前的初始姿态，角度
+        double yaw_deg { 0.0 };
+        double pitch_deg { 0.0 };
+        // 在yaw上叠加的正弦摆动，幅值为角度，周期为秒
+        double sweep_amplitude_deg { 0.0 };
+        double sweep_period_s { 2.0 };
+        // 为pty从端创建的软链接，为空则不创建
+        std::string link_path;
+        // 随机数种子，0表示随机
+        uint32_t seed { 0 };
+    };
+
+    struct Stats {
+        uint64_t packets_sent { 0 };
+        uint64_t packets_lost { 0 };
+        uint64_t bytes_dropped { 0 };
+        uint64_t bytes_corrupted { 0 };
+        uint64_t bytes_received { 0 };
+        uint64_t bytes_echoed { 0 };
+        uint64_t commands_received { 0 };
+    };
+
+    explicit McuEmulator(Options options);
+
+    McuEmulator():
+        McuEmulator(Options {}) {}
+
+    ~McuEmulator();
+
+    McuEmulator(const McuEmulator&) = delete;
+    McuEmulator& operator=(const McuEmulator&) = delete;
+
+    /**
+     * @brief 打开pty并启动收发线程
+     * @return false 打开失败，原因见error_message()
+     */
+    [[nodiscard]] bool start();
+
+    /**
+     * @brief 停止收发线程并关闭pty，对上位机而言等同于拔掉串口
+     */
+    void stop();
+
+    [[nodiscard]] bool is_running() const noexcept {
+        return _running.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief pty从端路径，如"/dev/pts/3"，start()成功后有效
+     */
+    [[nodiscard]] std::string slave_path() const {
+        std::lock_guard<std::mutex> lock(_state_mut);
+        return _slave_path;
+    }
+
+    [[nodiscard]] std::string error_message() const {
+        std::lock_guard<std::mutex> lock(_state_mut);
+        return _error_message;
+    }
+
+    /**
+     * @brief 设置收到云台指令时的回调，在模拟器接收线程中调用
+     * 请在start()之前设置
+     */
+    void set_command_callback(CommandCallback callback) {
+        _command_callback = std::move(callback);
+    }
+
+    /**
+     * @brief 运行中修改故障注入参数
+     */
+    void set_fault_probability(double loss, double drop, double corrupt) noexcept {
+        _loss_probability.store(loss, std::memory_order_relaxed);
+        _drop_probability.store(drop, std::memory_order_relaxed);
+        _corrupt_probability.store(corrupt, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] Stats stats() const noexcept;
+
+private:
+    void stream_loop();
+
+    void receive_loop();
+
+    void handle_command(const uint8_t* buffer);
+
+    /**
+     * @brief 向主端写入，发送线程与回传共用，保证单个包不被拆开
+     * @return false 缓冲区已满，数据被丢弃
+     */
+    bool write_master(const uint8_t* buffer, std::size_t len);
+
+    [[nodiscard]] GimbalAttitude current_attitude(std::chrono::steady_clock::time_point now) const noexcept;
+
+    Options _options;
+    CommandCallback _command_callback;
+
+    mutable std::mutex _state_mut;
+    std::string _slave_path;
+    std::string _error_message;
+
+    int _master_fd { -1 };
+    int _slave_fd { -1 };
+    std::mutex _write_mut;
+
+    std::atomic<bool> _running { false };
+    std::thread _stream_thread;
+    std::thread _receive_thread;
+    std::chrono::steady_clock::time_point _start_time;
+    std::mt19937 _rng;
+
+    std::atomic<double> _loss_probability;
+    std::atomic<double> _drop_probability;
+    std::atomic<double> _corrupt_probability;
+
+    // 最近一次指令，收到前使用Options中的初始姿态
+    std::atomic<bool> _has_command { false };
+    std::atomic<float> _command_yaw { 0.0f };
+    std::atomic<float> _command_pitch { 0.0f };
+
+    std::atomic<uint64_t> _packets_sent { 0 };
+    std::atomic<uint64_t> _packets_lost { 0 };
+    std::atomic<uint64_t> _bytes_dropped { 0 };
+    std::atomic<uint64_t> _bytes_corrupted { 0 };
+    std::atomic<uint64_t> _bytes_received { 0 };
+    std::atomic<uint64_t> _bytes_echoed { 0 };
+    std::atomic<uint64_t> _commands_received { 0 };
+};
+
+} // namespace serial::sim
+#endif //MCU_EMULATOR_HPP
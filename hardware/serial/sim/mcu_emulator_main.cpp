@@ -0,0 +1,65 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// 独立运行的下位机模拟器，参数来自hardware.toml中的[Serial.sim]
+// 启动后将主程序的Serial.port_name指向打印出的pty路径(或link_path)即可
+
+// C system headers
+#include <csignal>
+
+// C++ system headers
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+// Third-party library headers
+#include <fmt/color.h>
+#include <fmt/core.h>
+
+// Project headers
+#include "mcu_emulator.hpp"
+#include "plugin/debug/logger.hpp"
+#include "plugin/param/static_config.hpp"
+#include "sim_config.hpp"
+
+namespace {
+    std::atomic<bool> g_running { true };
+
+    void on_signal(int) {
+        g_running = false;
+    }
+} // namespace
+
+int main() {
+    const auto file = static_param::open_file("hardware.toml");
+    const auto &param = file->table();
+
+    config_schema::ConfigErrors errors;
+    const auto sim = serial::sim::SimConfig::load(param, errors);
+    const auto data = serial::sim::SerialDataConfig::load(param, errors);
+    config_schema::report("hardware.toml", errors);
+
+    const auto options = serial::sim::make_options(sim, data);
+
+    serial::sim::McuEmulator emulator(options);
+    if (!emulator.start()) {
+        debug::print(debug::PrintMode::ERROR, "McuEmulator", "Failed to start: {}", emulator.error_message());
+        return 1;
+    }
+    fmt::print(fmt::fg(fmt::color::gold), "======================MCU emulator on {}======================\n",
+               options.link_path.empty() ? emulator.slave_path() : options.link_path);
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    while (g_running) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        const auto stats = emulator.stats();
+        fmt::print("sent {} lost {} dropped {}B corrupted {}B | recv {}B echoed {}B commands {}\n",
+                   stats.packets_sent, stats.packets_lost, stats.bytes_dropped, stats.bytes_corrupted,
+                   stats.bytes_received, stats.bytes_echoed, stats.commands_received);
+    }
+    emulator.stop();
+    return 0;
+}
@@ -0,0 +1,62 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef SIM_CONFIG_HPP
+#define SIM_CONFIG_HPP
+
+// C system headers
+
+// C++ system headers
+#include <string>
+
+// Third-party library headers
+
+// Project headers
+#include "mcu_emulator.hpp"
+#include "plugin/param/config_schema.hpp"
+
+namespace serial::sim {
+
+// hardware.toml 中的 [Serial.sim]，默认值与 McuEmulator::Options 一致
+#define RMCV_SERIAL_SIM_FIELDS(FIELD)                                                  \
+    FIELD(double, rate_hz, 1000.0, ::config_schema::range(0.0, 100000.0))              \
+    FIELD(int64_t, jitter_us, 0, ::config_schema::range<int64_t>(0, 1000000))          \
+    FIELD(double, loss_probability, 0.0, ::config_schema::range(0.0, 1.0))             \
+    FIELD(double, drop_probability, 0.0, ::config_schema::range(0.0, 1.0))             \
+    FIELD(double, corrupt_probability, 0.0, ::config_schema::range(0.0, 1.0))          \
+    FIELD(bool, echo, false, ::config_schema::any)                                     \
+    FIELD(bool, log_commands, true, ::config_schema::any)                              \
+    FIELD(double, sweep_amplitude_deg, 0.0, ::config_schema::range(0.0, 180.0))        \
+    FIELD(double, sweep_period_s, 2.0, ::config_schema::range(0.001, 3600.0))          \
+    FIELD(std::string, link_path, "", ::config_schema::any)
+
+RMCV_CONFIG_STRUCT(SimConfig, "Serial.sim", RMCV_SERIAL_SIM_FIELDS)
+
+// [Serial.data]，模拟器的初始yaw取自这里
+#define RMCV_SERIAL_DATA_FIELDS(FIELD)                                                 \
+    FIELD(int64_t, yaw_deg, 0, ::config_schema::range<int64_t>(-180, 180))
+
+RMCV_CONFIG_STRUCT(SerialDataConfig, "Serial.data", RMCV_SERIAL_DATA_FIELDS)
+
+/**
+ * @brief 由 [Serial.sim] 和 [Serial.data] 生成模拟器参数，独立的 mcu_emulator 与进程内的 SimProtocol 共用
+ */
+inline McuEmulator::Options make_options(const SimConfig &sim, const SerialDataConfig &data) {
+    McuEmulator::Options options;
+    options.rate_hz = sim.rate_hz;
+    options.jitter = std::chrono::microseconds(sim.jitter_us);
+    options.loss_probability = sim.loss_probability;
+    options.drop_probability = sim.drop_probability;
+    options.corrupt_probability = sim.corrupt_probability;
+    options.echo = sim.echo;
+    options.log_commands = sim.log_commands;
+    options.sweep_amplitude_deg = sim.sweep_amplitude_deg;
+    options.sweep_period_s = sim.sweep_period_s;
+    options.link_path = sim.link_path;
+    options.yaw_deg = static_cast<double>(data.yaw_deg);
+    return options;
+}
+
+} // namespace serial::sim
+#endif //SIM_CONFIG_HPP
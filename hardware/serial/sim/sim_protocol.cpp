@@ -0,0 +1,88 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// Source file corresponding header
+#include "sim_protocol.hpp"
+
+// C system headers
+
+// C++ system headers
+#include <utility>
+
+// Third-party library headers
+
+// Project headers
+
+SimProtocol::~SimProtocol() {
+    close();
+    _emulator->stop();
+}
+
+void SimProtocol::set_error(std::string message) {
+    std::lock_guard<std::mutex> lock(_error_mut);
+    _error_message = std::move(message);
+}
+
+bool SimProtocol::open() {
+    if (is_open()) {
+        return true;
+    }
+    if (!_emulator->is_running()) {
+        // 上一对pty已关闭(模拟拔线)，旧的从端句柄不再可用
+        _uart.reset();
+        if (!_emulator->start()) {
+            set_error(_emulator->error_message());
+            return false;
+        }
+    }
+    if (!_uart) {
+        // pty不区分波特率
+        _uart = std::make_unique<UartProtocol>(_emulator->slave_path());
+    }
+    if (!_uart->open()) {
+        set_error(_uart->error_message());
+        return false;
+    }
+    return true;
+}
+
+void SimProtocol::close() noexcept {
+    if (_uart) {
+        _uart->close();
+    }
+}
+
+void SimProtocol::interrupt() noexcept {
+    if (_uart) {
+        _uart->interrupt();
+    }
+}
+
+bool SimProtocol::is_open() const noexcept {
+    return _uart && _uart->is_open();
+}
+
+int SimProtocol::read(std::byte* buffer, std::size_t len) {
+    if (!is_open()) {
+        set_error("sim protocol is not open");
+        return -1;
+    }
+    const int ret = _uart->read(buffer, len);
+    if (ret <= 0) {
+        set_error(_uart->error_message());
+    }
+    return ret;
+}
+
+int SimProtocol::write(const std::byte* buffer, std::size_t len) {
+    if (!is_open()) {
+        set_error("sim protocol is not open");
+        return -1;
+    }
+    const int ret = _uart->write(buffer, len);
+    if (ret < 0) {
+        set_error(_uart->error_message());
+    }
+    return ret;
+}
@@ -0,0 +1,64 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef SIM_PROTOCOL_HPP
+#define SIM_PROTOCOL_HPP
+
+// C system headers
+
+// C++ system headers
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Third-party library headers
+
+// Project headers
+#include "../protocol/protocol_interface.hpp"
+#include "../protocol/uart_protocol.hpp"
+#include "mcu_emulator.hpp"
+
+/**
+ * @brief 接入进程内下位机模拟器的传输接口
+ * open()时启动模拟器并以UartProtocol打开pty从端，收发路径与真实串口完全相同；
+ * 调用emulator()->stop()可模拟拔线，之后的open()会重新建立一对pty。
+ */
+class SimProtocol: public ProtocolInterface {
+public:
+    explicit SimProtocol(serial::sim::McuEmulator::Options options):
+        _emulator(std::make_shared<serial::sim::McuEmulator>(std::move(options))) {}
+
+    SimProtocol():
+        SimProtocol(serial::sim::McuEmulator::Options {}) {}
+
+    ~SimProtocol() override;
+
+    [[nodiscard]] bool open() override;
+    void close() noexcept override;
+    [[nodiscard]] bool is_open() const noexcept override;
+    void interrupt() noexcept override;
+
+    [[nodiscard]] int read(std::byte* buffer, std::size_t len) override;
+    [[nodiscard]] int write(const std::byte* buffer, std::size_t len) override;
+
+    [[nodiscard]] std::string error_message() const override {
+        std::lock_guard<std::mutex> lock(_error_mut);
+        return _error_message;
+    }
+
+    [[nodiscard]] const serial::sim::McuEmulator::SharedPtr& emulator() const noexcept {
+        return _emulator;
+    }
+
+private:
+    void set_error(std::string message);
+
+    serial::sim::McuEmulator::SharedPtr _emulator;
+    std::unique_ptr<UartProtocol> _uart;
+    // 读写线程与LinkSupervisor都会写入错误信息
+    mutable std::mutex _error_mut;
+    std::string _error_message;
+};
+
+#endif //SIM_PROTOCOL_HPP
@@ -6,22 +6,29 @@
 #define TRANSCEIVER_MANAGER_HPP
 
 // C++ system headers
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <optional>
-#include <queue>
 #include <stdexcept>
 #include <thread>
 
 // Third-party library headers
 
 // Project headers
+#include "bounded_queue.hpp"
 #include "fixed_packet.hpp"
+#include "link_supervisor.hpp"
 #include "protocol/protocol_interface.hpp"
 #include "plugin/debug/logger.hpp"
+#include "plugin/debug/metrics.hpp"
+#include "plugin/debug/profile.hpp"
+#include "plugin/debug/trace.hpp"
 
 namespace serial {
 
@@ -30,12 +37,20 @@ class TransceiverManager {
 public:
     using SharedPtr = std::shared_ptr<TransceiverManager>;
     using PacketType = FixedPacket<Capacity>;
+    using Clock = std::chrono::steady_clock;
+    // 实时接收线程每收到一个合法包调用一次，参数为数据包与接收时间
+    using PacketCallback = std::function<void(const PacketType&, Clock::time_point)>;
     enum class SendMode {
         FIFO,           // 先进先出，保留所有包
         LATEST_ONLY,    // 只保留最新的包
         LIMITED_FIFO    // 限制队列大小的FIFO
     };
 
+    // 实时发送队列容量，FIFO模式下队列满时send_packet返回false
+    constexpr static std::size_t REALTIME_QUEUE_CAPACITY = 1024;
+    // 写线程单次write()最多合并的包数
+    constexpr static std::size_t MAX_SEND_BATCH = 32;
+
     TransceiverManager() = delete;
 
     /**
@@ -43,23 +58,23 @@ public:
      * @param transporter transport interface
      * @param mode 发送模式，默认为FIFO
      * @param max_queue_size 当mode为LIMITED_FIFO时，队列的最大大小
+     * @param link_options 断线重连参数，重连由LinkSupervisor的后台线程完成
      * @throws std::invalid_argument if transporter is nullptr
      */
     explicit TransceiverManager(
         std::shared_ptr<ProtocolInterface> transporter,
         SendMode mode = SendMode::FIFO,
-        std::size_t max_queue_size = 100)
-        : _transporter(std::move(transporter)),
+        std::size_t max_queue_size = 100,
+        LinkSupervisor::Options link_options = LinkSupervisor::Options {})
+        : _link(std::make_shared<LinkSupervisor>(std::move(transporter), link_options)),
           _recv_buf_len(0),
+          _realtime_packets(REALTIME_QUEUE_CAPACITY),
           _send_mode(mode),
-          _max_queue_size(max_queue_size) {
-        if (!_transporter) {
-            throw std::invalid_argument("transporter is nullptr");
-        }
-
+          _max_queue_size(clamp_queue_size(max_queue_size)) {
         // 初始化缓冲区
         _tmp_buffer.fill(0);
         _recv_buffer.fill(0);
+        _send_batch.fill(0);
     }
 
     /**
@@ -76,7 +91,21 @@ public:
      * @return true 已打开，false 未打开
      */
     [[nodiscard]] bool is_open() const noexcept {
-        return _transporter->is_open();
+        return _link->is_up();
+    }
+
+    /**
+     * @brief 获取链路状态
+     */
+    [[nodiscard]] LinkState link_state() const noexcept {
+        return _link->state();
+    }
+
+    /**
+     * @brief 获取链路健康统计
+     */
+    [[nodiscard]] LinkStats link_stats() const noexcept {
+        return _link->stats();
     }
 
     /**
@@ -109,27 +138,9 @@ public:
      * @param max_queue_size 当mode为LIMITED_FIFO时，队列的最大大小
      */
     void set_send_mode(SendMode mode, std::size_t max_queue_size = 100) {
-        std::lock_guard<std::mutex> lock(_realtime_send_mut);
-        _send_mode = mode;
-        _max_queue_size = max_queue_size;
-
-        // 如果切换到只保留最新的模式，清空当前队列
-        if (mode == SendMode::LATEST_ONLY && !_realtime_packets.empty()) {
-            // 保留最后一个包
-            PacketType last_packet = std::move(_realtime_packets.back());
-            while (!_realtime_packets.empty()) {
-                _realtime_packets.pop();
-            }
-            _realtime_packets.push(std::move(last_packet));
-        }
-
-        // 如果切换到有限大小模式，确保队列不超过限制
-        if (mode == SendMode::LIMITED_FIFO && _realtime_packets.size() > _max_queue_size) {
-            // 删除旧的包，直到队列大小符合要求
-            while (_realtime_packets.size() > _max_queue_size) {
-                _realtime_packets.pop();
-            }
-        }
+        // 队列中已有的包由写线程在下一次取包时按新模式裁剪
+        _max_queue_size.store(clamp_queue_size(max_queue_size), std::memory_order_relaxed);
+        _send_mode.store(mode, std::memory_order_release);
     }
 
     /**
@@ -146,6 +157,23 @@ public:
      */
     [[nodiscard]] std::optional<PacketType> get_latest_packet();
 
+    /**
+     * @brief 获取最新数据包的接收时间
+     *
+     * @return std::optional<Clock::time_point> 尚未收到数据包时返回空
+     */
+    [[nodiscard]] std::optional<Clock::time_point> get_latest_stamp();
+
+    /**
+     * @brief 设置收包回调，例如解码姿态并写入AttitudeHistory
+     * 回调在实时接收线程中执行，请在enable_realtime_read之前设置
+     *
+     * @param callback 收包回调
+     */
+    void set_packet_callback(PacketCallback callback) {
+        _packet_callback = std::move(callback);
+    }
+
 
 private:
     /**
@@ -166,8 +194,34 @@ private:
     //[[nodiscard]] 
     bool simple_send_packet(const PacketType& packet);
 
+    /**
+     * @brief 一次write()发送连续的多个数据包
+     *
+     * @param buffer 数据起始地址
+     * @param len 字节数，为Capacity的整数倍
+     * @return true 发送成功，false 失败
+     */
+    bool simple_send_buffer(const uint8_t* buffer, std::size_t len);
+
+    /**
+     * @brief 写线程取出待发送的包并按发送模式裁剪，合并到_send_batch中
+     *
+     * @return 本次需要发送的字节数，0表示队列为空
+     */
+    std::size_t collect_send_batch();
+
+    /**
+     * @brief 入队后唤醒休眠中的写线程
+     */
+    void wake_writer();
+
+    static std::size_t clamp_queue_size(std::size_t size) noexcept {
+        return std::min(std::max<std::size_t>(size, 1), REALTIME_QUEUE_CAPACITY);
+    }
+
 private:
-    std::shared_ptr<ProtocolInterface> _transporter;
+    // 所有读写都经过链路看护，断线时立即失败，不在收发线程中重连
+    LinkSupervisor::SharedPtr _link;
 
     // 数据缓冲区
     std::array<uint8_t, Capacity> _tmp_buffer;
@@ -176,19 +230,25 @@ private:
 
     // 实时发送相关
     std::atomic<bool> _use_realtime_send{false};
-    std::mutex _realtime_send_mut;
     std::unique_ptr<std::thread> _realtime_send_thread;
-    std::queue<PacketType> _realtime_packets;
+    BoundedQueue<PacketType> _realtime_packets;
+    std::array<uint8_t, Capacity * MAX_SEND_BATCH> _send_batch;
+    // 写线程无包可发时在条件变量上休眠，生产者仅在其休眠时才加锁唤醒
+    std::atomic<bool> _writer_parked{false};
+    std::mutex _realtime_send_mut;
+    std::condition_variable _realtime_send_cv;
 
     // 实时接收相关
     std::atomic<bool> _use_realtime_read{false};
     std::mutex _realtime_read_mut;
     std::unique_ptr<std::thread> _realtime_read_thread;
     std::optional<PacketType> _latest_packet;
+    std::optional<Clock::time_point> _latest_stamp;
+    PacketCallback _packet_callback;
 
     // 发送模式配置
-    SendMode _send_mode{SendMode::FIFO};
-    std::size_t _max_queue_size{100};
+    std::atomic<SendMode> _send_mode{SendMode::FIFO};
+    std::atomic<std::size_t> _max_queue_size{100};
 };
 
 template<std::size_t Capacity>
@@ -209,20 +269,25 @@ bool TransceiverManager<Capacity>::check_packet(const uint8_t* buffer, int recv_
 
 template<std::size_t Capacity>
 bool TransceiverManager<Capacity>::simple_send_packet(const PacketType& packet) {
+    return simple_send_buffer(packet.buffer(), Capacity);
+}
+
+template<std::size_t Capacity>
+bool TransceiverManager<Capacity>::simple_send_buffer(const uint8_t* buffer, std::size_t len) {
+    TRACE_SCOPE("serial.send");
+    PROFILE_REGION("serial.send");
     try {
         const auto bytes_written =
-            _transporter->write(reinterpret_cast<const std::byte*>(packet.buffer()), Capacity);
-        if (bytes_written == static_cast<int>(Capacity)) {
+            _link->write(reinterpret_cast<const std::byte*>(buffer), len);
+        if (bytes_written == static_cast<int>(len)) {
+            _link->report_packet_tx(len / Capacity);
             return true;
-        } else {
-            // 尝试重新连接
-            _transporter->close();
-            _transporter->open();
-            return false;
         }
+        // 链路断开，由LinkSupervisor在后台重连
+        return false;
     } catch (const std::exception& e) {
         // 处理可能的异常
-        debug::print(debug::PrintMode::ERROR, "TransceiverManager", "Error sending packet: {}", e.what());
+        RMCV_LOG_EVERY_MS(ERROR, 1000, "TransceiverManager", "Error sending packet: {}", e.what());
         return false;
     }
 }
@@ -237,71 +302,129 @@ void TransceiverManager<Capacity>::enable_realtime_send(bool enable) {
     if (enable) {
         _use_realtime_send = true;
         _realtime_send_thread = std::make_unique<std::thread>([this]() {
-            PacketType packet;
-            using namespace std::chrono_literals;
-
             while (_use_realtime_send) {
-                bool empty = true;
-                {
-                    std::lock_guard<std::mutex> lock(_realtime_send_mut);
-                    empty = _realtime_packets.empty();
-                    if (!empty) {
-                        packet = std::move(_realtime_packets.front());
-                        _realtime_packets.pop();
-                    }
+                const std::size_t len = collect_send_batch();
+                if (len > 0) {
+                    simple_send_buffer(_send_batch.data(), len);
+                    continue;
                 }
 
-                if (!empty) {
-                    simple_send_packet(packet);
-                } else {
-                    std::this_thread::sleep_for(1ms);
+                // 队列为空，休眠直到有新包入队或发送被禁用
+                _writer_parked.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (_realtime_packets.empty()) {
+                    std::unique_lock<std::mutex> lock(_realtime_send_mut);
+                    _realtime_send_cv.wait(lock, [this]() {
+                        return !_use_realtime_send || !_realtime_packets.empty();
+                    });
                 }
+                _writer_parked.store(false, std::memory_order_relaxed);
             }
         });
     } else {
-        _use_realtime_send = false;
+        {
+            std::lock_guard<std::mutex> lock(_realtime_send_mut);
+            _use_realtime_send = false;
+        }
+        _realtime_send_cv.notify_one();
         if (_realtime_send_thread && _realtime_send_thread->joinable()) {
+            // 对端不读取时写线程可能阻塞在write中
+            _link->interrupt();
             _realtime_send_thread->join();
             _realtime_send_thread.reset();
         }
     }
 }
 
+template<std::size_t Capacity>
+std::size_t TransceiverManager<Capacity>::collect_send_batch() {
+    const SendMode mode = _send_mode.load(std::memory_order_acquire);
+    PacketType packet;
+
+    if (mode == SendMode::LATEST_ONLY) {
+        // 仅发送队列中最新的包，其余直接丢弃
+        bool found = false;
+        while (_realtime_packets.try_pop(packet)) {
+            found = true;
+        }
+        if (!found) {
+            return 0;
+        }
+        std::memcpy(_send_batch.data(), packet.buffer(), Capacity);
+        return Capacity;
+    }
+
+    std::size_t count = 0;
+    while (count < MAX_SEND_BATCH && _realtime_packets.try_pop(packet)) {
+        std::memcpy(_send_batch.data() + count * Capacity, packet.buffer(), Capacity);
+        ++count;
+    }
+
+    if (mode == SendMode::LIMITED_FIFO) {
+        // 限制队列大小的FIFO，只保留最新的_max_queue_size个包
+        const std::size_t limit = _max_queue_size.load(std::memory_order_relaxed);
+        if (count > limit) {
+            std::memmove(_send_batch.data(), _send_batch.data() + (count - limit) * Capacity, limit * Capacity);
+            count = limit;
+        }
+    }
+    return count * Capacity;
+}
+
+template<std::size_t Capacity>
+void TransceiverManager<Capacity>::wake_writer() {
+    // 与写线程休眠前的屏障配对：要么写线程看到新包，要么这里看到它已休眠
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_writer_parked.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(_realtime_send_mut);
+        _realtime_send_cv.notify_one();
+    }
+}
+
 template<std::size_t Capacity>
 bool TransceiverManager<Capacity>::send_packet(const PacketType& packet) {
     if (_use_realtime_send) {
-        try {
-            std::lock_guard<std::mutex> lock(_realtime_send_mut);
-
-            switch (_send_mode) {
-                case SendMode::LATEST_ONLY:
-                    // 仅保留最新的包
-                        while (!_realtime_packets.empty()) {
-                            _realtime_packets.pop();
-                        }
-                _realtime_packets.push(packet);
+        static auto& dropped_total =
+            debug::metrics::counter("serial_send_dropped_total", "实时发送队列中被丢弃或拒绝的包数");
+        static auto& queue_depth = debug::metrics::gauge("serial_send_queue_depth", "实时发送队列中的包数");
+        PacketType dropped;
+        switch (_send_mode.load(std::memory_order_acquire)) {
+            case SendMode::LATEST_ONLY:
+                // 仅保留最新的包：写线程取包时只发送最后一个，这里只需在队列满时腾出位置
+                while (!_realtime_packets.try_push(packet)) {
+                    if (_realtime_packets.try_pop(dropped)) {
+                        dropped_total.add();
+                    }
+                }
                 break;
 
-                case SendMode::LIMITED_FIFO:
-                    // 限制队列大小的FIFO
-                        if (_realtime_packets.size() >= _max_queue_size) {
-                            // 队列已满，移除最早的包
-                            _realtime_packets.pop();
-                        }
-                _realtime_packets.push(packet);
+            case SendMode::LIMITED_FIFO: {
+                // 限制队列大小的FIFO，队列已满时移除最早的包
+                const std::size_t limit = _max_queue_size.load(std::memory_order_relaxed);
+                while (_realtime_packets.size_approx() >= limit && _realtime_packets.try_pop(dropped)) {
+                    dropped_total.add();
+                }
+                while (!_realtime_packets.try_push(packet)) {
+                    if (_realtime_packets.try_pop(dropped)) {
+                        dropped_total.add();
+                    }
+                }
                 break;
+            }
 
-                case SendMode::FIFO:
-                    default:
-                        // 默认行为：先进先出
-                        _realtime_packets.push(packet);
+            case SendMode::FIFO:
+            default:
+                // 默认行为：先进先出，队列满时拒绝新包
+                if (!_realtime_packets.try_push(packet)) {
+                    dropped_total.add();
+                    RMCV_LOG_EVERY_MS(ERROR, 1000, "TransceiverManager", "Error queuing packet: realtime queue is full");
+                    return false;
+                }
                 break;
-            }
-            return true;
-        } catch (const std::exception& e) {
-            debug::print(debug::PrintMode::ERROR, "TransceiverManager", "Error queuing packet: {}", e.what());
-            return false;
         }
+        queue_depth.set(static_cast<double>(_realtime_packets.size_approx()));
+        wake_writer();
+        return true;
     } else {
         return simple_send_packet(packet);
     }
@@ -311,16 +434,20 @@ template<std::size_t Capacity>
 bool TransceiverManager<Capacity>::recv_packet(PacketType& packet) {
     try {
         int recv_len =
-            _transporter->read(reinterpret_cast<std::byte*>(_tmp_buffer.data()), Capacity);
+            _link->read(reinterpret_cast<std::byte*>(_tmp_buffer.data()), Capacity);
         if (recv_len > 0) {
+            TRACE_SCOPE("serial.recv");
+            PROFILE_REGION("serial.recv");
             // 检查是否是完整数据包
             if (check_packet(_tmp_buffer.data(), recv_len)) {
                 packet.copy_from(_tmp_buffer.data());
+                _link->report_packet_rx();
                 return true;
             } else {
                 // 如果是断帧，拼接缓存，并遍历校验，获得合法数据
                 if (_recv_buf_len + recv_len > static_cast<int>(Capacity * 2)) {
                     _recv_buf_len = 0; // 缓冲区溢出时重置
+                    _link->report_resync();
                 }
 
                 // 拼接缓存
@@ -331,6 +458,11 @@ bool TransceiverManager<Capacity>::recv_packet(PacketType& packet) {
                 for (int i = 0; (i + Capacity) <= _recv_buf_len; i++) {
                     if (check_packet(_recv_buffer.data() + i, Capacity)) {
                         packet.copy_from(_recv_buffer.data() + i);
+                        _link->report_packet_rx();
+                        if (i > 0) {
+                            // 跳过了帧头之前的错误字节
+                            _link->report_resync();
+                        }
 
                         // 读取一帧后，更新接收缓存
                         int k = 0;
@@ -346,13 +478,11 @@ bool TransceiverManager<Capacity>::recv_packet(PacketType& packet) {
                 return false;
             }
         } else {
-            // 尝试重新连接
-            _transporter->close();
-            _transporter->open();
+            // 链路断开，由LinkSupervisor在后台重连
             return false;
         }
     } catch (const std::exception& e) {
-        debug::print(debug::PrintMode::ERROR, "TransceiverManager", "Error receiving packet: {}", e.what());
+        RMCV_LOG_EVERY_MS(ERROR, 1000, "TransceiverManager", "Error receiving packet: {}", e.what());
         return false;
     }
 }
@@ -373,8 +503,15 @@ void TransceiverManager<Capacity>::enable_realtime_read(bool enable) {
             while (_use_realtime_read) {
                 if (recv_packet(packet)) {
                     // 接收成功，更新最新的数据包
-                    std::lock_guard<std::mutex> lock(_realtime_read_mut);
-                    _latest_packet = packet;
+                    const auto stamp = Clock::now();
+                    {
+                        std::lock_guard<std::mutex> lock(_realtime_read_mut);
+                        _latest_packet = packet;
+                        _latest_stamp = stamp;
+                    }
+                    if (_packet_callback) {
+                        _packet_callback(packet, stamp);
+                    }
                 } else {
                     // 如果没有接收到数据，短暂休眠以避免CPU占用过高
                     std::this_thread::sleep_for(1ms);
@@ -384,6 +521,8 @@ void TransceiverManager<Capacity>::enable_realtime_read(bool enable) {
     } else {
         _use_realtime_read = false;
         if (_realtime_read_thread && _realtime_read_thread->joinable()) {
+            // 对端静默时读线程阻塞在read中，唤醒后它才能看到运行标志
+            _link->interrupt();
             _realtime_read_thread->join();
             _realtime_read_thread.reset();
         }
@@ -404,6 +543,12 @@ auto TransceiverManager<Capacity>::get_latest_packet()->std::optional<PacketType
     return result;
 }
 
+template<std::size_t Capacity>
+auto TransceiverManager<Capacity>::get_latest_stamp()->std::optional<Clock::time_point> {
+    std::lock_guard<std::mutex> lock(_realtime_read_mut);
+    return _latest_stamp;
+}
+
 // 常用的固定大小包工具类型别名
 using FixedPacketTool16 = TransceiverManager<16>;
 using FixedPacketTool32 = TransceiverManager<32>;
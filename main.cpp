@@ -1,39 +1,167 @@
+// C system headers
+#include <time.h>
+#include <unistd.h>
+
 // C++ system headers
 #include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <optional>
+#include <sstream>
 #include <string>
 
 // Third-party library headers
 
 // Project headers
 #include "hardware/hik_cam/hik_camera.hpp"
+#include "hardware/serial/attitude_history.hpp"
+#include "hardware/serial/gimbal_packets.hpp"
+#include "hardware/serial/protocol/uart_protocol.hpp"
+#include "hardware/serial/serial_config.hpp"
+#include "hardware/serial/sim/sim_config.hpp"
+#include "hardware/serial/sim/sim_protocol.hpp"
+#include "hardware/serial/transceiver_manager.hpp"
 #include "param/static_config.hpp"
 #include "param/runtime_parameter.hpp"
 #include "plugin/debug/logger.hpp"
+#include "plugin/debug/metrics.hpp"
+#include "plugin/debug/profile.hpp"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    // 下位机上报的 GimbalAttitude 包为32字节
+    using Serial = serial::TransceiverManager<32>;
+
+    /**
+     * @brief 进程启动至今的毫秒数，包括 main 之前的动态链接和静态初始化，精度为一个时钟节拍(通常10ms)
+     */
+    double process_uptime_ms() {
+        std::ifstream stat_file("/proc/self/stat");
+        const std::string stat((std::istreambuf_iterator<char>(stat_file)), std::istreambuf_iterator<char>());
+        // 进程名可能含空格，从最后一个 ')' 之后数起，starttime 是第22个字段
+        const auto pos = stat.rfind(')');
+        if (pos == std::string::npos) {
+            return 0.0;
+        }
+        std::istringstream fields(stat.substr(pos + 1));
+        std::string field;
+        for (int index = 3; index <= 22 && fields >> field; ++index) {
+        }
+        timespec now{};
+        clock_gettime(CLOCK_BOOTTIME, &now);
+        const double start_s = std::stod(field) / static_cast<double>(sysconf(_SC_CLK_TCK));
+        return (static_cast<double>(now.tv_sec) + static_cast<double>(now.tv_nsec) * 1e-9 - start_s) * 1e3;
+    }
+
+    /**
+     * @brief 按 [Serial] 打开串口，打不开时由 LinkSupervisor 在后台重连
+     */
+    std::unique_ptr<Serial> open_serial() {
+        const auto file = static_param::open_file("hardware.toml");
+        config_schema::ConfigErrors errors;
+        const auto config = serial::SerialConfig::load(file->table(), errors);
+        config_schema::report("Serial", errors);
+
+        std::shared_ptr<ProtocolInterface> transporter;
+        if (config.use_fake_serial_data) {
+            config_schema::ConfigErrors sim_errors;
+            const auto sim = serial::sim::SimConfig::load(file->table(), sim_errors);
+            const auto data = serial::sim::SerialDataConfig::load(file->table(), sim_errors);
+            config_schema::report("Serial.sim", sim_errors);
+            transporter = std::make_shared<SimProtocol>(serial::sim::make_options(sim, data));
+        } else {
+            auto uart = std::make_shared<UartProtocol>(config.port_name, static_cast<int>(config.baudrate));
+            if (!config.serial_number.empty()) {
+                uart->set_serial_number(config.serial_number);
+            }
+            transporter = std::move(uart);
+        }
+        if (!transporter->open()) {
+            debug::print(debug::PrintMode::WARNING, "main", "串口 {} 暂未打开: {}，后台重连", config.port_name,
+                         transporter->error_message());
+        }
+        return std::make_unique<Serial>(transporter);
+    }
+} // namespace
 
 int main() {
+    const auto main_start = Clock::now();
+    const auto since_main_ms = [main_start]() {
+        return std::chrono::duration<double, std::milli>(Clock::now() - main_start).count();
+    };
     debug::init_md_file("log.log");
+    // 完整日志写入二进制文件，赛后用 rmlog_decode 查看；文本只保留 WARNING 及以上
+    debug::binlog::open("log.rmlog");
+    // 采集、串口线程上的日志只入队，由后台线程写出
+    debug::async::start();
+    // 运行指标，本地抓取: nc -U /tmp/rmcv_metrics.sock 或 curl --unix-socket /tmp/rmcv_metrics.sock http://localhost/metrics
+    debug::metrics::serve("/tmp/rmcv_metrics.sock");
+    // 设置环境变量 RMCV_PROFILE 时统计各 PROFILE_REGION 的耗时和硬件计数，退出时输出分位数
+    if (std::getenv("RMCV_PROFILE") != nullptr) {
+        debug::profile::start();
+    }
 
-    camera::HikCam camera;
-    camera.open();
-
-    const auto param = static_param::parse_file("test.toml");
     const auto param_file_name = "test.toml";
 
     fmt::print(fmt::fg(fmt::color::gold), "======================Loading parameters======================\n");
 
     std::thread([=]() { runtime_param::parameter_run(param_file_name); }).detach();
-    runtime_param::wait_for_param("ok");
-    auto server_param = static_param::get_param<std::string>(param, "database", "server");
+    // 运行时修改 hardware.toml 中的 [Camera.config] 会直接下发到相机
+    std::thread([]() { runtime_param::parameter_run("hardware.toml"); }).detach();
+
+    // 相机、串口与参数加载同时进行
+    camera::HikCam camera;
+    auto camera_ready = std::async(std::launch::async, [&camera, &since_main_ms]() {
+        camera.open();
+        return since_main_ms();
+    });
+    auto serial_ready = std::async(std::launch::async, [&since_main_ms]() {
+        auto serial = open_serial();
+        return std::make_pair(std::move(serial), since_main_ms());
+    });
+
+    using namespace std::chrono_literals;
+    if (!runtime_param::wait_for({runtime_param::ready_name(param_file_name), runtime_param::ready_name("hardware.toml")}, 5s)) {
+        debug::print(debug::PrintMode::WARNING, "main", "参数加载超时，继续等待");
+        runtime_param::wait_for_param(runtime_param::ready_name(param_file_name));
+        runtime_param::wait_for_param(runtime_param::ready_name("hardware.toml"));
+    }
+    const double params_ms = since_main_ms();
+    // test.toml 中的 [Logger] 控制等级和节点过滤，运行时修改立即生效
+    debug::bind_runtime_params("Logger");
+
+    const auto param = static_param::open_file("test.toml");
+    auto server_param = static_param::get_param<std::string>(*param, "database.server");
 
     debug::print(
-        "info",
+        debug::PrintMode::INFO,
         "test",
         "toml:{}",
         server_param);
-    debug::print("log", "param", runtime_param::get_param<std::string>("database.server"));
+    debug::print(debug::PrintMode::LOG, "param", runtime_param::get_param<std::string>("database.server"));
+
+    const double camera_ms = camera_ready.get();
+    // 先于串口构造、后于串口析构，接收线程退出前历史始终有效
+    serial::AttitudeHistory attitude_history;
+    auto [serial, serial_ms] = serial_ready.get();
+    // 接收线程解码姿态写入历史，按图像时间戳查询时插值
+    serial->set_packet_callback([&attitude_history](const Serial::PacketType &packet, Serial::Clock::time_point stamp) {
+        attitude_history.push(stamp, serial::GimbalAttitudeLayout::decode(packet));
+    });
+    serial->enable_realtime_read(true);
+
+    const auto &frame = camera.capture();
+    debug::print(debug::PrintMode::INFO, "main",
+                 "startup: first frame {}x{} at {:.1f} ms after process start ({:.1f} ms after main), "
+                 "params {:.1f} ms, camera {:.1f} ms, serial {:.1f} ms (link {})",
+                 frame.cols, frame.rows, process_uptime_ms(), since_main_ms(), params_ms, camera_ms, serial_ms,
+                 serial->is_open() ? "up" : "down");
 
-    debug::print("info", "main", "main_start");
+    debug::print(debug::PrintMode::INFO, "main", "main_start");
     return 0;
 }
@@ -0,0 +1,320 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// Source file corresponding header
+#include "async_logger.hpp"
+
+// C system headers
+
+// C++ system headers
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Third-party library headers
+#include <fmt/color.h>
+
+// Project headers
+#include "logger.hpp"
+
+namespace debug::async {
+	namespace {
+		// 每个线程 64 KiB，约可容纳上千条普通日志
+		constexpr std::size_t RING_CAPACITY = 1 << 16;
+		constexpr auto IDLE_SLEEP = std::chrono::milliseconds(1);
+
+		/**
+		 * @brief 单生产者单消费者的字节环形缓冲区，记录变长且连续存放
+		 */
+		class Ring {
+		public:
+			explicit Ring(std::size_t capacity)
+				: _buffer(new char[capacity]), _capacity(capacity), _mask(capacity - 1) {
+			}
+
+			// 生产者线程调用
+			char *reserve(std::size_t size) {
+				const uint64_t head = _head.load(std::memory_order_relaxed);
+				const uint64_t tail = _tail.load(std::memory_order_acquire);
+				const std::size_t offset = head & _mask;
+				const std::size_t contiguous = _capacity - offset;
+				// 记录不跨越环尾，放不下时用填充记录占满剩余部分
+				const std::size_t skip = contiguous < size ? contiguous : 0;
+				if (head + skip + size - tail > _capacity) {
+					_dropped.store(_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+					return nullptr;
+				}
+				if (skip != 0) {
+					const auto skip_size = static_cast<uint32_t>(skip);
+					std::memcpy(_buffer.get() + offset, &skip_size, sizeof(skip_size));
+					_buffer[offset + offsetof(RecordHeader, flags)] = static_cast<char>(FLAG_PADDING);
+				}
+				_reserved = head + skip;
+				return _buffer.get() + (_reserved & _mask);
+			}
+
+			// 生产者线程调用
+			void commit(std::size_t size) {
+				_head.store(_reserved + size, std::memory_order_release);
+			}
+
+			// 后台线程调用，回调返回前记录内容有效
+			template<typename F>
+			void drain(F &&callback) {
+				uint64_t tail = _tail.load(std::memory_order_relaxed);
+				const uint64_t head = _head.load(std::memory_order_acquire);
+				while (tail != head) {
+					const char *record = _buffer.get() + (tail & _mask);
+					uint32_t size;
+					std::memcpy(&size, record, sizeof(size));
+					if ((static_cast<uint8_t>(record[offsetof(RecordHeader, flags)]) & FLAG_PADDING) == 0) {
+						RecordHeader header;
+						std::memcpy(&header, record, sizeof(header));
+						callback(header, record + sizeof(header));
+					}
+					tail += size;
+				}
+				_tail.store(tail, std::memory_order_release);
+			}
+
+			uint64_t dropped() const noexcept {
+				return _dropped.load(std::memory_order_relaxed);
+			}
+
+			void close() noexcept {
+				_closed.store(true, std::memory_order_release);
+			}
+
+			bool closed() const noexcept {
+				return _closed.load(std::memory_order_acquire);
+			}
+
+		private:
+			std::unique_ptr<char[]> _buffer;
+			std::size_t _capacity;
+			std::size_t _mask;
+			// 生产者和消费者的下标放在不同缓存行
+			alignas(64) std::atomic<uint64_t> _head{0};
+			uint64_t _reserved = 0;
+			std::atomic<uint64_t> _dropped{0};
+			alignas(64) std::atomic<uint64_t> _tail{0};
+			std::atomic<bool> _closed{false};
+		};
+
+		struct Line {
+			int64_t timestamp_ns;
+			PrintMode mode;
+			std::string text;
+		};
+
+		class Backend {
+		public:
+			void start() {
+				std::lock_guard<std::mutex> lock(_control_mutex);
+				if (_worker.joinable()) {
+					return;
+				}
+				_running.store(true, std::memory_order_release);
+				_worker = std::thread(&Backend::run, this);
+				_enabled.store(true, std::memory_order_release);
+			}
+
+			void stop() {
+				std::lock_guard<std::mutex> lock(_control_mutex);
+				_enabled.store(false, std::memory_order_release);
+				_running.store(false, std::memory_order_release);
+				if (_worker.joinable()) {
+					_worker.join();
+				}
+			}
+
+			bool enabled() const noexcept {
+				return _enabled.load(std::memory_order_acquire);
+			}
+
+			void add(std::shared_ptr<Ring> ring) {
+				std::lock_guard<std::mutex> lock(_rings_mutex);
+				_rings.push_back(std::move(ring));
+			}
+
+			uint64_t dropped() {
+				std::lock_guard<std::mutex> lock(_rings_mutex);
+				uint64_t total = _retired_dropped;
+				for (const auto &ring: _rings) {
+					total += ring->dropped();
+				}
+				return total;
+			}
+
+		private:
+			void run() {
+				std::vector<Line> lines;
+				while (_running.load(std::memory_order_acquire)) {
+					collect(lines);
+					if (lines.empty()) {
+						std::this_thread::sleep_for(IDLE_SLEEP);
+						continue;
+					}
+					write(lines);
+				}
+				collect(lines);
+				write(lines);
+			}
+
+			void collect(std::vector<Line> &lines) {
+				std::lock_guard<std::mutex> lock(_rings_mutex);
+				uint64_t dropped = _retired_dropped;
+				for (auto iter = _rings.begin(); iter != _rings.end();) {
+					auto &ring = *iter;
+					// 先读关闭标志再取数据，线程退出前写入的记录不会丢
+					const bool closed = ring->closed();
+					ring->drain([&](const RecordHeader &header, const char *payload) {
+						lines.push_back(decode(header, payload));
+					});
+					dropped += ring->dropped();
+					if (closed) {
+						_retired_dropped += ring->dropped();
+						iter = _rings.erase(iter);
+					} else {
+						++iter;
+					}
+				}
+				if (dropped != _reported_dropped) {
+					const auto clock = timestamp::clock();
+					const int64_t now = timestamp::now_ns(clock);
+					lines.push_back({
+						now, PrintMode::WARNING,
+						fmt::format("{} {} @logger: 日志缓冲区已满，丢弃了 {} 条日志", timestamp::to_string(now, clock),
+						            PRINT_PREFIX.at(PrintMode::WARNING), dropped - _reported_dropped)
+					});
+					_reported_dropped = dropped;
+				}
+				// 各线程的记录按时间合并
+				std::stable_sort(lines.begin(), lines.end(), [](const Line &a, const Line &b) {
+					return a.timestamp_ns < b.timestamp_ns;
+				});
+			}
+
+			static Line decode(const RecordHeader &header, const char *payload) {
+				const std::string_view node(payload, header.node_size);
+				payload += header.node_size;
+				std::string_view format;
+				if (header.format != nullptr) {
+					format = std::string_view(header.format, header.format_size);
+				} else {
+					format = std::string_view(payload, header.format_size);
+					payload += header.format_size;
+				}
+
+				std::string content;
+				if (header.decode == nullptr) {
+					content = std::string(format);
+				} else {
+					try {
+						content = header.decode(format, payload);
+					} catch (const fmt::format_error &e) {
+						content = std::string(format) + " [格式化错误: " + e.what() + "]";
+					}
+				}
+
+				const auto mode = static_cast<PrintMode>(header.level);
+				const auto clock = (header.flags & FLAG_MONOTONIC) != 0
+					                   ? timestamp::Clock::MONOTONIC
+					                   : timestamp::Clock::WALL;
+				char time_text[timestamp::MAX_SIZE];
+				const std::size_t time_size = timestamp::format(header.timestamp_ns, clock, time_text);
+				return {
+					header.timestamp_ns, mode,
+					fmt::format("{} {} {}{}: {}", std::string_view(time_text, time_size), PRINT_PREFIX.at(mode),
+					            node.empty() ? "" : "@", node, content)
+				};
+			}
+
+			void write(std::vector<Line> &lines) {
+				std::string console;
+				std::string file;
+				bool urgent = false;
+				for (const auto &line: lines) {
+					urgent = urgent || line.mode >= PrintMode::ERROR;
+					fmt::format_to(std::back_inserter(console), fmt::fg(PRINT_COLOR.at(line.mode)), "{}\n", line.text);
+					file += line.text;
+					file += '\n';
+				}
+				lines.clear();
+
+				std::fwrite(console.data(), 1, console.size(), stdout);
+				std::fflush(stdout);
+				logfile::write(file, urgent);
+			}
+
+			std::mutex _control_mutex;
+			std::thread _worker;
+			std::atomic<bool> _running{false};
+			std::atomic<bool> _enabled{false};
+
+			std::mutex _rings_mutex;
+			std::vector<std::shared_ptr<Ring> > _rings;
+			// 已退出线程的丢弃数
+			uint64_t _retired_dropped = 0;
+			uint64_t _reported_dropped = 0;
+		};
+
+		Backend &backend() {
+			// 有意不析构，退出时仍在运行的线程可以安全地访问
+			static auto *instance = new Backend();
+			return *instance;
+		}
+
+		/**
+		 * @brief 线程退出时标记缓冲区关闭，由后台线程写完剩余记录后回收
+		 */
+		struct ThreadRing {
+			std::shared_ptr<Ring> ring;
+
+			~ThreadRing() {
+				if (ring != nullptr) {
+					ring->close();
+				}
+			}
+		};
+
+		thread_local ThreadRing thread_ring;
+	} // namespace
+
+	bool enabled() noexcept {
+		return backend().enabled();
+	}
+
+	void start() {
+		backend().start();
+		static const bool registered = (std::atexit(stop), true);
+		(void) registered;
+	}
+
+	void stop() {
+		backend().stop();
+	}
+
+	uint64_t dropped() {
+		return backend().dropped();
+	}
+
+	char *reserve(std::size_t size) {
+		if (thread_ring.ring == nullptr) {
+			thread_ring.ring = std::make_shared<Ring>(RING_CAPACITY);
+			backend().add(thread_ring.ring);
+		}
+		return thread_ring.ring->reserve(size);
+	}
+
+	void commit(std::size_t size) {
+		thread_ring.ring->commit(size);
+	}
+} // namespace debug::async
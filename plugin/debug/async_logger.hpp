@@ -0,0 +1,219 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef PLUGIN_DEBUG_ASYNC_LOGGER_HPP
+#define PLUGIN_DEBUG_ASYNC_LOGGER_HPP
+
+// C system headers
+
+// C++ system headers
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+// Third-party library headers
+#include <fmt/core.h>
+
+// Project headers
+#include "plugin/debug/timestamp.hpp"
+
+/**
+ * 异步日志后端
+ *
+ * 开启后，debug::print 只在调用线程上把时间戳、等级、节点名、格式串和参数原样拷进本线程的无锁环形缓冲区，
+ * 由后台线程统一格式化、着色、批量写入终端和日志文件。缓冲区满时直接丢弃并计数，不会阻塞调用线程。
+ *
+ * 可以直接序列化的参数为算术类型和字符串，其余类型(Eigen 矩阵、自定义 formatter 等)在调用线程上先格式化成字符串。
+ */
+namespace debug::async {
+	/**
+	 * @brief 由后台线程调用，把参数区还原后按格式串格式化
+	 * @param format 格式串
+	 * @param args 参数区起始地址
+	 */
+	using DecodeFn = std::string (*)(std::string_view format, const char *args);
+
+	struct RecordHeader {
+		// 包含头部在内的记录长度，8 字节对齐
+		uint32_t size;
+		uint8_t flags;
+		uint8_t level;
+		uint16_t node_size;
+		uint32_t format_size;
+		// flags 含 FLAG_MONOTONIC 时为 CLOCK_MONOTONIC，否则为 CLOCK_REALTIME
+		int64_t timestamp_ns;
+		// 为空表示 format 原样输出
+		DecodeFn decode;
+		// 编译期格式串直接存指针，否则为空，格式串紧跟在节点名之后
+		const char *format;
+	};
+
+	// 环尾放不下一条记录时写入的填充记录
+	constexpr uint8_t FLAG_PADDING = 1;
+	// 记录以单调时钟打时间戳
+	constexpr uint8_t FLAG_MONOTONIC = 2;
+
+	constexpr std::size_t align_record(std::size_t size) {
+		return (size + 7) & ~static_cast<std::size_t>(7);
+	}
+
+	template<typename T>
+	using stored_t = std::decay_t<T>;
+
+	template<typename T>
+	inline constexpr bool is_string_v =
+			std::is_same_v<stored_t<T>, std::string> || std::is_same_v<stored_t<T>, std::string_view>
+			|| std::is_same_v<stored_t<T>, const char *> || std::is_same_v<stored_t<T>, char *>;
+
+	template<typename T>
+	inline constexpr bool is_serializable_v = std::is_arithmetic_v<stored_t<T> > || is_string_v<T>;
+
+	namespace detail {
+		template<typename T>
+		std::string_view as_view(const T &value) {
+			if constexpr (std::is_array_v<T>) {
+				return std::string_view(value);
+			} else if constexpr (std::is_pointer_v<T>) {
+				return value == nullptr ? std::string_view{} : std::string_view(value);
+			} else {
+				return std::string_view(value);
+			}
+		}
+
+		template<typename T>
+		std::size_t arg_size(const T &value) {
+			if constexpr (std::is_arithmetic_v<stored_t<T> >) {
+				return sizeof(stored_t<T>);
+			} else {
+				return sizeof(uint32_t) + as_view(value).size();
+			}
+		}
+
+		template<typename T>
+		void write_arg(char *&cursor, const T &value) {
+			if constexpr (std::is_arithmetic_v<stored_t<T> >) {
+				const stored_t<T> copy = value;
+				std::memcpy(cursor, &copy, sizeof(copy));
+				cursor += sizeof(copy);
+			} else {
+				const std::string_view view = as_view(value);
+				const auto size = static_cast<uint32_t>(view.size());
+				std::memcpy(cursor, &size, sizeof(size));
+				std::memcpy(cursor + sizeof(size), view.data(), size);
+				cursor += sizeof(size) + size;
+			}
+		}
+
+		template<typename T>
+		using decoded_t = std::conditional_t<std::is_arithmetic_v<stored_t<T> >, stored_t<T>, std::string_view>;
+
+		template<typename T>
+		decoded_t<T> read_arg(const char *&cursor) {
+			if constexpr (std::is_arithmetic_v<stored_t<T> >) {
+				stored_t<T> value;
+				std::memcpy(&value, cursor, sizeof(value));
+				cursor += sizeof(value);
+				return value;
+			} else {
+				uint32_t size;
+				std::memcpy(&size, cursor, sizeof(size));
+				const std::string_view view(cursor + sizeof(size), size);
+				cursor += sizeof(size) + size;
+				return view;
+			}
+		}
+
+		template<typename... Args>
+		std::string decode(std::string_view format, const char *args) {
+			// 花括号初始化保证按从左到右的顺序读取
+			const std::tuple<decoded_t<Args>...> values{read_arg<Args>(args)...};
+			return std::apply([&](const auto &... value) {
+				return fmt::format(fmt::runtime(format), value...);
+			}, values);
+		}
+	} // namespace detail
+
+	/**
+	 * @brief 异步模式是否开启
+	 */
+	bool enabled() noexcept;
+
+	/**
+	 * @brief 启动后台线程，之后的 debug::print 走异步路径；进程退出时自动 stop()
+	 */
+	void start();
+
+	/**
+	 * @brief 写完已入队的日志后停止后台线程，之后的 debug::print 恢复同步输出
+	 */
+	void stop();
+
+	/**
+	 * @brief 因缓冲区满而丢弃的日志总数
+	 */
+	uint64_t dropped();
+
+	/**
+	 * @brief 在本线程的缓冲区中预留 size 字节，首次调用时创建并登记缓冲区
+	 * @return 缓冲区已满时返回 nullptr 并计入丢弃数
+	 */
+	char *reserve(std::size_t size);
+
+	/**
+	 * @brief 提交 reserve 得到的记录，后台线程随后可见
+	 */
+	void commit(std::size_t size);
+
+	/**
+	 * @brief 把一条日志写入本线程的缓冲区
+	 * @param literal format 为编译期格式串时只存指针，否则拷贝内容
+	 * @return false 缓冲区已满，日志被丢弃
+	 */
+	template<typename... Args>
+	bool push(uint8_t level, std::string_view node, std::string_view format, bool literal, const Args &... args) {
+		static_assert((is_serializable_v<Args> && ...), "format non-serializable arguments before push()");
+		const auto clock = timestamp::clock();
+		const int64_t timestamp_ns = timestamp::now_ns(clock);
+		if (node.size() > UINT16_MAX) {
+			node = node.substr(0, UINT16_MAX);
+		}
+		const std::size_t size = align_record(
+			sizeof(RecordHeader) + node.size() + (literal ? 0 : format.size()) + (detail::arg_size(args) + ... + 0));
+		char *buffer = reserve(size);
+		if (buffer == nullptr) {
+			return false;
+		}
+
+		RecordHeader header{};
+		header.size = static_cast<uint32_t>(size);
+		header.flags = clock == timestamp::Clock::MONOTONIC ? FLAG_MONOTONIC : 0;
+		header.level = level;
+		header.node_size = static_cast<uint16_t>(node.size());
+		header.format_size = static_cast<uint32_t>(format.size());
+		header.timestamp_ns = timestamp_ns;
+		// 运行期传入且没有参数的 format 按原文输出，与同步模式一致
+		if (sizeof...(Args) > 0 || literal) {
+			header.decode = &detail::decode<Args...>;
+		}
+		header.format = literal ? format.data() : nullptr;
+		std::memcpy(buffer, &header, sizeof(header));
+
+		char *cursor = buffer + sizeof(header);
+		std::memcpy(cursor, node.data(), node.size());
+		cursor += node.size();
+		if (!literal) {
+			std::memcpy(cursor, format.data(), format.size());
+			cursor += format.size();
+		}
+		(detail::write_arg(cursor, args), ...);
+		commit(size);
+		return true;
+	}
+} // namespace debug::async
+
+#endif //PLUGIN_DEBUG_ASYNC_LOGGER_HPP
@@ -0,0 +1,413 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// Source file corresponding header
+#include "binary_log.hpp"
+
+// C system headers
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// C++ system headers
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Third-party library headers
+#include <fmt/chrono.h>
+
+// Project headers
+#include "plugin/debug/log_file.hpp"
+#include "plugin/debug/node_filter.hpp"
+
+namespace debug::binlog {
+	namespace detail {
+		/**
+		 * @brief 一个映射好的日志文件，换文件后旧的保持映射，等 writers 归零后再解除
+		 * 结构体本身从不释放而是复用，迟到的写线程对 writers 的加减始终落在有效内存上
+		 */
+		struct Segment {
+			char *base = nullptr;
+			std::size_t capacity = 0;
+			std::atomic<uint64_t> cursor{0};
+			// 已 reserve 尚未 commit 的写线程数
+			std::atomic<uint32_t> writers{0};
+			std::string path;
+		};
+	} // namespace detail
+
+	namespace {
+		using detail::Segment;
+
+		struct State {
+			std::mutex mutex;
+			std::atomic<bool> enabled{false};
+			bool opened = false;
+			// 正在写入的文件，写满时由第一个预留失败的线程换成下一个
+			std::atomic<Segment *> segment{nullptr};
+			std::string path;
+			// 换下后仍在映射中的文件，以及已解除映射、等待复用的结构体
+			std::vector<Segment *> retired;
+			std::vector<Segment *> spare;
+			std::atomic<uint64_t> dropped{0};
+			// 后续文件命名为 "<prefix>.<序号><extension>"
+			std::string prefix;
+			std::string extension;
+			uint32_t sequence = 0;
+			// 节点名、格式串索引；entries 保存已登记的全部条目，换文件时写入新的索引，使每个文件都能单独解码
+			std::FILE *index = nullptr;
+			std::vector<std::string> entries;
+			std::unordered_map<std::string, uint16_t> nodes;
+			// 按 node_filter 的编号缓存节点编号(加 1，0 表示尚未登记)，write_text 查找时不加锁
+			std::array<std::atomic<uint16_t>, node_filter::MAX_NODES> node_cache{};
+			uint32_t next_format = TEXT_FORMAT_ID + 1;
+		};
+
+		State &state() {
+			// 有意不析构，退出时仍在运行的线程可以安全地访问
+			static auto *instance = new State();
+			return *instance;
+		}
+
+		int64_t monotonic_ns() {
+			timespec ts{};
+			clock_gettime(CLOCK_MONOTONIC, &ts);
+			return static_cast<int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+		}
+
+		uint32_t thread_id() {
+			thread_local const auto tid = static_cast<uint32_t>(::syscall(SYS_gettid));
+			return tid;
+		}
+
+		/**
+		 * @brief 索引文件每行一项，反斜杠和换行转义
+		 */
+		void write_entry(State &s, const char *kind, uint32_t id, const char *signature, std::string_view text) {
+			std::string escaped;
+			escaped.reserve(text.size());
+			for (const char ch: text) {
+				if (ch == '\\') {
+					escaped += "\\\\";
+				} else if (ch == '\n') {
+					escaped += "\\n";
+				} else {
+					escaped += ch;
+				}
+			}
+			s.entries.push_back(fmt::format("{} {} {} {}\n", kind, id, signature, escaped));
+			if (s.index != nullptr) {
+				std::fputs(s.entries.back().c_str(), s.index);
+				std::fflush(s.index);
+			}
+		}
+
+		uint16_t intern_node(State &s, std::string_view node) {
+			const auto iter = s.nodes.find(std::string(node));
+			if (iter != s.nodes.end()) {
+				return iter->second;
+			}
+			const auto id = static_cast<uint16_t>(s.nodes.size());
+			s.nodes.emplace(std::string(node), id);
+			write_entry(s, "node", id, "-", node);
+			return id;
+		}
+
+		/**
+		 * @brief 创建并映射 path 及其索引文件，写入文件头和已登记的全部索引条目
+		 * @return 失败时返回 nullptr，已打印原因
+		 */
+		Segment *create_segment(State &s, const std::string &path, std::size_t capacity) {
+			const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+			if (fd < 0 || ::ftruncate(fd, static_cast<off_t>(capacity)) != 0) {
+				std::perror(("binlog: " + path).c_str());
+				if (fd >= 0) {
+					::close(fd);
+				}
+				return nullptr;
+			}
+			// 预先建立页表，避免热路径上的缺页
+			void *base = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+			// 映射不依赖 fd
+			::close(fd);
+			if (base == MAP_FAILED) {
+				std::perror(("binlog: mmap " + path).c_str());
+				return nullptr;
+			}
+			std::FILE *index = std::fopen((path + INDEX_EXTENSION).c_str(), "w");
+			if (index == nullptr) {
+				std::perror(("binlog: " + path + INDEX_EXTENSION).c_str());
+				::munmap(base, capacity);
+				return nullptr;
+			}
+			if (s.index != nullptr) {
+				std::fclose(s.index);
+			}
+			s.index = index;
+			for (const auto &entry: s.entries) {
+				std::fputs(entry.c_str(), s.index);
+			}
+			std::fflush(s.index);
+
+			FileHeader header{};
+			std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+			header.version = VERSION;
+			header.header_size = sizeof(FileHeader);
+			header.capacity = capacity;
+			header.start_wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::system_clock::now().time_since_epoch()).count();
+			header.start_monotonic_ns = monotonic_ns();
+			std::memcpy(base, &header, sizeof(header));
+
+			Segment *segment = nullptr;
+			if (s.spare.empty()) {
+				segment = new Segment();
+			} else {
+				segment = s.spare.back();
+				s.spare.pop_back();
+			}
+			segment->base = static_cast<char *>(base);
+			segment->capacity = capacity;
+			segment->path = path;
+			segment->cursor.store(sizeof(FileHeader), std::memory_order_relaxed);
+			return segment;
+		}
+
+		/**
+		 * @brief 解除已经没有写线程的旧文件的映射
+		 * 写线程先加 writers 再确认文件仍是当前文件，这里先换下文件再读 writers，两边都用 seq_cst，
+		 * 读到 0 之后再来的线程一定会发现文件已换下而放弃
+		 */
+		void release_retired(State &s) {
+			auto iter = s.retired.begin();
+			while (iter != s.retired.end()) {
+				Segment *segment = *iter;
+				if (segment->writers.load(std::memory_order_seq_cst) != 0) {
+					++iter;
+					continue;
+				}
+				::munmap(segment->base, segment->capacity);
+				segment->base = nullptr;
+				segment->path.clear();
+				s.spare.push_back(segment);
+				iter = s.retired.erase(iter);
+			}
+		}
+
+		/**
+		 * @brief 写入最终长度和丢弃数并同步到磁盘
+		 * 仍在写入的线程可能持有映射内的指针，因此这里不解除映射也不截断；文件是稀疏的，未写到的部分不占磁盘
+		 */
+		void finish_segment(State &s, Segment &segment) {
+			auto *header = reinterpret_cast<FileHeader *>(segment.base);
+			header->used = std::min<uint64_t>(segment.cursor.load(std::memory_order_acquire), segment.capacity);
+			header->dropped = s.dropped.load(std::memory_order_relaxed);
+			::msync(segment.base, segment.capacity, MS_SYNC);
+		}
+
+		/**
+		 * @brief 把写满的 full 换成下一个文件，其他线程已经换过时直接返回
+		 * @return false 新文件创建失败，二进制日志就此关闭，之后的日志走文本输出
+		 */
+		bool roll_over(State &s, Segment *full) {
+			std::lock_guard<std::mutex> lock(s.mutex);
+			if (!s.enabled.load(std::memory_order_acquire)) {
+				return false;
+			}
+			if (s.segment.load(std::memory_order_acquire) != full) {
+				return true;
+			}
+			finish_segment(s, *full);
+			const std::string path = fmt::format("{}.{}{}", s.prefix, ++s.sequence, s.extension);
+			Segment *next = create_segment(s, path, full->capacity);
+			if (next == nullptr) {
+				std::fprintf(stderr, "binlog: 无法换到新文件，之后的日志改为文本输出\n");
+				std::fclose(s.index);
+				s.index = nullptr;
+				s.enabled.store(false, std::memory_order_release);
+				return false;
+			}
+			s.segment.store(next, std::memory_order_seq_cst);
+			s.path = path;
+			s.retired.push_back(full);
+			release_retired(s);
+			// 换文件后按磁盘预算清理旧文件
+			logfile::request_garbage_collection();
+			return true;
+		}
+
+		/**
+		 * @brief 节点名对应的编号，已缓存时不加锁、不分配内存
+		 */
+		uint16_t node_id(State &s, std::string_view node) {
+			const node_filter::NodeId filter_id = node_filter::intern(node);
+			// 登记满后的节点共用 OVERFLOW_ID，不能缓存
+			const bool cacheable = filter_id != node_filter::OVERFLOW_ID;
+			if (cacheable) {
+				const uint16_t cached = s.node_cache[filter_id].load(std::memory_order_acquire);
+				if (cached != 0) {
+					return static_cast<uint16_t>(cached - 1);
+				}
+			}
+			std::lock_guard<std::mutex> lock(s.mutex);
+			const uint16_t id = intern_node(s, node);
+			if (cacheable) {
+				s.node_cache[filter_id].store(static_cast<uint16_t>(id + 1), std::memory_order_release);
+			}
+			return id;
+		}
+	} // namespace
+
+	bool enabled() noexcept {
+		return state().enabled.load(std::memory_order_acquire);
+	}
+
+	bool open(const std::string &filename, std::size_t capacity) {
+		auto &s = state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		if (s.opened) {
+			return false;
+		}
+		s.opened = true;
+
+		const auto time_t_now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+		tm local{};
+		localtime_r(&time_t_now, &local);
+		const std::string path = fmt::format("{}/{:%Y-%m-%d_%H-%M-%S}_{}", LOG_DIR, local, filename);
+		const auto dot = filename.rfind('.');
+		s.extension = dot == std::string::npos ? "" : filename.substr(dot);
+		s.prefix = path.substr(0, path.size() - s.extension.size());
+
+		write_entry(s, "format", TEXT_FORMAT_ID, "s", "{}");
+		Segment *segment = create_segment(s, path, capacity);
+		if (segment == nullptr) {
+			s.entries.clear();
+			return false;
+		}
+		s.segment.store(segment, std::memory_order_release);
+		s.path = path;
+		s.enabled.store(true, std::memory_order_release);
+		std::atexit(close);
+		return true;
+	}
+
+	void close() {
+		auto &s = state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		if (!s.enabled.exchange(false, std::memory_order_acq_rel)) {
+			return;
+		}
+		finish_segment(s, *s.segment.load(std::memory_order_acquire));
+		std::fclose(s.index);
+		s.index = nullptr;
+		// 当前文件保持映射，关闭后仍可能有线程在写
+		release_retired(s);
+	}
+
+	std::string active_path() {
+		auto &s = state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		return s.enabled.load(std::memory_order_acquire) ? s.path : std::string();
+	}
+
+	std::vector<std::string> mapped_paths() {
+		auto &s = state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		release_retired(s);
+		std::vector<std::string> paths;
+		if (const Segment *segment = s.segment.load(std::memory_order_acquire); segment != nullptr) {
+			paths.push_back(segment->path);
+		}
+		for (const Segment *segment: s.retired) {
+			paths.push_back(segment->path);
+		}
+		return paths;
+	}
+
+	uint64_t dropped() {
+		return state().dropped.load(std::memory_order_relaxed);
+	}
+
+	uint32_t register_site(Site &site, std::string_view node_name, std::string_view format, const char *signature) {
+		auto &s = state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		uint32_t key = site.key.load(std::memory_order_relaxed);
+		if (key != 0 || s.index == nullptr) {
+			return key;
+		}
+		const uint16_t node = intern_node(s, node_name);
+		const auto format_id = static_cast<uint16_t>(s.next_format++);
+		write_entry(s, "format", format_id, signature[0] == '\0' ? "-" : signature, format);
+		key = (static_cast<uint32_t>(format_id) << 16) | node;
+		site.key.store(key, std::memory_order_release);
+		return key;
+	}
+
+	Reservation reserve(uint32_t size, uint32_t key, uint8_t level) {
+		auto &s = state();
+		while (true) {
+			Segment *segment = s.segment.load(std::memory_order_acquire);
+			// 登记后再确认文件没有被换下，否则映射可能已经解除
+			segment->writers.fetch_add(1, std::memory_order_seq_cst);
+			if (s.segment.load(std::memory_order_seq_cst) != segment) {
+				segment->writers.fetch_sub(1, std::memory_order_release);
+				continue;
+			}
+			const uint64_t offset = segment->cursor.fetch_add(size, std::memory_order_relaxed);
+			// 留出一条空记录头的位置作为结尾标记
+			if (offset + size + sizeof(uint32_t) <= segment->capacity) {
+				char *record = segment->base + offset;
+				RecordHeader header{};
+				header.format_id = static_cast<uint16_t>(key >> 16);
+				header.node_id = static_cast<uint16_t>(key & 0xFFFF);
+				header.timestamp_ns = monotonic_ns();
+				header.thread_id = thread_id();
+				header.level = level;
+				// size 留到 commit 时写入
+				std::memcpy(record + sizeof(uint32_t), reinterpret_cast<const char *>(&header) + sizeof(uint32_t),
+				            sizeof(header) - sizeof(uint32_t));
+				return {record, segment};
+			}
+			// 当前文件已满，换到下一个文件后重试；一条记录比整个文件还大时直接丢弃
+			// 换文件期间仍计在 writers 中，segment 不会被复用，roll_over 比较指针不会误判
+			const bool rolled = sizeof(FileHeader) + size + sizeof(uint32_t) <= segment->capacity && roll_over(s, segment);
+			segment->writers.fetch_sub(1, std::memory_order_release);
+			if (!rolled) {
+				s.dropped.fetch_add(1, std::memory_order_relaxed);
+				return {};
+			}
+		}
+	}
+
+	void commit(const Reservation &reservation, uint32_t size) {
+		__atomic_store_n(reinterpret_cast<uint32_t *>(reservation.record), size, __ATOMIC_RELEASE);
+		reservation.segment->writers.fetch_sub(1, std::memory_order_release);
+	}
+
+	bool write_text(uint8_t level, std::string_view node, std::string_view text) {
+		auto &s = state();
+		if (!s.enabled.load(std::memory_order_acquire)) {
+			return false;
+		}
+		const uint32_t key = (static_cast<uint32_t>(TEXT_FORMAT_ID) << 16) | node_id(s, node);
+		const auto size = static_cast<uint32_t>(
+			(sizeof(RecordHeader) + detail::arg_size(text) + 7) & ~static_cast<std::size_t>(7));
+		const Reservation reservation = reserve(size, key, level);
+		if (reservation.record == nullptr) {
+			return false;
+		}
+		char *cursor = reservation.record + sizeof(RecordHeader);
+		detail::write_arg(cursor, text);
+		commit(reservation, size);
+		return true;
+	}
+} // namespace debug::binlog
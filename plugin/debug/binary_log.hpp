@@ -0,0 +1,261 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef PLUGIN_DEBUG_BINARY_LOG_HPP
+#define PLUGIN_DEBUG_BINARY_LOG_HPP
+
+// C system headers
+
+// C++ system headers
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Third-party library headers
+#include <fmt/core.h>
+#include <fmt/format.h>
+
+// Project headers
+
+/**
+ * 二进制结构化日志
+ *
+ * 开启后，RMCV_LOG 在调用线程上只做一次原子加法预留空间，再把定长记录头和原始参数字节 memcpy 进预分配的 mmap 文件，
+ * 不做任何格式化。节点名和格式串在每个调用点第一次执行时登记到旁路索引文件(.rmfmt)，记录中只存编号。
+ * 赛后用 rmlog_decode 还原为文本、CSV 或 JSON。
+ * 文件写满后换到 "<时间>_<stem>.<序号><ext>"，每个文件带有完整的索引，可以单独解码；换文件失败时二进制日志关闭，日志回到文本输出。
+ *
+ * 文件布局：FileHeader，之后是首尾相接的记录(RecordHeader + 参数区，8 字节对齐)，size 为 0 处即结尾。
+ * 参数区按格式串登记时的类型签名排列：
+ *   b bool(1)  c char(1)  l int64(8)  L uint64(8)  f float(4)  d double(8)  s uint32 长度 + 字节
+ */
+namespace debug::binlog {
+	constexpr char MAGIC[8] = {'R', 'M', 'C', 'V', 'L', 'O', 'G', '1'};
+	constexpr uint32_t VERSION = 1;
+	// 日志文件的惯用扩展名和索引文件附加的扩展名，logfile 据此把二进制日志计入磁盘预算
+	constexpr char EXTENSION[] = ".rmlog";
+	constexpr char INDEX_EXTENSION[] = ".rmfmt";
+	// 预留给运行期格式串(debug::print)的格式编号，内容为 "{}"，参数为已格式化的文本
+	constexpr uint16_t TEXT_FORMAT_ID = 0;
+
+	struct FileHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t header_size;
+		uint64_t capacity;
+		// 关闭时写入，异常退出时为 0，解码以 size 为 0 的记录为结尾
+		uint64_t used;
+		uint64_t dropped;
+		// 同一时刻的系统时间和单调时间，用于把记录的单调时间换算为墙上时间
+		int64_t start_wall_ns;
+		int64_t start_monotonic_ns;
+	};
+
+	struct RecordHeader {
+		// 包含头部在内的记录长度，8 字节对齐；最后写入，非 0 表示记录完整
+		uint32_t size;
+		uint16_t format_id;
+		uint16_t node_id;
+		// CLOCK_MONOTONIC
+		int64_t timestamp_ns;
+		uint32_t thread_id;
+		uint8_t level;
+		uint8_t reserved[3];
+	};
+
+	/**
+	 * @brief 调用点登记状态，由 RMCV_LOG 以函数内静态变量的形式提供
+	 */
+	struct Site {
+		// (format_id << 16) | node_id，0 表示尚未登记
+		std::atomic<uint32_t> key{0};
+	};
+
+	template<typename T>
+	constexpr char type_code() {
+		using U = std::decay_t<T>;
+		if constexpr (std::is_same_v<U, bool>) {
+			return 'b';
+		} else if constexpr (std::is_same_v<U, char>) {
+			return 'c';
+		} else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+			return 'l';
+		} else if constexpr (std::is_integral_v<U>) {
+			return 'L';
+		} else if constexpr (std::is_same_v<U, float>) {
+			return 'f';
+		} else if constexpr (std::is_floating_point_v<U>) {
+			return 'd';
+		} else if constexpr (std::is_same_v<U, std::string> || std::is_same_v<U, std::string_view>
+		                     || std::is_same_v<U, const char *> || std::is_same_v<U, char *>) {
+			return 's';
+		} else {
+			return '\0';
+		}
+	}
+
+	template<typename T>
+	inline constexpr bool is_binary_v = type_code<T>() != '\0';
+
+	template<typename... Args>
+	const char *signature() {
+		static constexpr char sig[] = {type_code<Args>()..., '\0'};
+		return sig;
+	}
+
+	namespace detail {
+		template<typename T>
+		std::string_view as_view(const T &value) {
+			if constexpr (std::is_array_v<T>) {
+				return std::string_view(value);
+			} else if constexpr (std::is_pointer_v<T>) {
+				return value == nullptr ? std::string_view{} : std::string_view(value);
+			} else {
+				return std::string_view(value);
+			}
+		}
+
+		template<typename T>
+		std::size_t arg_size(const T &value) {
+			constexpr char code = type_code<T>();
+			if constexpr (code == 's') {
+				return sizeof(uint32_t) + as_view(value).size();
+			} else if constexpr (code == 'b' || code == 'c') {
+				return 1;
+			} else if constexpr (code == 'f') {
+				return 4;
+			} else {
+				return 8;
+			}
+		}
+
+		template<typename T>
+		void write_arg(char *&cursor, const T &value) {
+			constexpr char code = type_code<T>();
+			if constexpr (code == 's') {
+				const std::string_view view = as_view(value);
+				const auto size = static_cast<uint32_t>(view.size());
+				std::memcpy(cursor, &size, sizeof(size));
+				std::memcpy(cursor + sizeof(size), view.data(), size);
+				cursor += sizeof(size) + size;
+			} else {
+				using Stored = std::conditional_t<code == 'l', int64_t,
+					std::conditional_t<code == 'L', uint64_t,
+						std::conditional_t<code == 'd', double, std::decay_t<T> > > >;
+				const auto stored = static_cast<Stored>(value);
+				std::memcpy(cursor, &stored, sizeof(stored));
+				cursor += sizeof(stored);
+			}
+		}
+
+		struct Segment;
+	} // namespace detail
+
+	/**
+	 * @brief reserve 的结果，commit 前所在文件保持映射
+	 */
+	struct Reservation {
+		char *record = nullptr;
+		detail::Segment *segment = nullptr;
+	};
+
+	/**
+	 * @brief 二进制日志是否开启
+	 */
+	bool enabled() noexcept;
+
+	/**
+	 * @brief 在 LOG_DIR 下创建 "<时间>_<filename>" 及其索引文件 ".rmfmt"，预分配 capacity 字节并映射
+	 * 每个进程只能打开一次；写满后换到同样大小的新文件；进程退出时自动 close()
+	 * @return false 文件创建或映射失败，日志照常走文本输出
+	 */
+	bool open(const std::string &filename, std::size_t capacity = std::size_t(64) << 20);
+
+	/**
+	 * @brief 正在写入的文件路径，未开启时为空
+	 */
+	std::string active_path();
+
+	/**
+	 * @brief 仍在映射中的全部文件路径：正在写入的文件，以及换文件后还有线程未写完的旧文件
+	 * 这些文件删除后磁盘空间不会释放，日志清理时应跳过
+	 */
+	std::vector<std::string> mapped_paths();
+
+	/**
+	 * @brief 写入最终长度和丢弃数并同步到磁盘，之后的日志不再写入二进制文件
+	 */
+	void close();
+
+	/**
+	 * @brief 无法写入而丢弃的记录数
+	 */
+	uint64_t dropped();
+
+	/**
+	 * @brief 登记调用点的节点名和格式串
+	 * @return Site::key，二进制日志已关闭时返回 0
+	 */
+	uint32_t register_site(Site &site, std::string_view node, std::string_view format, const char *signature);
+
+	/**
+	 * @brief 原子地预留 size 字节并填好记录头中除 size 以外的字段，当前文件写满时先换到新文件
+	 * @param key register_site 的返回值
+	 * @return 无法换到新文件时 record 为 nullptr 并计入丢弃数，此时不需要 commit
+	 */
+	Reservation reserve(uint32_t size, uint32_t key, uint8_t level);
+
+	/**
+	 * @brief 写入 size 使记录对解码器可见，之后 reservation 所在的旧文件才可以解除映射
+	 */
+	void commit(const Reservation &reservation, uint32_t size);
+
+	/**
+	 * @brief 记录一条已格式化的文本，用于运行期格式串和无法直接序列化的参数
+	 * @return false 未写入，调用方应改用文本输出
+	 */
+	bool write_text(uint8_t level, std::string_view node, std::string_view text);
+
+	/**
+	 * @brief 记录一条日志，参数按类型签名原样拷贝
+	 * @return false 未写入，调用方应改用文本输出
+	 */
+	template<typename... Args>
+	bool write(Site &site, uint8_t level, std::string_view node, std::string_view format, const Args &... args) {
+		if constexpr ((is_binary_v<Args> && ...)) {
+			uint32_t key = site.key.load(std::memory_order_acquire);
+			if (key == 0) {
+				key = register_site(site, node, format, signature<Args...>());
+				if (key == 0) {
+					return false;
+				}
+			}
+			const auto size = static_cast<uint32_t>(
+				(sizeof(RecordHeader) + (detail::arg_size(args) + ... + 0) + 7) & ~static_cast<std::size_t>(7));
+			const Reservation reservation = reserve(size, key, level);
+			if (reservation.record == nullptr) {
+				return false;
+			}
+			char *cursor = reservation.record + sizeof(RecordHeader);
+			(detail::write_arg(cursor, args), ...);
+			commit(reservation, size);
+			return true;
+		} else {
+			std::string text;
+			try {
+				text = fmt::format(fmt::runtime(format), args...);
+			} catch (const fmt::format_error &e) {
+				text = std::string(format) + " [格式化错误: " + e.what() + "]";
+			}
+			return write_text(level, node, text);
+		}
+	}
+} // namespace debug::binlog
+
+#endif //PLUGIN_DEBUG_BINARY_LOG_HPP
@@ -0,0 +1,368 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// Source file corresponding header
+#include "log_file.hpp"
+
+// C system headers
+#include <sys/stat.h>
+#include <time.h>
+
+// C++ system headers
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+// Third-party library headers
+#include <fmt/chrono.h>
+#include <fmt/core.h>
+#include <zlib.h>
+
+// Project headers
+#include "plugin/debug/binary_log.hpp"
+#include "plugin/debug/logger.hpp"
+
+namespace debug::logfile {
+	namespace fs = std::filesystem;
+
+	namespace {
+		// 用户态写缓冲区大小
+		constexpr std::size_t WRITE_BUFFER_SIZE = 1 << 18;
+		constexpr std::size_t COMPRESS_CHUNK_SIZE = 1 << 16;
+
+		struct State {
+			std::mutex mutex;
+			std::condition_variable wake;
+			std::thread worker;
+			bool stopping = false;
+
+			Options options;
+			std::FILE *file = nullptr;
+			std::unique_ptr<char[]> buffer;
+			std::string dir;
+			std::string filename;
+			// 启动时间前缀，同一次运行的分段共用
+			std::string prefix;
+			std::string stem;
+			std::string extension;
+			std::string active_path;
+			uint32_t index = 0;
+			std::size_t bytes = 0;
+			std::chrono::steady_clock::time_point opened_at;
+			bool dirty = false;
+			// 二进制日志换了文件，需要按预算清理
+			bool collect_requested = false;
+			// 等待压缩的已关闭分段
+			std::deque<std::string> closed;
+		};
+
+		State &state() {
+			// 有意不析构，退出时仍在运行的线程可以安全地访问
+			static auto *instance = new State();
+			return *instance;
+		}
+
+		std::string segment_path(const State &s) {
+			if (s.index == 0) {
+				return fmt::format("{}/{}_{}", s.dir, s.prefix, s.filename);
+			}
+			return fmt::format("{}/{}_{}.{}{}", s.dir, s.prefix, s.stem, s.index, s.extension);
+		}
+
+		/**
+		 * @brief 打开当前序号的分段，调用方持有 mutex
+		 */
+		bool open_segment(State &s) {
+			s.active_path = segment_path(s);
+			s.file = std::fopen(s.active_path.c_str(), "a");
+			if (s.file == nullptr) {
+				return false;
+			}
+			std::setvbuf(s.file, s.buffer.get(), _IOFBF, WRITE_BUFFER_SIZE);
+			s.bytes = 0;
+			s.opened_at = std::chrono::steady_clock::now();
+			return true;
+		}
+
+		/**
+		 * @brief 关闭当前分段并切换到下一个，调用方持有 mutex
+		 */
+		void rotate(State &s) {
+			std::fclose(s.file);
+			s.file = nullptr;
+			s.dirty = false;
+			const std::string previous = s.active_path;
+			s.closed.push_back(previous);
+			++s.index;
+			if (!open_segment(s)) {
+				std::fprintf(stderr, "logfile: cannot open %s\n", s.active_path.c_str());
+				return;
+			}
+			const std::string header = fmt::format("\n## Continued from {}\n", fs::path(previous).filename().string());
+			std::fwrite(header.data(), 1, header.size(), s.file);
+			s.bytes += header.size();
+			s.wake.notify_all();
+		}
+
+		bool should_rotate(const State &s) {
+			if (s.options.max_segment_bytes != 0 && s.bytes >= s.options.max_segment_bytes) {
+				return true;
+			}
+			return s.options.max_segment_age.count() != 0
+			       && std::chrono::steady_clock::now() - s.opened_at >= s.options.max_segment_age;
+		}
+
+		/**
+		 * @brief 压缩为 path.gz 后删除原文件
+		 */
+		bool compress(const std::string &path) {
+			std::FILE *source = std::fopen(path.c_str(), "rb");
+			if (source == nullptr) {
+				return false;
+			}
+			const std::string temp = path + ".gz.tmp";
+			gzFile target = gzopen(temp.c_str(), "wb6");
+			if (target == nullptr) {
+				std::fclose(source);
+				return false;
+			}
+			std::vector<char> chunk(COMPRESS_CHUNK_SIZE);
+			bool ok = true;
+			std::size_t size;
+			while ((size = std::fread(chunk.data(), 1, chunk.size(), source)) > 0) {
+				if (gzwrite(target, chunk.data(), static_cast<unsigned>(size)) != static_cast<int>(size)) {
+					ok = false;
+					break;
+				}
+			}
+			ok = ok && !std::ferror(source);
+			std::fclose(source);
+			ok = gzclose(target) == Z_OK && ok;
+			std::error_code error;
+			if (!ok) {
+				fs::remove(temp, error);
+				return false;
+			}
+			fs::rename(temp, path + ".gz", error);
+			if (error) {
+				return false;
+			}
+			fs::remove(path, error);
+			return true;
+		}
+
+		bool ends_with(std::string_view text, std::string_view suffix) {
+			return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+		}
+
+		bool is_log_segment(const std::string &name, const State &s) {
+			// "<前缀>_<filename>"、"<前缀>_<stem>.<序号><ext>" 及其 .gz，以及同名的二进制日志和索引
+			std::string_view base = name;
+			if (ends_with(base, ".gz")) {
+				base.remove_suffix(3);
+			} else if (ends_with(base, binlog::INDEX_EXTENSION)) {
+				base.remove_suffix(std::string_view(binlog::INDEX_EXTENSION).size());
+			}
+			if (!ends_with(base, s.extension) && !ends_with(base, binlog::EXTENSION)) {
+				return false;
+			}
+			return base.find("_" + s.stem) != std::string_view::npos;
+		}
+
+		/**
+		 * @brief 实际占用的磁盘空间，二进制日志是预分配的稀疏文件，不能按文件长度计算
+		 */
+		std::uintmax_t disk_usage(const fs::path &path) {
+			struct stat info{};
+			if (::stat(path.c_str(), &info) != 0) {
+				return 0;
+			}
+			return static_cast<std::uintmax_t>(info.st_blocks) * 512;
+		}
+
+		/**
+		 * @brief 删除最旧的分段直到总大小不超过预算，当前文件和待压缩的分段除外
+		 */
+		void collect_garbage(const std::string &dir, const std::vector<std::string> &keep, const State &s) {
+			struct Segment {
+				fs::path path;
+				fs::file_time_type time;
+				std::uintmax_t size;
+			};
+			std::vector<Segment> segments;
+			std::uintmax_t total = 0;
+			std::error_code error;
+			// 仍在映射中的二进制日志删除后不释放空间，不删除
+			std::vector<std::string> keep_all = keep;
+			for (const std::string &binary: binlog::mapped_paths()) {
+				keep_all.push_back(binary);
+				keep_all.push_back(binary + binlog::INDEX_EXTENSION);
+			}
+			for (const auto &entry: fs::directory_iterator(dir, error)) {
+				if (!entry.is_regular_file(error) || !is_log_segment(entry.path().filename().string(), s)) {
+					continue;
+				}
+				const std::uintmax_t size = disk_usage(entry.path());
+				total += size;
+				if (std::find(keep_all.begin(), keep_all.end(), entry.path().string()) == keep_all.end()) {
+					segments.push_back({entry.path(), entry.last_write_time(error), size});
+				}
+			}
+			std::sort(segments.begin(), segments.end(), [](const Segment &a, const Segment &b) {
+				return a.time < b.time;
+			});
+			for (const auto &segment: segments) {
+				if (total <= s.options.disk_budget_bytes) {
+					break;
+				}
+				if (fs::remove(segment.path, error)) {
+					total -= segment.size;
+					debug::print(PrintMode::INFO, "logfile", "超出磁盘预算，删除 {}", segment.path.filename().string());
+				}
+			}
+		}
+
+		void run(State &s) {
+			std::unique_lock<std::mutex> lock(s.mutex);
+			while (true) {
+				s.wake.wait_for(lock, s.options.flush_interval,
+				                [&s]() { return s.stopping || s.collect_requested || !s.closed.empty(); });
+				if (s.dirty && s.file != nullptr) {
+					std::fflush(s.file);
+					s.dirty = false;
+				}
+				bool changed = s.collect_requested;
+				s.collect_requested = false;
+				while (!s.closed.empty()) {
+					const std::string path = s.closed.front();
+					const bool compress_segment = s.options.compress;
+					lock.unlock();
+					if (compress_segment && !compress(path)) {
+						debug::print(PrintMode::WARNING, "logfile", "压缩 {} 失败", path);
+					}
+					lock.lock();
+					s.closed.pop_front();
+					changed = true;
+				}
+				if (changed && s.options.disk_budget_bytes != 0) {
+					std::vector<std::string> keep(s.closed.begin(), s.closed.end());
+					keep.push_back(s.active_path);
+					const std::string dir = s.dir;
+					lock.unlock();
+					collect_garbage(dir, keep, s);
+					lock.lock();
+				}
+				if (s.stopping && s.closed.empty()) {
+					return;
+				}
+			}
+		}
+	} // namespace
+
+	bool open(const std::string &dir, const std::string &filename, const Options &options) {
+		auto &s = state();
+		{
+			std::lock_guard<std::mutex> lock(s.mutex);
+			if (s.file != nullptr || s.worker.joinable()) {
+				return false;
+			}
+			const time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+			tm local{};
+			localtime_r(&now, &local);
+			s.options = options;
+			s.dir = dir;
+			s.filename = filename;
+			s.prefix = fmt::format("{:%Y-%m-%d_%H-%M-%S}", local);
+			const fs::path name(filename);
+			s.stem = name.stem().string();
+			s.extension = name.extension().string();
+			s.index = 0;
+			s.buffer = std::make_unique<char[]>(WRITE_BUFFER_SIZE);
+			if (!open_segment(s)) {
+				s.buffer.reset();
+				return false;
+			}
+			s.stopping = false;
+			s.worker = std::thread([&s]() { run(s); });
+		}
+		static const bool registered = (std::atexit(close), true);
+		(void) registered;
+		// 启动时先按预算清理之前运行留下的文件
+		if (options.disk_budget_bytes != 0) {
+			collect_garbage(dir, {segment_path(s)}, s);
+		}
+		return true;
+	}
+
+	bool is_open() noexcept {
+		auto &s = state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		return s.file != nullptr;
+	}
+
+	void write(std::string_view text, bool urgent) {
+		auto &s = state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		if (s.file == nullptr) {
+			return;
+		}
+		std::fwrite(text.data(), 1, text.size(), s.file);
+		s.bytes += text.size();
+		if (urgent) {
+			std::fflush(s.file);
+			s.dirty = false;
+		} else {
+			s.dirty = true;
+		}
+		if (should_rotate(s)) {
+			rotate(s);
+		}
+	}
+
+	void flush() {
+		auto &s = state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		if (s.file != nullptr) {
+			std::fflush(s.file);
+			s.dirty = false;
+		}
+	}
+
+	void request_garbage_collection() {
+		auto &s = state();
+		{
+			std::lock_guard<std::mutex> lock(s.mutex);
+			if (!s.worker.joinable()) {
+				return;
+			}
+			s.collect_requested = true;
+		}
+		s.wake.notify_all();
+	}
+
+	void close() {
+		auto &s = state();
+		{
+			std::lock_guard<std::mutex> lock(s.mutex);
+			if (s.file != nullptr) {
+				std::fclose(s.file);
+				s.file = nullptr;
+				s.dirty = false;
+			}
+			s.stopping = true;
+		}
+		s.wake.notify_all();
+		if (s.worker.joinable()) {
+			s.worker.join();
+		}
+	}
+} // namespace debug::logfile
@@ -0,0 +1,72 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef PLUGIN_DEBUG_LOG_FILE_HPP
+#define PLUGIN_DEBUG_LOG_FILE_HPP
+
+// C system headers
+
+// C++ system headers
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Third-party library headers
+
+// Project headers
+
+/**
+ * 文本日志文件
+ *
+ * 写入先进入用户态缓冲区，由后台线程每 flush_interval 刷新一次，ERROR 日志立即刷新。
+ * 文件超过大小或时间上限后切换到新文件，已关闭的文件由后台线程压缩为 .gz，
+ * 目录中本日志的总大小超过磁盘预算时从最旧的文件开始删除。
+ *
+ * 文件名为 "<启动时间>_<filename>"，之后的分段为 "<启动时间>_<stem>.<序号><ext>"。
+ * 同名(stem 相同)的二进制日志 "*_<stem>*.rmlog" 及其索引也计入磁盘预算，正在写入的除外。
+ */
+namespace debug::logfile {
+	struct Options {
+		// 单个文件的大小上限，0 表示不按大小切换
+		std::size_t max_segment_bytes = std::size_t(64) << 20;
+		// 单个文件的时间上限，0 表示不按时间切换
+		std::chrono::seconds max_segment_age{0};
+		// 批量刷新的间隔
+		std::chrono::milliseconds flush_interval{200};
+		// 目录中本日志(含压缩后的分段)的总大小上限，0 表示不限制
+		std::uintmax_t disk_budget_bytes = std::uintmax_t(1) << 30;
+		// 是否压缩已关闭的分段
+		bool compress = true;
+	};
+
+	/**
+	 * @brief 在 dir 下打开日志文件并启动后台线程；进程退出时自动 close()
+	 * @return false 已经打开或文件无法创建
+	 */
+	bool open(const std::string &dir, const std::string &filename, const Options &options = {});
+
+	bool is_open() noexcept;
+
+	/**
+	 * @brief 追加文本，未打开时忽略
+	 * @param urgent 为 true 时立即刷新到内核
+	 */
+	void write(std::string_view text, bool urgent = false);
+
+	void flush();
+
+	/**
+	 * @brief 让后台线程按磁盘预算清理一次，二进制日志换文件后调用
+	 */
+	void request_garbage_collection();
+
+	/**
+	 * @brief 刷新并关闭当前文件，等待后台线程压缩完已关闭的分段
+	 */
+	void close();
+} // namespace debug::logfile
+
+#endif //PLUGIN_DEBUG_LOG_FILE_HPP
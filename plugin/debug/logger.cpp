@@ -0,0 +1,67 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// Source file corresponding header
+#include "logger.hpp"
+
+// C system headers
+
+// C++ system headers
+#include <string>
+#include <vector>
+
+// Third-party library headers
+
+// Project headers
+#include "plugin/param/runtime_parameter.hpp"
+
+namespace debug {
+	namespace {
+		std::vector<std::string> split_nodes(std::string_view text) {
+			std::vector<std::string> nodes;
+			while (!text.empty()) {
+				const auto comma = text.find(',');
+				std::string_view node = text.substr(0, comma);
+				const auto begin = node.find_first_not_of(" \t");
+				if (begin != std::string_view::npos) {
+					node = node.substr(begin, node.find_last_not_of(" \t") - begin + 1);
+					nodes.emplace_back(node);
+				}
+				if (comma == std::string_view::npos) {
+					break;
+				}
+				text.remove_prefix(comma + 1);
+			}
+			return nodes;
+		}
+
+		/**
+		 * @brief 按快照中的当前值设置，没有的键保持不变
+		 */
+		void apply(const runtime_param::ParamSnapshot &snapshot, const std::string &table) {
+			if (const auto *whitelist = snapshot.find<std::string>(table + ".whitelist")) {
+				node_filter::set_whitelist(split_nodes(*whitelist));
+			}
+			if (const auto *blacklist = snapshot.find<std::string>(table + ".blacklist")) {
+				node_filter::set_blacklist(split_nodes(*blacklist));
+			}
+			if (const auto *level = snapshot.find<std::string>(table + ".level")) {
+				// string_to_mode 对未知名字也返回 SILENT，只有明确写 "silent" 时才关闭输出
+				const PrintMode mode = string_to_mode(*level);
+				if (mode == PrintMode::SILENT && *level != "silent" && *level != "SILENT") {
+					print(PrintMode::ERROR, "logger", "{}.level = \"{}\" 不是有效的等级，保持不变", table, *level);
+				} else {
+					set_min_mode(mode);
+				}
+			}
+		}
+	} // namespace
+
+	uint64_t bind_runtime_params(const std::string &table) {
+		apply(*runtime_param::pin_snapshot(), table);
+		return runtime_param::subscribe(table, [table](const runtime_param::ParamChanges &) {
+			apply(*runtime_param::pin_snapshot(), table);
+		});
+	}
+} // namespace debug
@@ -1,240 +1,477 @@
-#ifndef PLUGIN_DEBUG_LOGGER_HPP
-#define PLUGIN_DEBUG_LOGGER_HPP
-
-// C system headers
-
-// C++ system headers
-#include <algorithm>
-#include <chrono>
-#include <fstream>
-#include <iomanip>
-#include <map>
-#include <mutex>
-#include <set>
-#include <sstream>
-#include <string>
-#include <unordered_map>
-
-// Third-party library headers
-#include <Eigen/Core>
-#include <fmt/chrono.h>
-#include <fmt/color.h>
-#include <fmt/core.h>
-
-//总有傻逼宏定义污染资源
-#ifdef INFO
-#undef INFO
-#endif
-#ifdef DEBUG
-#undef DEBUG
-#endif
-#ifdef WARNING
-#undef WARNING
-#endif
-#ifdef ERROR
-#undef ERROR
-#endif
-#ifdef SILENT
-#undef SILENT
-#endif
-
-namespace debug {
-	namespace fmt = ::fmt;
-
-	enum class PrintMode {
-		LOG,
-		INFO,
-		DEBUG,
-		WARNING,
-		ERROR,
-		SILENT
-	};
-
-	static const Eigen::IOFormat kLongCsvFmt(
-		Eigen::FullPrecision, Eigen::FullPrecision, ", ", ";\n", "[", "]", "\n{", "}");
-	static const std::unordered_map<PrintMode, fmt::color> PRINT_COLOR = {
-		{PrintMode::LOG, fmt::color::green},
-		{PrintMode::INFO, fmt::color::white},
-		{PrintMode::WARNING, fmt::color::yellow},
-		{PrintMode::ERROR, fmt::color::red},
-		{PrintMode::DEBUG, fmt::color::cyan},
-	};
-	static const std::unordered_map<PrintMode, std::string> PRINT_PREFIX = {
-		{PrintMode::LOG, "[LOGG]"},
-		{PrintMode::INFO, "[INFO]"},
-		{PrintMode::WARNING, "[WARN]"},
-		{PrintMode::ERROR, "[EROR]"},
-		{PrintMode::DEBUG, "[DBUG]"}
-	};
-	//	static const std::unordered_map<PrintMode, std::string> HTML_COLOR = {
-	//			{PrintMode::LOG, "green"},
-	//			{PrintMode::INFO, ""},
-	//			{PrintMode::DEBUG, "blue"},
-	//			{PrintMode::WARNING, "orange"},
-	//			{PrintMode::ERROR, "red"},
-	//	};
-	static PrintMode current_min_mode = PrintMode::LOG;
-	static std::set<std::string> whitelist_nodes;
-	static std::set<std::string> blacklist_nodes;
-	static std::ofstream md_file;
-	static std::mutex file_mutex;
-
-
-	inline void add_whitenode(const std::string &node) {
-		whitelist_nodes.insert(node);
-	}
-
-	inline void add_blacknode(const std::string &node) {
-		blacklist_nodes.insert(node);
-	}
-
-	template<typename T>
-	inline auto stream_to_str(T &x) -> std::string {
-		std::stringstream buffer;
-		buffer << x;
-		return buffer.str();
-	}
-
-	template<typename T>
-	inline auto eigen_to_str(const T &x) -> std::string {
-		std::ostringstream oss;
-		oss << x.format(kLongCsvFmt);
-		return oss.str();
-	}
-
-	template<typename T>
-	inline auto vec_to_str(const std::vector<T> &vec) -> std::string {
-		std::string str = "[";
-		for (const auto &ele: vec) {
-			str += fmt::format("{}", ele);
-			if (&ele != &vec.back()) {
-				str += ", ";
-			}
-		}
-		str += "]";
-		return str;
-	}
-
-	template<typename K, typename V>
-	inline auto map_to_str(const std::map<K, V> &m) -> std::string {
-		std::string str = "{";
-		for (auto it = m.begin(); it != m.end(); ++it) {
-			const auto &key = it->first;
-			const auto &data = it->second;
-
-			// 格式化每个元素
-			str += fmt::format("{}: {{{},{}}}", key, data.val, data.updated);
-
-			// 添加逗号，除了最后一个元素
-			if (std::next(it) != m.end()) {
-				str += ", ";
-			}
-		}
-		str += "}";
-		return str;
-	}
-
-	inline std::string get_current_time_string() {
-		auto now = std::chrono::system_clock::now();
-		auto time_t_now = std::chrono::system_clock::to_time_t(now);
-		auto microseconds =
-				std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()) % 1000000 % 1000;
-		auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
-
-		// 使用 fmt::format 格式化输出时间，包括毫秒和微秒
-		return fmt::format("{:%H:%M:%S}.{:03},{:03}", *std::localtime(&time_t_now), milliseconds.count(),
-		                   microseconds.count());
-	}
-
-	inline void init_md_file(const std::string &filename) {
-		// Get current time for filename (without microseconds)
-		auto now = std::chrono::system_clock::now();
-		auto time_t_now = std::chrono::system_clock::to_time_t(now);
-		std::string timestamp = fmt::format("{:%Y-%m-%d_%H-%M-%S}", *std::localtime(&time_t_now));
-
-		// Create filename with timestamp
-		std::string timestamped_filename = fmt::format("{}_{}", timestamp, filename);
-
-		md_file.open(std::string(LOG_DIR) + "/" + timestamped_filename, std::ios::app);
-		if (md_file.is_open()) {
-			std::lock_guard<std::mutex> lock(file_mutex);
-			std::string current_time = get_current_time_string();
-			md_file << fmt::format("\n## Run started at {}\n", current_time);
-			md_file.flush();
-		}
-	}
-
-	inline void close_md_file() {
-		if (md_file.is_open()) {
-			md_file.close();
-		}
-	}
-
-	template<typename... T>
-	inline void print(
-		const PrintMode &mode,
-		const std::string &node_name,
-		const std::string &content,
-		T &&... args) {
-		if (mode >= current_min_mode &&
-		    (whitelist_nodes.empty() || whitelist_nodes.find(node_name) != whitelist_nodes.end()) &&
-		    (blacklist_nodes.find(node_name) == blacklist_nodes.end())) {
-			std::string timestamp = get_current_time_string();
-			std::string formatted_content;
-			try {
-				if constexpr (sizeof...(args) > 0) {
-					formatted_content = fmt::format(fmt::runtime(content), std::forward<T>(args)...);
-				} else {
-					formatted_content = content;
-				}
-			} catch (const fmt::format_error &e) {
-				formatted_content = content + " [格式化错误: " + e.what() + "]";
-			}
-
-			std::string full_message = fmt::format("{} {} {}: {}",
-			                                       timestamp, PRINT_PREFIX.at(mode),
-			                                       (node_name.empty() ? "" : "@" + node_name),
-			                                       formatted_content);
-
-			fmt::print(fmt::fg(PRINT_COLOR.at(mode)), "{}\n", full_message);
-
-			if (md_file.is_open()) {
-				std::lock_guard<std::mutex> lock(file_mutex);
-				//////////////
-				md_file << fmt::format("{} {} {}: {}\n",
-				                       timestamp, PRINT_PREFIX.at(mode),
-				                       (node_name.empty() ? "" : "@" + node_name),
-				                       formatted_content);
-				////////////
-				//md_file << fmt::format("- **{}** <font color=\"{}\">{} {}: {}</font>\n",
-				//                       timestamp, HTML_COLOR.at(mode),
-				//                       PRINT_PREFIX.at(mode),
-				//                       (node_name.empty() ? "" : "@" + node_name),
-				//                       formatted_content);
-				md_file.flush();
-			}
-		}
-	}
-
-	inline auto string_to_mode(const std::string &mode_str) -> PrintMode {
-		std::string lower_str = mode_str;
-		std::transform(lower_str.begin(), lower_str.end(), lower_str.begin(), ::tolower);
-		if (lower_str == "log") return PrintMode::LOG;
-		if (lower_str == "info") return PrintMode::INFO;
-		if (lower_str == "debug") return PrintMode::DEBUG;
-		if (lower_str == "warning") return PrintMode::WARNING;
-		if (lower_str == "error") return PrintMode::ERROR;
-		return PrintMode::SILENT;
-	}
-
-	template<typename... T>
-	inline void print(
-		const std::string &mode_str,
-		const std::string &node_name,
-		const std::string &content,
-		T &&... args) {
-		print(string_to_mode(mode_str), node_name, content, std::forward<T>(args)...);
-	}
-}
-
-#endif //PLUGIN_DEBUG_LOGGER_HPP
+#ifndef PLUGIN_DEBUG_LOGGER_HPP
+#define PLUGIN_DEBUG_LOGGER_HPP
+
+// C system headers
+
+// C++ system headers
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Third-party library headers
+#include <Eigen/Core>
+#include <fmt/chrono.h>
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <fmt/format.h>
+
+// Project headers
+#include "plugin/debug/async_logger.hpp"
+#include "plugin/debug/binary_log.hpp"
+#include "plugin/debug/log_file.hpp"
+#include "plugin/debug/node_filter.hpp"
+#include "plugin/debug/timestamp.hpp"
+
+//总有傻逼宏定义污染资源
+#ifdef INFO
+#undef INFO
+#endif
+#ifdef DEBUG
+#undef DEBUG
+#endif
+#ifdef WARNING
+#undef WARNING
+#endif
+#ifdef ERROR
+#undef ERROR
+#endif
+#ifdef SILENT
+#undef SILENT
+#endif
+
+namespace debug {
+	namespace fmt = ::fmt;
+
+	enum class PrintMode {
+		LOG,
+		INFO,
+		DEBUG,
+		WARNING,
+		ERROR,
+		SILENT
+	};
+
+	static const Eigen::IOFormat kLongCsvFmt(
+		Eigen::FullPrecision, Eigen::FullPrecision, ", ", ";\n", "[", "]", "\n{", "}");
+	static const std::unordered_map<PrintMode, fmt::color> PRINT_COLOR = {
+		{PrintMode::LOG, fmt::color::green},
+		{PrintMode::INFO, fmt::color::white},
+		{PrintMode::WARNING, fmt::color::yellow},
+		{PrintMode::ERROR, fmt::color::red},
+		{PrintMode::DEBUG, fmt::color::cyan},
+	};
+	static const std::unordered_map<PrintMode, std::string> PRINT_PREFIX = {
+		{PrintMode::LOG, "[LOGG]"},
+		{PrintMode::INFO, "[INFO]"},
+		{PrintMode::WARNING, "[WARN]"},
+		{PrintMode::ERROR, "[EROR]"},
+		{PrintMode::DEBUG, "[DBUG]"}
+	};
+	//	static const std::unordered_map<PrintMode, std::string> HTML_COLOR = {
+	//			{PrintMode::LOG, "green"},
+	//			{PrintMode::INFO, ""},
+	//			{PrintMode::DEBUG, "blue"},
+	//			{PrintMode::WARNING, "orange"},
+	//			{PrintMode::ERROR, "red"},
+	//	};
+	// 运行期的最低等级，全进程一份，任何线程都可以修改
+	inline std::atomic<PrintMode> current_min_mode{PrintMode::LOG};
+	// 二进制日志开启后，仍输出到终端和文本日志的最低等级
+	constexpr PrintMode BINLOG_ECHO_MODE = PrintMode::WARNING;
+
+	inline void set_min_mode(PrintMode mode) {
+		current_min_mode.store(mode, std::memory_order_relaxed);
+	}
+
+	inline void add_whitenode(const std::string &node) {
+		node_filter::add_white(node);
+	}
+
+	inline void add_blacknode(const std::string &node) {
+		node_filter::add_black(node);
+	}
+
+	template<typename T>
+	inline auto stream_to_str(T &x) -> std::string {
+		std::stringstream buffer;
+		buffer << x;
+		return buffer.str();
+	}
+
+	template<typename T>
+	inline auto eigen_to_str(const T &x) -> std::string {
+		std::ostringstream oss;
+		oss << x.format(kLongCsvFmt);
+		return oss.str();
+	}
+
+	template<typename T, typename Allocator>
+	inline auto vec_to_str(const std::vector<T, Allocator> &vec) -> std::string {
+		std::string str = "[";
+		for (const auto &ele: vec) {
+			str += fmt::format("{}", ele);
+			if (&ele != &vec.back()) {
+				str += ", ";
+			}
+		}
+		str += "]";
+		return str;
+	}
+
+	template<typename K, typename V>
+	inline auto map_to_str(const std::map<K, V> &m) -> std::string {
+		std::string str = "{";
+		for (auto it = m.begin(); it != m.end(); ++it) {
+			const auto &key = it->first;
+			const auto &data = it->second;
+
+			// 格式化每个元素
+			str += fmt::format("{}: {{{},{}}}", key, data.val, data.updated);
+
+			// 添加逗号，除了最后一个元素
+			if (std::next(it) != m.end()) {
+				str += ", ";
+			}
+		}
+		str += "}";
+		return str;
+	}
+
+	/**
+	 * @brief 当前时间，格式见 timestamp::format；默认为本地时间，可用 timestamp::use_clock 切换为单调时钟
+	 */
+	inline std::string get_current_time_string() {
+		const auto clock = timestamp::clock();
+		return timestamp::to_string(timestamp::now_ns(clock), clock);
+	}
+
+	/**
+	 * @brief 在 LOG_DIR 下打开 "<启动时间>_<filename>"，按 options 分段、压缩和清理，见 logfile::Options
+	 */
+	inline void init_md_file(const std::string &filename, const logfile::Options &options = {}) {
+		if (logfile::open(LOG_DIR, filename, options)) {
+			logfile::write(fmt::format("\n## Run started at {}\n", get_current_time_string()), true);
+		}
+	}
+
+	inline void close_md_file() {
+		logfile::close();
+	}
+
+	/**
+	 * @brief 等级和节点过滤，在任何格式化之前调用
+	 */
+	inline bool should_print(const PrintMode &mode, std::string_view node_name) {
+		return mode >= current_min_mode.load(std::memory_order_relaxed) && node_filter::allowed(node_name);
+	}
+
+	/**
+	 * @brief 同步输出一条已格式化的日志
+	 */
+	inline void write_line(const PrintMode &mode, std::string_view node_name, std::string_view formatted_content) {
+		const auto clock = timestamp::clock();
+		char time_text[timestamp::MAX_SIZE];
+		const std::size_t time_size = timestamp::format(timestamp::now_ns(clock), clock, time_text);
+		std::string full_message = fmt::format("{} {} {}{}: {}",
+		                                       std::string_view(time_text, time_size), PRINT_PREFIX.at(mode),
+		                                       (node_name.empty() ? "" : "@"), node_name,
+		                                       formatted_content);
+
+		fmt::print(fmt::fg(PRINT_COLOR.at(mode)), "{}\n", full_message);
+
+		// 批量刷新，ERROR 立即落盘
+		full_message += '\n';
+		logfile::write(full_message, mode >= PrintMode::ERROR);
+	}
+
+	/**
+	 * @brief 异步模式下把日志写入本线程的缓冲区，不能直接序列化的参数先在本线程格式化
+	 * @param literal content 为编译期格式串时只存指针
+	 */
+	template<typename... T>
+	inline void print_async(const PrintMode &mode, std::string_view node_name, std::string_view content,
+	                        bool literal, T &&... args) {
+		const auto level = static_cast<uint8_t>(mode);
+		if constexpr ((async::is_serializable_v<T> && ...)) {
+			async::push(level, node_name, content, literal, args...);
+		} else {
+			std::string formatted_content;
+			try {
+				formatted_content = fmt::format(fmt::runtime(content), std::forward<T>(args)...);
+			} catch (const fmt::format_error &e) {
+				formatted_content = std::string(content) + " [格式化错误: " + e.what() + "]";
+			}
+			async::push(level, node_name, formatted_content, false);
+		}
+	}
+
+	/**
+	 * @brief 按运行期格式串格式化，出错时附上错误信息而不是抛出；没有参数时原样返回
+	 */
+	template<typename... T>
+	inline std::string format_content(const std::string &content, T &&... args) {
+		if constexpr (sizeof...(args) > 0) {
+			try {
+				return fmt::format(fmt::runtime(content), std::forward<T>(args)...);
+			} catch (const fmt::format_error &e) {
+				return content + " [格式化错误: " + e.what() + "]";
+			}
+		} else {
+			return content;
+		}
+	}
+
+	/**
+	 * @brief 运行期格式串的输出接口，格式错误只能在运行时以 "[格式化错误]" 的形式发现
+	 * 格式串为字面量时优先使用 RMCV_LOG 系列宏
+	 */
+	template<typename... T>
+	inline void print(
+		const PrintMode &mode,
+		const std::string &node_name,
+		const std::string &content,
+		T &&... args) {
+		if (!should_print(mode, node_name)) {
+			return;
+		}
+		// 二进制日志写入失败(已关闭或换文件失败)时照常输出文本
+		if (binlog::enabled() && PRINT_PREFIX.count(mode) != 0
+		    && binlog::write_text(static_cast<uint8_t>(mode), node_name, format_content(content, args...))
+		    && mode < BINLOG_ECHO_MODE) {
+			return;
+		}
+		if (async::enabled() && PRINT_PREFIX.count(mode) != 0) {
+			print_async(mode, node_name, content, false, std::forward<T>(args)...);
+			return;
+		}
+		write_line(mode, node_name, format_content(content, std::forward<T>(args)...));
+	}
+
+	/**
+	 * @brief 不分配内存、不区分大小写的等级名解析，参数为字面量时可在编译期求值
+	 */
+	constexpr auto string_to_mode(std::string_view mode_str) -> PrintMode {
+		const auto equals = [mode_str](std::string_view name) {
+			if (mode_str.size() != name.size()) {
+				return false;
+			}
+			for (std::size_t i = 0; i < name.size(); ++i) {
+				const char ch = mode_str[i];
+				if ((ch >= 'A' && ch <= 'Z' ? static_cast<char>(ch - 'A' + 'a') : ch) != name[i]) {
+					return false;
+				}
+			}
+			return true;
+		};
+		if (equals("log")) return PrintMode::LOG;
+		if (equals("info")) return PrintMode::INFO;
+		if (equals("debug")) return PrintMode::DEBUG;
+		if (equals("warning")) return PrintMode::WARNING;
+		if (equals("error")) return PrintMode::ERROR;
+		return PrintMode::SILENT;
+	}
+
+	/**
+	 * @brief 由运行时参数表 table 设置最低等级和节点过滤，参数文件修改后立即生效
+	 * 表中的键均可省略：level = "info"；whitelist、blacklist 为逗号分隔的节点名，为空表示不限制
+	 * 在参数文件首次加载完成后调用
+	 * @return 订阅id，用于 runtime_param::unsubscribe
+	 */
+	uint64_t bind_runtime_params(const std::string &table = "Logger");
+
+	/**
+	 * @brief 以等级名指定等级，等级名(如来自配置)在每次调用时解析
+	 * 等级在编译期已知时直接传 PrintMode，不经过这里
+	 */
+	template<typename... T>
+	inline void print(
+		std::string_view mode_str,
+		const std::string &node_name,
+		const std::string &content,
+		T &&... args) {
+		print(string_to_mode(mode_str), node_name, content, std::forward<T>(args)...);
+	}
+
+	/**
+	 * @brief 编译期等级下限，低于它的 RMCV_LOG 调用连同参数求值一起被去掉
+	 * 由 CMake 选项 RMCV_LOG_MIN_LEVEL 设置，取值为 LOG / INFO / DEBUG / WARNING / ERROR
+	 */
+#ifdef RMCV_LOG_MIN_LEVEL
+	constexpr PrintMode COMPILED_MIN_MODE = PrintMode::RMCV_LOG_MIN_LEVEL;
+#else
+	constexpr PrintMode COMPILED_MIN_MODE = PrintMode::LOG;
+#endif
+	/**
+	 * @brief 为真时单独去掉 DEBUG 等级(它在等级顺序上高于 INFO，无法只靠下限去掉)
+	 */
+#ifdef RMCV_LOG_STRIP_DEBUG
+	constexpr bool STRIP_DEBUG = true;
+#else
+	constexpr bool STRIP_DEBUG = false;
+#endif
+
+	constexpr bool compiled_in(PrintMode mode) {
+		return mode >= COMPILED_MIN_MODE && mode != PrintMode::SILENT && !(STRIP_DEBUG && mode == PrintMode::DEBUG);
+	}
+
+	/**
+	 * @brief 调用点的限频状态，由 RMCV_LOG_ONCE / EVERY_N / EVERY_MS 以函数内静态变量的形式提供，只用原子操作
+	 */
+	struct RateLimit {
+		std::atomic<uint64_t> count{0};
+		std::atomic<int64_t> next_ns{0};
+		std::atomic<uint64_t> suppressed{0};
+
+		/**
+		 * @brief 只有第一次返回 true
+		 */
+		bool once() {
+			return count.load(std::memory_order_relaxed) == 0 && count.fetch_add(1, std::memory_order_relaxed) == 0;
+		}
+
+		/**
+		 * @brief 第 1、n+1、2n+1... 次返回 true
+		 * @param skipped 返回 true 时为上次输出以来被跳过的次数
+		 */
+		bool every_n(uint64_t n, uint64_t &skipped) {
+			const uint64_t index = count.fetch_add(1, std::memory_order_relaxed);
+			if (n <= 1) {
+				skipped = 0;
+				return true;
+			}
+			if (index % n != 0) {
+				return false;
+			}
+			skipped = index == 0 ? 0 : n - 1;
+			return true;
+		}
+
+		/**
+		 * @brief 每 period_ms 毫秒最多返回一次 true
+		 * @param skipped 返回 true 时为上次输出以来被跳过的次数
+		 */
+		bool every_ms(int64_t period_ms, uint64_t &skipped) {
+			const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+			int64_t next = next_ns.load(std::memory_order_relaxed);
+			if (now < next || !next_ns.compare_exchange_strong(next, now + period_ms * 1'000'000,
+			                                                  std::memory_order_relaxed)) {
+				suppressed.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			skipped = suppressed.exchange(0, std::memory_order_relaxed);
+			return true;
+		}
+	};
+
+	/**
+	 * @brief 编译期格式串的输出接口，供 RMCV_LOG 宏使用
+	 * 先做等级和节点过滤，通过后才格式化；异步模式下格式串只存指针；
+	 * 二进制日志开启时只拷贝参数，低于 BINLOG_ECHO_MODE 的日志不再输出文本
+	 */
+	template<PrintMode Mode, typename... T>
+	inline void log(binlog::Site &site, std::string_view node_name, fmt::format_string<T...> format, T &&... args) {
+		if (!should_print(Mode, node_name)) {
+			return;
+		}
+		const fmt::string_view format_view = format;
+		if (binlog::enabled()
+		    && binlog::write(site, static_cast<uint8_t>(Mode), node_name,
+		                     std::string_view(format_view.data(), format_view.size()), args...)
+		    && Mode < BINLOG_ECHO_MODE) {
+			return;
+		}
+		if (async::enabled()) {
+			print_async(Mode, node_name, std::string_view(format_view.data(), format_view.size()), true,
+			            std::forward<T>(args)...);
+			return;
+		}
+		write_line(Mode, node_name, fmt::format(format, std::forward<T>(args)...));
+	}
+}
+
+/**
+ * @brief 格式串在编译期检查；等级低于 RMCV_LOG_MIN_LEVEL 时整条调用(包括参数求值)被去掉
+ * 二进制日志按调用点登记节点名和格式串，同一调用点的节点名应保持不变
+ *
+ *     RMCV_LOG(WARNING, "camera", "exposure {} out of range", exposure);
+ *     RMCV_LOG_DEBUG("detector", "found {} armors", count);
+ */
+#define RMCV_LOG(mode, node, format, ...)                                                         \
+    do {                                                                                          \
+        if constexpr (::debug::compiled_in(::debug::PrintMode::mode)) {                           \
+            static ::debug::binlog::Site rmcv_log_site;                                           \
+            ::debug::log<::debug::PrintMode::mode>(rmcv_log_site, node, FMT_STRING(format),       \
+                                                   ##__VA_ARGS__);                                \
+        }                                                                                         \
+    } while (0)
+
+// 内部使用：有被跳过的调用时在末尾附上 "(suppressed N times)"，format 须为字符串字面量
+#define RMCV_LOG_WITH_SUPPRESSED_(mode, skipped, node, format, ...)                                \
+    do {                                                                                          \
+        if ((skipped) == 0) {                                                                     \
+            RMCV_LOG(mode, node, format, ##__VA_ARGS__);                                          \
+        } else {                                                                                  \
+            RMCV_LOG(mode, node, format " (suppressed {} times)", ##__VA_ARGS__, skipped);        \
+        }                                                                                         \
+    } while (0)
+
+/**
+ * @brief 每个调用点只输出一次
+ */
+#define RMCV_LOG_ONCE(mode, node, format, ...)                                                    \
+    do {                                                                                          \
+        if constexpr (::debug::compiled_in(::debug::PrintMode::mode)) {                           \
+            static ::debug::RateLimit rmcv_log_limit;                                             \
+            if (rmcv_log_limit.once()) {                                                          \
+                RMCV_LOG(mode, node, format, ##__VA_ARGS__);                                      \
+            }                                                                                     \
+        }                                                                                         \
+    } while (0)
+
+/**
+ * @brief 每个调用点每 n 次输出一次，并附上中间跳过的次数
+ */
+#define RMCV_LOG_EVERY_N(mode, n, node, format, ...)                                              \
+    do {                                                                                          \
+        if constexpr (::debug::compiled_in(::debug::PrintMode::mode)) {                           \
+            static ::debug::RateLimit rmcv_log_limit;                                             \
+            uint64_t rmcv_log_skipped = 0;                                                        \
+            if (rmcv_log_limit.every_n((n), rmcv_log_skipped)) {                                  \
+                RMCV_LOG_WITH_SUPPRESSED_(mode, rmcv_log_skipped, node, format, ##__VA_ARGS__);   \
+            }                                                                                     \
+        }                                                                                         \
+    } while (0)
+
+/**
+ * @brief 每个调用点每 ms 毫秒最多输出一次，恢复输出时附上期间被跳过的次数
+ *
+ *     RMCV_LOG_EVERY_MS(ERROR, 1000, "serial", "Error receiving packet: {}", e.what());
+ */
+#define RMCV_LOG_EVERY_MS(mode, ms, node, format, ...)                                            \
+    do {                                                                                          \
+        if constexpr (::debug::compiled_in(::debug::PrintMode::mode)) {                           \
+            static ::debug::RateLimit rmcv_log_limit;                                             \
+            uint64_t rmcv_log_skipped = 0;                                                        \
+            if (rmcv_log_limit.every_ms((ms), rmcv_log_skipped)) {                                \
+                RMCV_LOG_WITH_SUPPRESSED_(mode, rmcv_log_skipped, node, format, ##__VA_ARGS__);   \
+            }                                                                                     \
+        }                                                                                         \
+    } while (0)
+
+#define RMCV_LOG_LOG(node, format, ...) RMCV_LOG(LOG, node, format, ##__VA_ARGS__)
+#define RMCV_LOG_INFO(node, format, ...) RMCV_LOG(INFO, node, format, ##__VA_ARGS__)
+#define RMCV_LOG_DEBUG(node, format, ...) RMCV_LOG(DEBUG, node, format, ##__VA_ARGS__)
+#define RMCV_LOG_WARNING(node, format, ...) RMCV_LOG(WARNING, node, format, ##__VA_ARGS__)
+#define RMCV_LOG_ERROR(node, format, ...) RMCV_LOG(ERROR, node, format, ##__VA_ARGS__)
+
+#endif //PLUGIN_DEBUG_LOGGER_HPP
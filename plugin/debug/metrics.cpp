@@ -0,0 +1,381 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// Source file corresponding header
+#include "metrics.hpp"
+
+// C system headers
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// C++ system headers
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Third-party library headers
+#include <fmt/core.h>
+#include <fmt/format.h>
+
+// Project headers
+#include "plugin/debug/logger.hpp"
+
+namespace debug::metrics {
+	namespace {
+		// 等待 socket 客户端发出请求的时间，超时则按纯文本直接返回
+		constexpr int REQUEST_TIMEOUT_MS = 20;
+		// socket 线程检查退出标志的间隔
+		constexpr int ACCEPT_POLL_MS = 100;
+
+		struct Entry {
+			Type type;
+			std::string help;
+			std::unique_ptr<Counter> counter;
+			std::unique_ptr<Gauge> gauge;
+			std::unique_ptr<Histogram> histogram;
+		};
+
+		struct Registry {
+			std::mutex mutex;
+			std::map<std::string, Entry, std::less<> > entries;
+
+			std::mutex collector_mutex;
+			std::map<uint64_t, std::function<void(std::vector<Sample> &)> > collectors;
+			uint64_t next_collector = 1;
+		};
+
+		Registry &registry() {
+			// 有意不析构，退出时仍在运行的线程可以安全地访问
+			static auto *instance = new Registry();
+			return *instance;
+		}
+
+		struct Exporter {
+			std::mutex mutex;
+			std::condition_variable wake;
+			std::atomic<bool> stopping{false};
+			std::thread file_thread;
+			std::thread socket_thread;
+			std::string socket_path;
+			int listen_fd = -1;
+		};
+
+		Exporter &exporter() {
+			static auto *instance = new Exporter();
+			return *instance;
+		}
+
+		void register_stop() {
+			static const bool registered = (std::atexit(stop_export), true);
+			(void) registered;
+		}
+
+		template<typename Metric>
+		Metric &find_or_create(std::string_view name, std::string_view help, Type type,
+		                       std::unique_ptr<Metric> Entry::*member) {
+			auto &r = registry();
+			std::lock_guard<std::mutex> lock(r.mutex);
+			auto iter = r.entries.find(name);
+			if (iter == r.entries.end()) {
+				Entry entry{type, std::string(help), nullptr, nullptr, nullptr};
+				entry.*member = std::make_unique<Metric>();
+				iter = r.entries.emplace(std::string(name), std::move(entry)).first;
+			}
+			if (iter->second.type != type) {
+				debug::print(PrintMode::ERROR, "metrics", "{} 已登记为其他类型的指标", std::string(name));
+				// 占位对象，更新不会被导出
+				static auto *placeholder = new Metric();
+				return *placeholder;
+			}
+			return *(iter->second.*member);
+		}
+
+		// "name{labels}" 拆为 "name" 和 "labels"
+		std::pair<std::string_view, std::string_view> split_labels(std::string_view name) {
+			const auto brace = name.find('{');
+			if (brace == std::string_view::npos || name.back() != '}') {
+				return {name, {}};
+			}
+			return {name.substr(0, brace), name.substr(brace + 1, name.size() - brace - 2)};
+		}
+
+		void append_value(fmt::memory_buffer &out, double value) {
+			if (std::isnan(value)) {
+				out.append(std::string_view("NaN"));
+			} else if (std::isinf(value)) {
+				out.append(std::string_view(value > 0 ? "+Inf" : "-Inf"));
+			} else {
+				fmt::format_to(std::back_inserter(out), "{}", value);
+			}
+		}
+
+		void append_help(fmt::memory_buffer &out, std::string_view family, std::string_view help) {
+			fmt::format_to(std::back_inserter(out), "# HELP {} ", family);
+			for (const char ch: help) {
+				if (ch == '\\') {
+					out.append(std::string_view("\\\\"));
+				} else if (ch == '\n') {
+					out.append(std::string_view("\\n"));
+				} else {
+					out.push_back(ch);
+				}
+			}
+			out.push_back('\n');
+		}
+
+		bool write_file(const std::string &path, const std::string &text) {
+			const std::string temp = path + ".tmp";
+			std::FILE *file = std::fopen(temp.c_str(), "w");
+			if (file == nullptr) {
+				return false;
+			}
+			const bool written = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+			if (std::fclose(file) != 0 || !written) {
+				return false;
+			}
+			return std::rename(temp.c_str(), path.c_str()) == 0;
+		}
+
+		void send_all(int fd, std::string_view data) {
+			while (!data.empty()) {
+				const ssize_t sent = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+				if (sent <= 0) {
+					return;
+				}
+				data.remove_prefix(static_cast<std::size_t>(sent));
+			}
+		}
+
+		void respond(int client) {
+			char request[512];
+			ssize_t received = 0;
+			pollfd client_poll{client, POLLIN, 0};
+			if (::poll(&client_poll, 1, REQUEST_TIMEOUT_MS) > 0) {
+				received = ::recv(client, request, sizeof(request), MSG_DONTWAIT);
+			}
+			const std::string body = to_prometheus();
+			if (received >= 3 && std::string_view(request, 3) == "GET") {
+				send_all(client, fmt::format("HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+				                             "Content-Length: {}\r\n\r\n", body.size()));
+			}
+			send_all(client, body);
+		}
+	} // namespace
+
+	Counter &counter(std::string_view name, std::string_view help) {
+		return find_or_create(name, help, Type::COUNTER, &Entry::counter);
+	}
+
+	Gauge &gauge(std::string_view name, std::string_view help) {
+		return find_or_create(name, help, Type::GAUGE, &Entry::gauge);
+	}
+
+	Histogram &histogram(std::string_view name, std::string_view help) {
+		return find_or_create(name, help, Type::HISTOGRAM, &Entry::histogram);
+	}
+
+	uint64_t add_collector(std::function<void(std::vector<Sample> &)> collector) {
+		auto &r = registry();
+		std::lock_guard<std::mutex> lock(r.collector_mutex);
+		const uint64_t id = r.next_collector++;
+		r.collectors.emplace(id, std::move(collector));
+		return id;
+	}
+
+	void remove_collector(uint64_t id) {
+		auto &r = registry();
+		// 与 snapshot 互斥，返回后回调不会再被调用
+		std::lock_guard<std::mutex> lock(r.collector_mutex);
+		r.collectors.erase(id);
+	}
+
+	std::vector<Sample> snapshot() {
+		auto &r = registry();
+		std::vector<Sample> samples;
+		{
+			std::lock_guard<std::mutex> lock(r.mutex);
+			samples.reserve(r.entries.size());
+			for (const auto &[name, entry]: r.entries) {
+				Sample sample;
+				sample.name = name;
+				sample.help = entry.help;
+				sample.type = entry.type;
+				switch (entry.type) {
+					case Type::COUNTER:
+						sample.value = static_cast<double>(entry.counter->value());
+						break;
+					case Type::GAUGE:
+						sample.value = entry.gauge->value();
+						break;
+					case Type::HISTOGRAM:
+						sample.buckets.resize(HISTOGRAM_BUCKETS);
+						for (std::size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+							sample.buckets[i] = entry.histogram->bucket(i);
+							sample.count += sample.buckets[i];
+						}
+						sample.sum = entry.histogram->sum();
+						break;
+				}
+				samples.push_back(std::move(sample));
+			}
+		}
+		{
+			std::lock_guard<std::mutex> lock(r.collector_mutex);
+			for (const auto &[id, collector]: r.collectors) {
+				collector(samples);
+			}
+		}
+		std::stable_sort(samples.begin(), samples.end(), [](const Sample &a, const Sample &b) {
+			return split_labels(a.name).first < split_labels(b.name).first;
+		});
+		return samples;
+	}
+
+	std::string to_prometheus(const std::vector<Sample> &samples) {
+		static constexpr const char *TYPE_NAMES[] = {"counter", "gauge", "histogram"};
+		fmt::memory_buffer out;
+		std::string_view last_family;
+		for (const auto &sample: samples) {
+			const auto [family, labels] = split_labels(sample.name);
+			if (family != last_family) {
+				if (!sample.help.empty()) {
+					append_help(out, family, sample.help);
+				}
+				fmt::format_to(std::back_inserter(out), "# TYPE {} {}\n", family,
+				               TYPE_NAMES[static_cast<std::size_t>(sample.type)]);
+				last_family = family;
+			}
+			if (sample.type != Type::HISTOGRAM) {
+				out.append(sample.name);
+				out.push_back(' ');
+				append_value(out, sample.value);
+				out.push_back('\n');
+				continue;
+			}
+			const std::string prefix = labels.empty() ? std::string() : std::string(labels) + ",";
+			const std::string suffix = labels.empty() ? std::string() : "{" + std::string(labels) + "}";
+			// 只输出到最后一个非空桶，第 i 个桶的上界为 2^i - 1；最高的桶只计入 +Inf
+			std::size_t last = 0;
+			for (std::size_t i = 0; i < sample.buckets.size(); ++i) {
+				if (sample.buckets[i] != 0) {
+					last = i;
+				}
+			}
+			uint64_t cumulative = 0;
+			for (std::size_t i = 0; i <= last && i + 1 < sample.buckets.size(); ++i) {
+				cumulative += sample.buckets[i];
+				const uint64_t upper = (uint64_t(1) << i) - 1;
+				fmt::format_to(std::back_inserter(out), "{}_bucket{{{}le=\"{}\"}} {}\n", family, prefix, upper, cumulative);
+			}
+			fmt::format_to(std::back_inserter(out), "{}_bucket{{{}le=\"+Inf\"}} {}\n", family, prefix, sample.count);
+			fmt::format_to(std::back_inserter(out), "{}_sum{} {}\n", family, suffix, sample.sum);
+			fmt::format_to(std::back_inserter(out), "{}_count{} {}\n", family, suffix, sample.count);
+		}
+		return fmt::to_string(out);
+	}
+
+	bool export_file(const std::string &path, std::chrono::milliseconds period) {
+		auto &e = exporter();
+		{
+			std::lock_guard<std::mutex> lock(e.mutex);
+			if (e.file_thread.joinable()) {
+				return false;
+			}
+			e.stopping.store(false, std::memory_order_relaxed);
+			e.file_thread = std::thread([&e, path, period]() {
+				bool reported = false;
+				std::unique_lock<std::mutex> lock(e.mutex);
+				while (!e.stopping.load(std::memory_order_relaxed)) {
+					lock.unlock();
+					if (!write_file(path, to_prometheus()) && !reported) {
+						debug::print(PrintMode::WARNING, "metrics", "无法写入 {}", path);
+						reported = true;
+					}
+					lock.lock();
+					e.wake.wait_for(lock, period, [&e]() { return e.stopping.load(std::memory_order_relaxed); });
+				}
+			});
+		}
+		register_stop();
+		return true;
+	}
+
+	bool serve(const std::string &path) {
+		auto &e = exporter();
+		{
+			std::lock_guard<std::mutex> lock(e.mutex);
+			if (e.socket_thread.joinable()) {
+				return false;
+			}
+			sockaddr_un address{};
+			address.sun_family = AF_UNIX;
+			if (path.size() >= sizeof(address.sun_path)) {
+				debug::print(PrintMode::ERROR, "metrics", "socket 路径过长: {}", path);
+				return false;
+			}
+			std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+			const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+			// 上次运行留下的 socket 文件
+			::unlink(path.c_str());
+			if (fd < 0 || ::bind(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0
+			    || ::listen(fd, 4) != 0) {
+				debug::print(PrintMode::ERROR, "metrics", "无法监听 {}: {}", path, std::strerror(errno));
+				if (fd >= 0) {
+					::close(fd);
+				}
+				return false;
+			}
+			e.listen_fd = fd;
+			e.socket_path = path;
+			e.stopping.store(false, std::memory_order_relaxed);
+			e.socket_thread = std::thread([&e, fd]() {
+				while (!e.stopping.load(std::memory_order_relaxed)) {
+					pollfd listen_poll{fd, POLLIN, 0};
+					if (::poll(&listen_poll, 1, ACCEPT_POLL_MS) <= 0) {
+						continue;
+					}
+					const int client = ::accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+					if (client >= 0) {
+						respond(client);
+						::close(client);
+					}
+				}
+			});
+		}
+		register_stop();
+		return true;
+	}
+
+	void stop_export() {
+		auto &e = exporter();
+		{
+			std::lock_guard<std::mutex> lock(e.mutex);
+			e.stopping.store(true, std::memory_order_relaxed);
+		}
+		e.wake.notify_all();
+		if (e.file_thread.joinable()) {
+			e.file_thread.join();
+		}
+		if (e.socket_thread.joinable()) {
+			e.socket_thread.join();
+		}
+		std::lock_guard<std::mutex> lock(e.mutex);
+		if (e.listen_fd >= 0) {
+			::close(e.listen_fd);
+			::unlink(e.socket_path.c_str());
+			e.listen_fd = -1;
+		}
+	}
+} // namespace debug::metrics
@@ -0,0 +1,215 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef PLUGIN_DEBUG_METRICS_HPP
+#define PLUGIN_DEBUG_METRICS_HPP
+
+// C system headers
+
+// C++ system headers
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Third-party library headers
+
+// Project headers
+
+/**
+ * 运行指标
+ *
+ * 计数器(只增)、仪表(可设为任意值)和按 2 的幂分桶的直方图，在进程内统一登记，可随时取快照，
+ * 也可以按 Prometheus 文本格式定期写入文件或通过本地 Unix socket 供工具抓取。
+ *
+ * 指标对象登记后地址不变且不会释放，热路径上缓存引用，每次更新只有一次 relaxed 原子加法：
+ *
+ *     static auto &drops = debug::metrics::counter("camera_frame_drops_total", "丢弃的帧数");
+ *     drops.add();
+ *
+ * 名字可以带 Prometheus 标签，如 "serial_resyncs_total{link=\"0\"}"，同名不同标签的指标归为一族。
+ */
+namespace debug::metrics {
+	enum class Type : uint8_t {
+		COUNTER,
+		GAUGE,
+		HISTOGRAM
+	};
+
+	// 计数器的分片数，不同线程落在不同缓存行上
+	constexpr std::size_t COUNTER_SHARDS = 16;
+	// 直方图第 i 个桶存放 [2^(i-1), 2^i) 内的值，第 0 个桶存放 0
+	constexpr std::size_t HISTOGRAM_BUCKETS = 65;
+
+	namespace detail {
+		inline std::atomic<std::size_t> next_shard{0};
+
+		/**
+		 * @brief 本线程使用的分片，第一次调用时轮流分配
+		 */
+		inline std::size_t shard_index() noexcept {
+			thread_local const std::size_t index = next_shard.fetch_add(1, std::memory_order_relaxed) % COUNTER_SHARDS;
+			return index;
+		}
+	} // namespace detail
+
+	class Counter {
+	public:
+		void add(uint64_t count = 1) noexcept {
+			_shards[detail::shard_index()].value.fetch_add(count, std::memory_order_relaxed);
+		}
+
+		uint64_t value() const noexcept {
+			uint64_t total = 0;
+			for (const auto &shard: _shards) {
+				total += shard.value.load(std::memory_order_relaxed);
+			}
+			return total;
+		}
+
+	private:
+		struct alignas(64) Shard {
+			std::atomic<uint64_t> value{0};
+		};
+
+		std::array<Shard, COUNTER_SHARDS> _shards;
+	};
+
+	class Gauge {
+	public:
+		void set(double value) noexcept {
+			_bits.store(to_bits(value), std::memory_order_relaxed);
+		}
+
+		void add(double delta) noexcept {
+			uint64_t bits = _bits.load(std::memory_order_relaxed);
+			while (!_bits.compare_exchange_weak(bits, to_bits(from_bits(bits) + delta), std::memory_order_relaxed)) {
+			}
+		}
+
+		double value() const noexcept {
+			return from_bits(_bits.load(std::memory_order_relaxed));
+		}
+
+	private:
+		static uint64_t to_bits(double value) noexcept {
+			uint64_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			return bits;
+		}
+
+		static double from_bits(uint64_t bits) noexcept {
+			double value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		std::atomic<uint64_t> _bits{0};
+	};
+
+	class Histogram {
+	public:
+		/**
+		 * @param value 非负整数，单位写在指标名里，如 "_us"
+		 */
+		void observe(uint64_t value) noexcept {
+			const std::size_t bucket = value == 0 ? 0 : 64 - static_cast<std::size_t>(__builtin_clzll(value));
+			_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+			_sum.fetch_add(value, std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief 把时长换算为 Unit(默认微秒)后记录
+		 */
+		template<typename Unit = std::chrono::microseconds, typename Rep, typename Period>
+		void observe(std::chrono::duration<Rep, Period> duration) noexcept {
+			const auto count = std::chrono::duration_cast<Unit>(duration).count();
+			observe(count > 0 ? static_cast<uint64_t>(count) : 0);
+		}
+
+		uint64_t bucket(std::size_t index) const noexcept {
+			return _buckets[index].load(std::memory_order_relaxed);
+		}
+
+		uint64_t sum() const noexcept {
+			return _sum.load(std::memory_order_relaxed);
+		}
+
+	private:
+		std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKETS> _buckets{};
+		std::atomic<uint64_t> _sum{0};
+	};
+
+	/**
+	 * @brief 某一时刻的指标值
+	 */
+	struct Sample {
+		std::string name;
+		std::string help;
+		Type type = Type::GAUGE;
+		// 计数器和仪表的值
+		double value = 0;
+		// 直方图各桶(非累计)的计数、总数和总和
+		std::vector<uint64_t> buckets;
+		uint64_t count = 0;
+		uint64_t sum = 0;
+	};
+
+	/**
+	 * @brief 取得或登记指标，同名返回同一对象；已登记为其他类型时返回一个不导出的占位对象
+	 * @param help 第一次登记时的说明
+	 */
+	Counter &counter(std::string_view name, std::string_view help = {});
+
+	Gauge &gauge(std::string_view name, std::string_view help = {});
+
+	Histogram &histogram(std::string_view name, std::string_view help = {});
+
+	/**
+	 * @brief 取快照时调用的回调，用于导出已有统计结构中的数值(如 LinkSupervisor::stats())
+	 * @return 用于 remove_collector 的编号
+	 */
+	uint64_t add_collector(std::function<void(std::vector<Sample> &)> collector);
+
+	void remove_collector(uint64_t id);
+
+	/**
+	 * @brief 所有指标的当前值，按名字排序
+	 */
+	std::vector<Sample> snapshot();
+
+	/**
+	 * @brief Prometheus 文本格式(0.0.4)
+	 */
+	std::string to_prometheus(const std::vector<Sample> &samples);
+
+	inline std::string to_prometheus() {
+		return to_prometheus(snapshot());
+	}
+
+	/**
+	 * @brief 由后台线程每 period 把 Prometheus 文本写入 path(先写临时文件再改名，读者不会看到写了一半的内容)
+	 * @return false 已在导出
+	 */
+	bool export_file(const std::string &path, std::chrono::milliseconds period = std::chrono::seconds(1));
+
+	/**
+	 * @brief 在 Unix socket path 上监听，每个连接返回一次当前的 Prometheus 文本后关闭
+	 * 请求以 "GET" 开头时附带 HTTP 响应头，因此 nc -U 和 curl --unix-socket 都能直接抓取
+	 * @return false socket 创建失败或已在监听
+	 */
+	bool serve(const std::string &path);
+
+	/**
+	 * @brief 停止导出线程并删除 socket 文件；进程退出时自动调用
+	 */
+	void stop_export();
+} // namespace debug::metrics
+
+#endif //PLUGIN_DEBUG_METRICS_HPP
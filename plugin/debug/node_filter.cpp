@@ -0,0 +1,162 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// Source file corresponding header
+#include "node_filter.hpp"
+
+// C system headers
+
+// C++ system headers
+#include <array>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+// Third-party library headers
+
+// Project headers
+
+namespace debug::node_filter {
+	namespace {
+		// 开放寻址表的槽数，2 的幂，留足空位使探测很短
+		constexpr std::size_t TABLE_SIZE = 1024;
+		// 登记满后仍为新名字占用槽位，直到表用去一半
+		constexpr std::size_t MAX_ENTRIES = TABLE_SIZE / 2;
+
+		struct Entry {
+			std::string name;
+			NodeId id;
+		};
+
+		struct State {
+			std::array<std::atomic<const Entry *>, TABLE_SIZE> table{};
+			std::mutex mutex;
+			// 下面的成员只在持有 mutex 时访问
+			std::vector<std::unique_ptr<Entry> > entries;
+			std::size_t next_id = 0;
+			std::vector<std::unique_ptr<Rules> > rules;
+			bool overflow_reported = false;
+		};
+
+		State &state() {
+			// 有意不析构，退出时仍在打日志的线程可以安全地访问
+			static auto *instance = new State();
+			return *instance;
+		}
+
+		std::size_t slot_of(std::string_view name) {
+			return std::hash<std::string_view>{}(name) & (TABLE_SIZE - 1);
+		}
+
+		/**
+		 * @brief 无锁查找，找到时返回条目，否则返回 nullptr 并在 slot 中给出可插入的位置
+		 */
+		const Entry *find(const State &s, std::string_view name, std::size_t &slot) {
+			slot = slot_of(name);
+			while (true) {
+				const Entry *entry = s.table[slot].load(std::memory_order_acquire);
+				if (entry == nullptr || entry->name == name) {
+					return entry;
+				}
+				slot = (slot + 1) & (TABLE_SIZE - 1);
+			}
+		}
+
+		/**
+		 * @brief 调用方持有 mutex
+		 */
+		NodeId intern_locked(State &s, std::string_view name) {
+			std::size_t slot;
+			if (const Entry *entry = find(s, name, slot)) {
+				return entry->id;
+			}
+			if (s.entries.size() >= MAX_ENTRIES) {
+				return OVERFLOW_ID;
+			}
+			NodeId id = OVERFLOW_ID;
+			if (s.next_id < OVERFLOW_ID) {
+				id = static_cast<NodeId>(s.next_id++);
+			} else if (!s.overflow_reported) {
+				// 这里不能再打日志，否则会递归进入过滤
+				std::fprintf(stderr, "node_filter: more than %zu log nodes, \"%.*s\" and later ones share one id\n",
+				             MAX_NODES - 1, static_cast<int>(name.size()), name.data());
+				s.overflow_reported = true;
+			}
+			s.entries.push_back(std::make_unique<Entry>(Entry{std::string(name), id}));
+			s.table[slot].store(s.entries.back().get(), std::memory_order_release);
+			return id;
+		}
+
+		/**
+		 * @brief 在当前名单的副本上修改后整体发布，调用方持有 mutex
+		 */
+		template<typename Modify>
+		void publish(State &s, Modify &&modify) {
+			const Rules *current = current_rules.load(std::memory_order_acquire);
+			auto next = std::make_unique<Rules>(current != nullptr ? *current : Rules{});
+			modify(*next);
+			next->whitelist_active = next->white.any();
+			if (!next->whitelist_active && next->black.none()) {
+				current_rules.store(nullptr, std::memory_order_release);
+				return;
+			}
+			current_rules.store(next.get(), std::memory_order_release);
+			s.rules.push_back(std::move(next));
+		}
+	} // namespace
+
+	NodeId intern(std::string_view name) {
+		auto &s = state();
+		std::size_t slot;
+		if (const Entry *entry = find(s, name, slot)) {
+			return entry->id;
+		}
+		std::lock_guard<std::mutex> lock(s.mutex);
+		return intern_locked(s, name);
+	}
+
+	void set_whitelist(const std::vector<std::string> &nodes) {
+		auto &s = state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		publish(s, [&s, &nodes](Rules &rules) {
+			rules.white.reset();
+			for (const auto &node: nodes) {
+				rules.white.set(intern_locked(s, node));
+			}
+		});
+	}
+
+	void set_blacklist(const std::vector<std::string> &nodes) {
+		auto &s = state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		publish(s, [&s, &nodes](Rules &rules) {
+			rules.black.reset();
+			for (const auto &node: nodes) {
+				rules.black.set(intern_locked(s, node));
+			}
+		});
+	}
+
+	void add_white(std::string_view node) {
+		auto &s = state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		publish(s, [&s, node](Rules &rules) { rules.white.set(intern_locked(s, node)); });
+	}
+
+	void add_black(std::string_view node) {
+		auto &s = state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		publish(s, [&s, node](Rules &rules) { rules.black.set(intern_locked(s, node)); });
+	}
+
+	void clear() {
+		auto &s = state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		publish(s, [](Rules &rules) {
+			rules.white.reset();
+			rules.black.reset();
+		});
+	}
+} // namespace debug::node_filter
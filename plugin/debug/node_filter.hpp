@@ -0,0 +1,81 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef PLUGIN_DEBUG_NODE_FILTER_HPP
+#define PLUGIN_DEBUG_NODE_FILTER_HPP
+
+// C system headers
+
+// C++ system headers
+#include <atomic>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Third-party library headers
+
+// Project headers
+
+/**
+ * 日志的节点过滤，全进程一份
+ *
+ * 节点名第一次出现时登记为编号，之后查编号只读一张开放寻址表，不加锁、不分配内存。
+ * 白名单和黑名单保存为按编号索引的位图，修改时整体换成新的一份，读端只做一次原子读和两次位测试。
+ * 没有设置任何名单时不查表。
+ */
+namespace debug::node_filter {
+	using NodeId = uint16_t;
+
+	constexpr std::size_t MAX_NODES = 256;
+	// 登记满后出现的节点共用这个编号，名单对它们整体生效
+	constexpr NodeId OVERFLOW_ID = MAX_NODES - 1;
+
+	struct Rules {
+		std::bitset<MAX_NODES> white;
+		std::bitset<MAX_NODES> black;
+		// 白名单非空，未列出的节点(包括之后才出现的)都不输出
+		bool whitelist_active = false;
+
+		bool allows(NodeId id) const noexcept {
+			return !black.test(id) && (!whitelist_active || white.test(id));
+		}
+	};
+
+	// 为空表示不过滤；旧的 Rules 在进程结束前不释放，读端拿到的指针始终有效
+	inline std::atomic<const Rules *> current_rules{nullptr};
+
+	/**
+	 * @brief 节点名对应的编号，已登记的节点不加锁
+	 */
+	NodeId intern(std::string_view name);
+
+	inline bool allowed(std::string_view node_name) {
+		const Rules *rules = current_rules.load(std::memory_order_acquire);
+		return rules == nullptr || rules->allows(intern(node_name));
+	}
+
+	/**
+	 * @brief 整体替换白名单，为空时不限制
+	 */
+	void set_whitelist(const std::vector<std::string> &nodes);
+
+	void set_blacklist(const std::vector<std::string> &nodes);
+
+	/**
+	 * @brief 在现有名单上追加一个节点
+	 */
+	void add_white(std::string_view node);
+
+	void add_black(std::string_view node);
+
+	/**
+	 * @brief 清空两个名单
+	 */
+	void clear();
+} // namespace debug::node_filter
+
+#endif //PLUGIN_DEBUG_NODE_FILTER_HPP
@@ -0,0 +1,360 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// Source file corresponding header
+#include "profile.hpp"
+
+// C system headers
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// C++ system headers
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Third-party library headers
+#include <fmt/core.h>
+
+// Project headers
+#include "plugin/debug/log_file.hpp"
+#include "plugin/debug/logger.hpp"
+
+namespace debug::profile {
+	namespace {
+		struct Sample {
+			uint64_t ticks;
+			std::array<uint64_t, EVENT_COUNT> events;
+		};
+
+		/**
+		 * @brief 一个线程中一个区段最近的样本
+		 */
+		struct Series {
+			std::vector<Sample> samples;
+			// 累计样本数，超过容量后覆盖最旧的
+			uint64_t count = 0;
+		};
+
+		struct ThreadData {
+			std::string name;
+			long tid = 0;
+			// 计数器组的组长，-1 表示只计时
+			int perf_fd = -1;
+			bool has_events = false;
+			// 只保护 regions，记录线程与 report() 之间几乎不会竞争
+			std::atomic_flag busy = ATOMIC_FLAG_INIT;
+			std::vector<Series> regions;
+
+			void lock() noexcept {
+				while (busy.test_and_set(std::memory_order_acquire)) {
+				}
+			}
+
+			void unlock() noexcept {
+				busy.clear(std::memory_order_release);
+			}
+		};
+
+		struct State {
+			std::mutex mutex;
+			// 下面的成员只在持有 mutex 时访问
+			Options options;
+			std::vector<std::unique_ptr<ThreadData> > threads;
+			std::vector<const char *> names;
+			bool calibrated = false;
+			bool warned = false;
+			bool exit_registered = false;
+			std::atomic<std::size_t> capacity{Options{}.samples_per_region};
+			// 计时器每纳秒的计数，start() 时写入
+			std::atomic<double> ticks_per_ns{1.0};
+		};
+
+		State &state() {
+			// 有意不析构，退出时仍在运行的线程可以安全地访问
+			static auto *instance = new State();
+			return *instance;
+		}
+
+		int open_event(uint64_t config, int group_fd) {
+			perf_event_attr attr{};
+			attr.size = sizeof(attr);
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = config;
+			// 只统计用户态，perf_event_paranoid <= 2 时普通用户即可打开
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			attr.disabled = group_fd == -1 ? 1 : 0;
+			attr.read_format = PERF_FORMAT_GROUP;
+			return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+		}
+
+		std::string read_paranoid() {
+			std::ifstream file("/proc/sys/kernel/perf_event_paranoid");
+			std::string value;
+			file >> value;
+			return value.empty() ? "?" : value;
+		}
+
+		/**
+		 * @brief 为本线程打开指令数、缓存未命中、分支预测失败三个计数器，组内同时启停
+		 * @return 组长的 fd，失败时为 -1
+		 */
+		int open_counters() {
+			const int leader = open_event(PERF_COUNT_HW_INSTRUCTIONS, -1);
+			if (leader < 0) {
+				return -1;
+			}
+			const int cache = open_event(PERF_COUNT_HW_CACHE_MISSES, leader);
+			const int branch = cache < 0 ? -1 : open_event(PERF_COUNT_HW_BRANCH_MISSES, leader);
+			if (cache < 0 || branch < 0) {
+				if (cache >= 0) {
+					close(cache);
+				}
+				close(leader);
+				return -1;
+			}
+			// 组员的 fd 随线程结束由内核回收，读数全部经由组长
+			ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+			ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+			return leader;
+		}
+
+		bool read_counters(int fd, std::array<uint64_t, EVENT_COUNT> &events) noexcept {
+			// PERF_FORMAT_GROUP: nr, value[nr]
+			uint64_t buffer[1 + EVENT_COUNT];
+			if (read(fd, buffer, sizeof(buffer)) != static_cast<ssize_t>(sizeof(buffer)) || buffer[0] != EVENT_COUNT) {
+				return false;
+			}
+			std::copy(buffer + 1, buffer + 1 + EVENT_COUNT, events.begin());
+			return true;
+		}
+
+		/**
+		 * @brief 线程结束时关闭计数器，样本留给 report()
+		 */
+		struct LocalHolder {
+			ThreadData *data = nullptr;
+
+			~LocalHolder() {
+				if (data != nullptr && data->perf_fd >= 0) {
+					close(data->perf_fd);
+					data->perf_fd = -1;
+				}
+			}
+		};
+
+		ThreadData &local() {
+			thread_local LocalHolder holder;
+			if (holder.data != nullptr) {
+				return *holder.data;
+			}
+			auto &s = state();
+			auto data = std::make_unique<ThreadData>();
+			data->tid = static_cast<long>(syscall(SYS_gettid));
+			data->name = fmt::format("tid {}", data->tid);
+			std::lock_guard<std::mutex> lock(s.mutex);
+			if (s.options.hardware_counters) {
+				data->perf_fd = open_counters();
+				data->has_events = data->perf_fd >= 0;
+				if (!data->has_events && !s.warned) {
+					s.warned = true;
+					debug::print(PrintMode::WARNING, "profile", "无法打开硬件计数器(perf_event_paranoid = {})，只统计耗时",
+					             read_paranoid());
+				}
+			}
+			holder.data = data.get();
+			s.threads.push_back(std::move(data));
+			return *holder.data;
+		}
+
+		uint32_t register_site(Site &site) {
+			auto &s = state();
+			std::lock_guard<std::mutex> lock(s.mutex);
+			uint32_t id = site.id.load(std::memory_order_acquire);
+			if (id == 0) {
+				s.names.push_back(site.name);
+				id = static_cast<uint32_t>(s.names.size());
+				site.id.store(id, std::memory_order_release);
+			}
+			return id;
+		}
+
+		/**
+		 * @brief 以 CLOCK_MONOTONIC 为参照测量计时器的频率
+		 */
+		void calibrate(State &s) {
+			const int64_t ns_start = timestamp::now_ns(timestamp::Clock::MONOTONIC);
+			const uint64_t ticks_start = ticks();
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			const int64_t ns_end = timestamp::now_ns(timestamp::Clock::MONOTONIC);
+			const uint64_t ticks_end = ticks();
+			if (ns_end > ns_start && ticks_end > ticks_start) {
+				s.ticks_per_ns.store(static_cast<double>(ticks_end - ticks_start) / static_cast<double>(ns_end - ns_start));
+			}
+			s.calibrated = true;
+		}
+
+		template<typename T>
+		T percentile(std::vector<T> &values, double p) {
+			const auto index = static_cast<std::size_t>(p * static_cast<double>(values.size() - 1) + 0.5);
+			std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index), values.end());
+			return values[index];
+		}
+
+		/**
+		 * @brief "p50 / p90 / p99 / max"
+		 */
+		template<typename T>
+		std::string summary(std::vector<T> values) {
+			const T p50 = percentile(values, 0.50);
+			const T p90 = percentile(values, 0.90);
+			const T p99 = percentile(values, 0.99);
+			const T max = *std::max_element(values.begin(), values.end());
+			return fmt::format("{:.0f} / {:.0f} / {:.0f} / {:.0f}", static_cast<double>(p50), static_cast<double>(p90),
+			                   static_cast<double>(p99), static_cast<double>(max));
+		}
+	} // namespace
+
+	double ticks_to_ns(uint64_t ticks) noexcept {
+		return static_cast<double>(ticks) / state().ticks_per_ns.load(std::memory_order_relaxed);
+	}
+
+	Reading begin() noexcept {
+		auto &data = local();
+		Reading reading;
+		// 先读计数器再读时间，系统调用本身不计入耗时
+		if (data.perf_fd >= 0) {
+			reading.has_events = read_counters(data.perf_fd, reading.events);
+		}
+		reading.ticks = ticks();
+		return reading;
+	}
+
+	void end(Site &site, const Reading &start) noexcept {
+		const uint64_t now = ticks();
+		auto &data = local();
+		Sample sample{now - start.ticks, {}};
+		if (start.has_events) {
+			std::array<uint64_t, EVENT_COUNT> events{};
+			if (read_counters(data.perf_fd, events)) {
+				for (std::size_t i = 0; i < EVENT_COUNT; ++i) {
+					sample.events[i] = events[i] - start.events[i];
+				}
+			}
+		}
+		uint32_t id = site.id.load(std::memory_order_acquire);
+		if (id == 0) {
+			id = register_site(site);
+		}
+		const std::size_t capacity = state().capacity.load(std::memory_order_relaxed);
+		data.lock();
+		if (data.regions.size() < id) {
+			data.regions.resize(id);
+		}
+		auto &series = data.regions[id - 1];
+		if (series.samples.size() < capacity) {
+			series.samples.push_back(sample);
+		} else {
+			series.samples[series.count % capacity] = sample;
+		}
+		++series.count;
+		data.unlock();
+	}
+
+	bool start(const Options &options) {
+		auto &s = state();
+		{
+			std::lock_guard<std::mutex> lock(s.mutex);
+			s.options = options;
+			s.capacity.store(std::max<std::size_t>(options.samples_per_region, 1), std::memory_order_relaxed);
+			if (!s.calibrated) {
+				calibrate(s);
+			}
+			if (options.report_at_exit && !s.exit_registered) {
+				s.exit_registered = true;
+				std::atexit(print_report);
+			}
+		}
+		const bool has_events = local().has_events;
+		active.store(true, std::memory_order_relaxed);
+		return has_events;
+	}
+
+	void stop() {
+		active.store(false, std::memory_order_relaxed);
+	}
+
+	void reset() {
+		auto &s = state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		for (auto &data: s.threads) {
+			data->lock();
+			data->regions.clear();
+			data->unlock();
+		}
+	}
+
+	void set_thread_name(std::string_view name) {
+		auto &data = local();
+		std::lock_guard<std::mutex> lock(state().mutex);
+		data.name = std::string(name);
+	}
+
+	std::string report() {
+		auto &s = state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		std::string text;
+		for (const auto &data: s.threads) {
+			data->lock();
+			const std::vector<Series> regions = data->regions;
+			data->unlock();
+			if (regions.empty()) {
+				continue;
+			}
+			text += fmt::format("{}{}\n", data->name, data->has_events ? "" : " (无硬件计数)");
+			text += fmt::format("  {:<24} {:>8}  {:<14} p50 / p90 / p99 / max\n", "region", "n", "");
+			for (std::size_t i = 0; i < regions.size(); ++i) {
+				const auto &samples = regions[i].samples;
+				if (samples.empty()) {
+					continue;
+				}
+				std::vector<double> time_ns(samples.size());
+				std::transform(samples.begin(), samples.end(), time_ns.begin(), [](const Sample &sample) {
+					return ticks_to_ns(sample.ticks);
+				});
+				text += fmt::format("  {:<24} {:>8}  {:<14} {}\n", s.names[i], regions[i].count, "time_ns",
+				                    summary(std::move(time_ns)));
+				if (!data->has_events) {
+					continue;
+				}
+				constexpr std::array<const char *, EVENT_COUNT> EVENT_NAMES = {"instructions", "cache-misses", "branch-misses"};
+				for (std::size_t event = 0; event < EVENT_COUNT; ++event) {
+					std::vector<uint64_t> values(samples.size());
+					std::transform(samples.begin(), samples.end(), values.begin(), [event](const Sample &sample) {
+						return sample.events[event];
+					});
+					text += fmt::format("  {:<24} {:>8}  {:<14} {}\n", "", "", EVENT_NAMES[event],
+					                    summary(std::move(values)));
+				}
+			}
+		}
+		return text.empty() ? "没有样本\n" : text;
+	}
+
+	void print_report() {
+		// 不经过日志等级：退出时二进制日志可能仍开着，INFO 只会进二进制文件
+		const std::string text = fmt::format("## profile report\n{}", report());
+		fmt::print("{}", text);
+		std::fflush(stdout);
+		logfile::write(text, true);
+	}
+} // namespace debug::profile
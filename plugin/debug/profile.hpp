@@ -0,0 +1,186 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef PLUGIN_DEBUG_PROFILE_HPP
+#define PLUGIN_DEBUG_PROFILE_HPP
+
+// C system headers
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// C++ system headers
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Third-party library headers
+
+// Project headers
+#include "plugin/debug/timestamp.hpp"
+
+/**
+ * 热路径的逐段计时与硬件计数
+ *
+ * PROFILE_REGION 统计一段代码每次执行的耗时，以及(权限允许时)这段时间内本线程的指令数、缓存未命中数和分支预测失败数。
+ * 耗时用时间戳计数器(x86 为 TSC，aarch64 为 CNTVCT)读取，start() 时与 CLOCK_MONOTONIC 校准换算为纳秒；
+ * 硬件计数用 perf_event_open 为每个线程打开一组只统计用户态的计数器，
+ * 因此 perf_event_paranoid <= 2 时无需特权。打不开时该线程只计时。
+ *
+ * 样本按线程、按区段保存最近 samples_per_region 个，report() 汇总出各线程各区段的分位数，
+ * 默认在进程退出时输出一次。
+ *
+ * 与 TRACE_SCOPE 的区别：追踪看时间线上的先后关系，这里看同一段代码反复执行的分布。
+ * 未开启时每个埋点只有一次原子读；CMake 选项 RMCV_PROFILE_STRIP 可以把埋点整体编译掉。
+ * 区段名只保存指针，必须是字符串字面量。
+ */
+namespace debug::profile {
+	enum class Event : uint8_t {
+		INSTRUCTIONS,
+		CACHE_MISSES,
+		BRANCH_MISSES
+	};
+
+	constexpr std::size_t EVENT_COUNT = 3;
+
+	struct Options {
+		// 是否尝试打开硬件计数器
+		bool hardware_counters = true;
+		// 每个线程每个区段保留的最近样本数
+		std::size_t samples_per_region = 4096;
+		// 进程退出时输出 report()
+		bool report_at_exit = true;
+	};
+
+	inline std::atomic<bool> active{false};
+
+	inline bool enabled() noexcept {
+		return active.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief 时间戳计数器的原始值，用 ticks_to_ns 换算
+	 */
+	inline uint64_t ticks() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#elif defined(__aarch64__)
+		uint64_t value;
+		asm volatile("isb; mrs %0, cntvct_el0" : "=r"(value));
+		return value;
+#else
+		return static_cast<uint64_t>(timestamp::now_ns(timestamp::Clock::MONOTONIC));
+#endif
+	}
+
+	/**
+	 * @brief 按 start() 时的校准结果换算为纳秒
+	 */
+	double ticks_to_ns(uint64_t ticks) noexcept;
+
+	/**
+	 * @brief 区段的调用点，由 PROFILE_REGION 以函数内静态变量的形式提供
+	 */
+	struct Site {
+		const char *name;
+		// 0 表示尚未登记
+		std::atomic<uint32_t> id{0};
+	};
+
+	/**
+	 * @brief 区段开始时的读数
+	 */
+	struct Reading {
+		uint64_t ticks = 0;
+		// 本线程没有硬件计数器时不读取
+		std::array<uint64_t, EVENT_COUNT> events{};
+		bool has_events = false;
+	};
+
+	/**
+	 * @brief 读取本线程的计数器，首次调用时为本线程打开计数器并登记样本缓冲区
+	 */
+	Reading begin() noexcept;
+
+	/**
+	 * @brief 把从 start 到现在的差值记为 site 的一个样本
+	 */
+	void end(Site &site, const Reading &start) noexcept;
+
+	/**
+	 * @brief 校准计时器并开始统计，可重复调用
+	 * @return 是否至少能为调用线程打开硬件计数器
+	 */
+	bool start(const Options &options = {});
+
+	void stop();
+
+	/**
+	 * @brief 清空所有线程的样本
+	 */
+	void reset();
+
+	/**
+	 * @brief 设置本线程在报告中显示的名字
+	 */
+	void set_thread_name(std::string_view name);
+
+	/**
+	 * @brief 各线程各区段的样本数以及耗时、硬件计数的 p50 / p90 / p99 / max
+	 */
+	std::string report();
+
+	/**
+	 * @brief 把 report() 直接输出到标准输出和文本日志文件，不受日志等级和二进制日志影响
+	 */
+	void print_report();
+
+	/**
+	 * @brief 构造时读数、析构时记录；构造时未开启则整段不记录
+	 */
+	class Region {
+	public:
+		explicit Region(Site &site) noexcept : _site(enabled() ? &site : nullptr) {
+			if (_site != nullptr) {
+				_start = begin();
+			}
+		}
+
+		~Region() {
+			if (_site != nullptr) {
+				end(*_site, _start);
+			}
+		}
+
+		Region(const Region &) = delete;
+
+		Region &operator=(const Region &) = delete;
+
+	private:
+		Site *_site;
+		Reading _start;
+	};
+} // namespace debug::profile
+
+#define RMCV_PROFILE_CONCAT_(a, b) a##b
+#define RMCV_PROFILE_CONCAT(a, b) RMCV_PROFILE_CONCAT_(a, b)
+
+#ifdef RMCV_PROFILE_STRIP
+#define PROFILE_REGION(name) do {} while (0)
+#else
+/**
+ * @brief 统计从此处到所在作用域结束的耗时和硬件计数
+ *
+ *     PROFILE_REGION("camera.debayer");
+ */
+#define PROFILE_REGION(name)                                                                      \
+    static ::debug::profile::Site RMCV_PROFILE_CONCAT(rmcv_profile_site_, __LINE__){name};        \
+    ::debug::profile::Region RMCV_PROFILE_CONCAT(rmcv_profile_region_, __LINE__)(                 \
+        RMCV_PROFILE_CONCAT(rmcv_profile_site_, __LINE__))
+#endif
+
+#endif //PLUGIN_DEBUG_PROFILE_HPP
@@ -0,0 +1,126 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef PLUGIN_DEBUG_TIMESTAMP_HPP
+#define PLUGIN_DEBUG_TIMESTAMP_HPP
+
+// C system headers
+#include <time.h>
+
+// C++ system headers
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+// Third-party library headers
+
+// Project headers
+
+/**
+ * 日志时间戳
+ *
+ * 墙上时间的 "HH:MM:SS" 部分按线程缓存，只在秒数变化时调用一次 localtime_r，
+ * 毫秒和微秒部分用整数直接写出，不经过 fmt 和 std::localtime(后者不是线程安全的)。
+ * 切换为单调时钟后，时间戳与帧、串口包使用的 steady_clock 一致，便于对齐。
+ */
+namespace debug::timestamp {
+	enum class Clock : uint8_t {
+		// 本地时间 "HH:MM:SS.mmm,uuu"
+		WALL,
+		// CLOCK_MONOTONIC 秒数 "SSSSS.mmm,uuu"
+		MONOTONIC
+	};
+
+	// "HH:MM:SS.mmm,uuu" 为 16 字节，单调时钟的秒数最多 20 位
+	constexpr std::size_t MAX_SIZE = 32;
+
+	inline std::atomic<Clock> current_clock{Clock::WALL};
+
+	inline void use_clock(Clock clock) {
+		current_clock.store(clock, std::memory_order_relaxed);
+	}
+
+	inline Clock clock() {
+		return current_clock.load(std::memory_order_relaxed);
+	}
+
+	inline int64_t now_ns(Clock clock) {
+		timespec ts{};
+		clock_gettime(clock == Clock::WALL ? CLOCK_REALTIME : CLOCK_MONOTONIC, &ts);
+		return static_cast<int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+	}
+
+	namespace detail {
+		inline char *write_digits(char *out, uint64_t value, int width) {
+			for (int i = width - 1; i >= 0; --i) {
+				out[i] = static_cast<char>('0' + value % 10);
+				value /= 10;
+			}
+			return out + width;
+		}
+
+		inline char *write_uint(char *out, uint64_t value) {
+			char digits[20];
+			int size = 0;
+			do {
+				digits[size++] = static_cast<char>('0' + value % 10);
+				value /= 10;
+			} while (value != 0);
+			while (size > 0) {
+				*out++ = digits[--size];
+			}
+			return out;
+		}
+
+		struct WallCache {
+			int64_t second = std::numeric_limits<int64_t>::min();
+			char text[8];
+		};
+	} // namespace detail
+
+	/**
+	 * @brief 把 now_ns 得到的时间写入 out，不分配内存
+	 * @param out 至少 MAX_SIZE 字节
+	 * @return 写入的长度
+	 */
+	inline std::size_t format(int64_t ns, Clock clock, char *out) {
+		const int64_t second = ns / 1'000'000'000;
+		const auto microseconds = static_cast<uint64_t>(ns / 1000 % 1'000'000);
+		char *cursor = out;
+		if (clock == Clock::WALL) {
+			thread_local detail::WallCache cache;
+			if (cache.second != second) {
+				const auto seconds = static_cast<time_t>(second);
+				tm local{};
+				localtime_r(&seconds, &local);
+				char *hms = cache.text;
+				hms = detail::write_digits(hms, local.tm_hour, 2);
+				*hms++ = ':';
+				hms = detail::write_digits(hms, local.tm_min, 2);
+				*hms++ = ':';
+				detail::write_digits(hms, local.tm_sec, 2);
+				cache.second = second;
+			}
+			for (const char ch: cache.text) {
+				*cursor++ = ch;
+			}
+		} else {
+			cursor = detail::write_uint(cursor, static_cast<uint64_t>(second));
+		}
+		*cursor++ = '.';
+		cursor = detail::write_digits(cursor, microseconds / 1000, 3);
+		*cursor++ = ',';
+		cursor = detail::write_digits(cursor, microseconds % 1000, 3);
+		return static_cast<std::size_t>(cursor - out);
+	}
+
+	inline std::string to_string(int64_t ns, Clock clock) {
+		char text[MAX_SIZE];
+		return std::string(text, format(ns, clock, text));
+	}
+} // namespace debug::timestamp
+
+#endif //PLUGIN_DEBUG_TIMESTAMP_HPP
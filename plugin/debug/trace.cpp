@@ -0,0 +1,388 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// Source file corresponding header
+#include "trace.hpp"
+
+// C system headers
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// C++ system headers
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Third-party library headers
+#include <fmt/core.h>
+#include <fmt/format.h>
+
+// Project headers
+
+namespace debug::trace {
+	namespace {
+		// 已退出线程的缓冲区最多保留的个数，供 dump() 查看
+		constexpr std::size_t MAX_RETIRED_RINGS = 16;
+
+		/**
+		 * @brief 事件槽，seq 为奇数表示正在写入；各字段用 relaxed 原子变量，读者按顺序锁的方式校验
+		 */
+		struct Slot {
+			std::atomic<uint64_t> seq{0};
+			std::atomic<int64_t> timestamp_ns{0};
+			std::atomic<int64_t> value{0};
+			std::atomic<const char *> name{nullptr};
+			std::atomic<Phase> phase{Phase::INSTANT};
+		};
+
+		struct Event {
+			Phase phase;
+			const char *name;
+			int64_t timestamp_ns;
+			int64_t value;
+		};
+
+		/**
+		 * @brief 单写者多读者的覆盖式环形缓冲区，写者从不等待
+		 */
+		class Ring {
+		public:
+			Ring(std::size_t capacity, uint32_t thread_id)
+				: _slots(new Slot[capacity]), _capacity(capacity), _mask(capacity - 1), _thread_id(thread_id) {
+			}
+
+			// 所属线程调用
+			void push(Phase phase, const char *name, int64_t timestamp_ns, int64_t value) noexcept {
+				const uint64_t index = _head.load(std::memory_order_relaxed);
+				Slot &slot = _slots[index & _mask];
+				slot.seq.store(index * 2 + 1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+				slot.timestamp_ns.store(timestamp_ns, std::memory_order_relaxed);
+				slot.value.store(value, std::memory_order_relaxed);
+				slot.name.store(name, std::memory_order_relaxed);
+				slot.phase.store(phase, std::memory_order_relaxed);
+				slot.seq.store(index * 2 + 2, std::memory_order_release);
+				_head.store(index + 1, std::memory_order_release);
+			}
+
+			/**
+			 * @brief 读出 [from, head) 中仍未被覆盖的事件
+			 * @param overwritten 加上已被覆盖而读不到的事件数
+			 * @return 读取时的 head，作为下次的 from
+			 */
+			template<typename F>
+			uint64_t read(uint64_t from, uint64_t &overwritten, F &&callback) const {
+				const uint64_t head = _head.load(std::memory_order_acquire);
+				if (head - from > _capacity) {
+					overwritten += head - from - _capacity;
+					from = head - _capacity;
+				}
+				for (uint64_t index = from; index < head; ++index) {
+					const Slot &slot = _slots[index & _mask];
+					const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+					if (seq != index * 2 + 2) {
+						++overwritten;
+						continue;
+					}
+					const Event event{
+						slot.phase.load(std::memory_order_relaxed),
+						slot.name.load(std::memory_order_relaxed),
+						slot.timestamp_ns.load(std::memory_order_relaxed),
+						slot.value.load(std::memory_order_relaxed)
+					};
+					std::atomic_thread_fence(std::memory_order_acquire);
+					if (slot.seq.load(std::memory_order_relaxed) != seq) {
+						++overwritten;
+						continue;
+					}
+					callback(event);
+				}
+				return head;
+			}
+
+			uint64_t head() const noexcept {
+				return _head.load(std::memory_order_acquire);
+			}
+
+			uint32_t thread_id() const noexcept {
+				return _thread_id;
+			}
+
+			void close() noexcept {
+				_closed.store(true, std::memory_order_release);
+			}
+
+			bool closed() const noexcept {
+				return _closed.load(std::memory_order_acquire);
+			}
+
+			// 以下由 State::mutex 保护
+			std::string name;
+			std::string written_name;
+			uint64_t cursor = 0;
+
+		private:
+			std::unique_ptr<Slot[]> _slots;
+			std::size_t _capacity;
+			std::size_t _mask;
+			uint32_t _thread_id;
+			std::atomic<uint64_t> _head{0};
+			std::atomic<bool> _closed{false};
+		};
+
+		struct State {
+			std::mutex mutex;
+			std::vector<std::shared_ptr<Ring> > rings;
+			std::size_t capacity = 1 << 14;
+
+			// 持续写出
+			std::FILE *file = nullptr;
+			bool first_event = true;
+			bool stopping = false;
+			std::condition_variable wake;
+			std::thread writer;
+			uint64_t overwritten = 0;
+		};
+
+		State &state() {
+			// 有意不析构，退出时仍在运行的线程可以安全地访问
+			static auto *instance = new State();
+			return *instance;
+		}
+
+		/**
+		 * @brief 线程退出时标记缓冲区关闭
+		 */
+		struct ThreadRing {
+			std::shared_ptr<Ring> ring;
+
+			~ThreadRing() {
+				if (ring != nullptr) {
+					ring->close();
+				}
+			}
+		};
+
+		thread_local ThreadRing thread_ring;
+		// 未开始记录时设置的线程名先存在这里，创建缓冲区时带上
+		thread_local std::string thread_name;
+
+		Ring &this_ring() {
+			if (thread_ring.ring == nullptr) {
+				auto &s = state();
+				std::lock_guard<std::mutex> lock(s.mutex);
+				const auto retired = std::count_if(s.rings.begin(), s.rings.end(),
+				                                   [](const auto &ring) { return ring->closed(); });
+				if (retired >= static_cast<long>(MAX_RETIRED_RINGS)) {
+					s.rings.erase(std::find_if(s.rings.begin(), s.rings.end(),
+					                           [](const auto &ring) { return ring->closed(); }));
+				}
+				thread_ring.ring = std::make_shared<Ring>(s.capacity, static_cast<uint32_t>(::syscall(SYS_gettid)));
+				thread_ring.ring->name = thread_name;
+				s.rings.push_back(thread_ring.ring);
+			}
+			return *thread_ring.ring;
+		}
+
+		void append_json_string(fmt::memory_buffer &out, std::string_view text) {
+			out.push_back('"');
+			for (const char ch: text) {
+				if (ch == '"' || ch == '\\') {
+					out.push_back('\\');
+					out.push_back(ch);
+				} else if (static_cast<unsigned char>(ch) < 0x20) {
+					fmt::format_to(std::back_inserter(out), "\\u{:04x}", static_cast<int>(ch));
+				} else {
+					out.push_back(ch);
+				}
+			}
+			out.push_back('"');
+		}
+
+		// Chrome trace 的时间单位为微秒，保留到纳秒
+		void append_us(fmt::memory_buffer &out, int64_t ns) {
+			fmt::format_to(std::back_inserter(out), "{}.{:03}", ns / 1000, ns % 1000);
+		}
+
+		void append_thread_name(fmt::memory_buffer &out, int pid, const Ring &ring) {
+			fmt::format_to(std::back_inserter(out), R"({{"name":"thread_name","ph":"M","pid":{},"tid":{},"args":{{"name":)",
+			               pid, ring.thread_id());
+			append_json_string(out, ring.name);
+			out.append(std::string_view("}}"));
+		}
+
+		void append_event(fmt::memory_buffer &out, int pid, uint32_t thread_id, const Event &event) {
+			out.append(std::string_view(R"({"name":)"));
+			append_json_string(out, event.name != nullptr ? event.name : "");
+			out.append(std::string_view(R"(,"ts":)"));
+			append_us(out, event.timestamp_ns);
+			switch (event.phase) {
+				case Phase::COMPLETE:
+					out.append(std::string_view(R"(,"ph":"X","dur":)"));
+					append_us(out, event.value);
+					break;
+				case Phase::INSTANT:
+					out.append(std::string_view(R"(,"ph":"i","s":"t")"));
+					break;
+				case Phase::COUNTER: {
+					double value;
+					std::memcpy(&value, &event.value, sizeof(value));
+					fmt::format_to(std::back_inserter(out), R"(,"ph":"C","args":{{"value":{}}})", value);
+					break;
+				}
+			}
+			fmt::format_to(std::back_inserter(out), R"(,"pid":{},"tid":{}}})", pid, thread_id);
+		}
+
+		/**
+		 * @brief 把各缓冲区自上次写出以来的新事件追加到持续写出的文件，调用方持有 mutex
+		 */
+		void flush_file(State &s) {
+			const int pid = ::getpid();
+			fmt::memory_buffer out;
+			const auto separate = [&]() {
+				out.append(std::string_view(s.first_event ? "\n" : ",\n"));
+				s.first_event = false;
+			};
+			for (auto iter = s.rings.begin(); iter != s.rings.end();) {
+				auto &ring = **iter;
+				// 先读关闭标志再取数据，线程退出前写入的事件不会丢
+				const bool closed = ring.closed();
+				if (ring.name != ring.written_name) {
+					separate();
+					append_thread_name(out, pid, ring);
+					ring.written_name = ring.name;
+				}
+				ring.cursor = ring.read(ring.cursor, s.overwritten, [&](const Event &event) {
+					separate();
+					append_event(out, pid, ring.thread_id(), event);
+				});
+				iter = closed ? s.rings.erase(iter) : std::next(iter);
+			}
+			std::fwrite(out.data(), 1, out.size(), s.file);
+			std::fflush(s.file);
+		}
+	} // namespace
+
+	void record(Phase phase, const char *name, int64_t timestamp_ns, int64_t value) noexcept {
+		this_ring().push(phase, name, timestamp_ns, value);
+	}
+
+	void start(std::size_t events_per_thread) {
+		auto &s = state();
+		{
+			std::lock_guard<std::mutex> lock(s.mutex);
+			if (s.rings.empty()) {
+				std::size_t capacity = 1;
+				while (capacity < events_per_thread) {
+					capacity <<= 1;
+				}
+				s.capacity = capacity;
+			}
+		}
+		active.store(true, std::memory_order_relaxed);
+	}
+
+	void stop() {
+		active.store(false, std::memory_order_relaxed);
+		auto &s = state();
+		{
+			std::lock_guard<std::mutex> lock(s.mutex);
+			s.stopping = true;
+		}
+		s.wake.notify_all();
+		if (s.writer.joinable()) {
+			s.writer.join();
+		}
+	}
+
+	bool dump(const std::string &path) {
+		auto &s = state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		std::FILE *file = std::fopen(path.c_str(), "w");
+		if (file == nullptr) {
+			std::perror(("trace: " + path).c_str());
+			return false;
+		}
+		const int pid = ::getpid();
+		fmt::memory_buffer out;
+		out.append(std::string_view(R"({"displayTimeUnit":"ns","traceEvents":[)"));
+		bool first = true;
+		const auto separate = [&]() {
+			out.append(std::string_view(first ? "\n" : ",\n"));
+			first = false;
+		};
+		for (const auto &ring: s.rings) {
+			if (!ring->name.empty()) {
+				separate();
+				append_thread_name(out, pid, *ring);
+			}
+			uint64_t overwritten = 0;
+			ring->read(0, overwritten, [&](const Event &event) {
+				separate();
+				append_event(out, pid, ring->thread_id(), event);
+			});
+		}
+		out.append(std::string_view("\n]}\n"));
+		std::fwrite(out.data(), 1, out.size(), file);
+		std::fclose(file);
+		return true;
+	}
+
+	bool start_file(const std::string &path, std::chrono::milliseconds period) {
+		auto &s = state();
+		{
+			std::lock_guard<std::mutex> lock(s.mutex);
+			if (s.file != nullptr || s.writer.joinable()) {
+				return false;
+			}
+			s.file = std::fopen(path.c_str(), "w");
+			if (s.file == nullptr) {
+				std::perror(("trace: " + path).c_str());
+				return false;
+			}
+			std::fputs("[", s.file);
+			s.first_event = true;
+			s.stopping = false;
+			// 只写出此后的事件
+			for (const auto &ring: s.rings) {
+				ring->cursor = ring->head();
+			}
+			s.writer = std::thread([&s, period]() {
+				std::unique_lock<std::mutex> lock(s.mutex);
+				while (!s.stopping) {
+					s.wake.wait_for(lock, period, [&s]() { return s.stopping; });
+					flush_file(s);
+				}
+				std::fputs("\n]\n", s.file);
+				std::fclose(s.file);
+				s.file = nullptr;
+			});
+		}
+		static const bool registered = (std::atexit(stop), true);
+		(void) registered;
+		active.store(true, std::memory_order_relaxed);
+		return true;
+	}
+
+	void set_thread_name(std::string_view name) {
+		thread_name = std::string(name);
+		if (thread_ring.ring != nullptr) {
+			std::lock_guard<std::mutex> lock(state().mutex);
+			thread_ring.ring->name = thread_name;
+		}
+	}
+
+	uint64_t overwritten() {
+		auto &s = state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		return s.overwritten;
+	}
+} // namespace debug::trace
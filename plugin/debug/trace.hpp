@@ -0,0 +1,153 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef PLUGIN_DEBUG_TRACE_HPP
+#define PLUGIN_DEBUG_TRACE_HPP
+
+// C system headers
+
+// C++ system headers
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// Third-party library headers
+
+// Project headers
+#include "plugin/debug/timestamp.hpp"
+
+/**
+ * 跨线程的耗时追踪
+ *
+ * TRACE_SCOPE 记录一段代码的起止时间，TRACE_INSTANT 记录一个时刻，TRACE_COUNTER 记录一个数值。
+ * 事件写入各线程自己的环形缓冲区(CLOCK_MONOTONIC 纳秒时间戳)，写满后覆盖最旧的事件，
+ * 因此 dump() 总能得到每个线程最近的一段记录；start_file() 则由后台线程持续写出。
+ * 输出为 Chrome trace JSON，可直接用 chrome://tracing 或 ui.perfetto.dev 打开。
+ *
+ * 未开启时每个埋点只有一次原子读；CMake 选项 RMCV_TRACE_STRIP 可以把埋点整体编译掉。
+ * 事件名只保存指针，必须是字符串字面量。
+ */
+namespace debug::trace {
+	enum class Phase : uint8_t {
+		// 完整区间，value 为持续时间(纳秒)
+		COMPLETE,
+		// 瞬时事件
+		INSTANT,
+		// 计数器，value 为 double 的位模式
+		COUNTER
+	};
+
+	inline std::atomic<bool> active{false};
+
+	/**
+	 * @brief 是否正在记录
+	 */
+	inline bool enabled() noexcept {
+		return active.load(std::memory_order_relaxed);
+	}
+
+	inline int64_t now_ns() noexcept {
+		return timestamp::now_ns(timestamp::Clock::MONOTONIC);
+	}
+
+	/**
+	 * @brief 写入本线程的缓冲区，首次调用时创建并登记缓冲区
+	 */
+	void record(Phase phase, const char *name, int64_t timestamp_ns, int64_t value) noexcept;
+
+	/**
+	 * @brief 开始记录，事件保存在各线程的缓冲区中，由 dump() 取出
+	 * @param events_per_thread 每个线程保留的最近事件数，向上取整为 2 的幂；只在第一次创建缓冲区前生效
+	 */
+	void start(std::size_t events_per_thread = 1 << 14);
+
+	/**
+	 * @brief 停止记录，已记录的事件仍可 dump()；持续写出模式下写完剩余事件后关闭文件
+	 */
+	void stop();
+
+	/**
+	 * @brief 把各线程缓冲区中现有的事件写成 Chrome trace JSON，不影响记录
+	 * @return false 文件无法打开
+	 */
+	bool dump(const std::string &path);
+
+	/**
+	 * @brief 开始记录，并由后台线程每 period 把新事件追加到 path
+	 * 文件为 JSON 数组格式，进程异常退出时缺少结尾的 "]"，Chrome 和 Perfetto 都能正常打开
+	 * @return false 文件无法打开或已经在持续写出
+	 */
+	bool start_file(const std::string &path, std::chrono::milliseconds period = std::chrono::milliseconds(100));
+
+	/**
+	 * @brief 设置本线程在追踪视图中显示的名字
+	 */
+	void set_thread_name(std::string_view name);
+
+	/**
+	 * @brief 持续写出模式下，因后台线程来不及取走而被覆盖的事件数
+	 */
+	uint64_t overwritten();
+
+	inline void instant(const char *name) noexcept {
+		if (enabled()) {
+			record(Phase::INSTANT, name, now_ns(), 0);
+		}
+	}
+
+	inline void counter(const char *name, double value) noexcept {
+		if (enabled()) {
+			int64_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			record(Phase::COUNTER, name, now_ns(), bits);
+		}
+	}
+
+	/**
+	 * @brief 构造时开始、析构时结束的区间；构造时未开启则整段不记录
+	 */
+	class Scope {
+	public:
+		explicit Scope(const char *name) noexcept
+			: _name(enabled() ? name : nullptr), _start(_name != nullptr ? now_ns() : 0) {
+		}
+
+		~Scope() {
+			if (_name != nullptr) {
+				record(Phase::COMPLETE, _name, _start, now_ns() - _start);
+			}
+		}
+
+		Scope(const Scope &) = delete;
+
+		Scope &operator=(const Scope &) = delete;
+
+	private:
+		const char *_name;
+		int64_t _start;
+	};
+} // namespace debug::trace
+
+#define RMCV_TRACE_CONCAT_(a, b) a##b
+#define RMCV_TRACE_CONCAT(a, b) RMCV_TRACE_CONCAT_(a, b)
+
+#ifdef RMCV_TRACE_STRIP
+#define TRACE_SCOPE(name) do {} while (0)
+#define TRACE_INSTANT(name) do {} while (0)
+#define TRACE_COUNTER(name, value) do {} while (0)
+#else
+/**
+ * @brief 记录从此处到所在作用域结束的耗时
+ *
+ *     TRACE_SCOPE("detector.binarize");
+ */
+#define TRACE_SCOPE(name) ::debug::trace::Scope RMCV_TRACE_CONCAT(rmcv_trace_scope_, __LINE__)(name)
+#define TRACE_INSTANT(name) ::debug::trace::instant(name)
+#define TRACE_COUNTER(name, value) ::debug::trace::counter(name, static_cast<double>(value))
+#endif
+
+#endif //PLUGIN_DEBUG_TRACE_HPP
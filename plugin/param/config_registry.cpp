@@ -0,0 +1,156 @@
+// Source file corresponding header
+#include "config_registry.hpp"
+
+// C system headers
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// C++ system headers
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+// Third-party library headers
+
+// Project headers
+#include "plugin/debug/logger.hpp"
+
+namespace static_param {
+    namespace {
+        constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+        constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+        uint64_t fnv1a(std::string_view data) {
+            uint64_t hash = FNV_OFFSET_BASIS;
+            for (const char ch: data) {
+                hash ^= static_cast<uint8_t>(ch);
+                hash *= FNV_PRIME;
+            }
+            return hash;
+        }
+
+        /**
+         * @brief 只读映射整个文件，析构时解除映射
+         */
+        class MappedFile {
+        public:
+            explicit MappedFile(const std::string &path) {
+                _fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (_fd < 0) {
+                    throw std::runtime_error("cannot open " + path + ": " + std::strerror(errno));
+                }
+                if (::fstat(_fd, &_stat) != 0) {
+                    const int err = errno;
+                    ::close(_fd);
+                    throw std::runtime_error("cannot stat " + path + ": " + std::strerror(err));
+                }
+                if (_stat.st_size > 0) {
+                    _data = ::mmap(nullptr, static_cast<std::size_t>(_stat.st_size), PROT_READ, MAP_PRIVATE, _fd, 0);
+                    if (_data == MAP_FAILED) {
+                        const int err = errno;
+                        ::close(_fd);
+                        throw std::runtime_error("cannot mmap " + path + ": " + std::strerror(err));
+                    }
+                }
+            }
+
+            ~MappedFile() {
+                if (_data != nullptr && _data != MAP_FAILED) {
+                    ::munmap(_data, static_cast<std::size_t>(_stat.st_size));
+                }
+                ::close(_fd);
+            }
+
+            MappedFile(const MappedFile &) = delete;
+
+            MappedFile &operator=(const MappedFile &) = delete;
+
+            [[nodiscard]] std::string_view content() const noexcept {
+                return _data == nullptr
+                           ? std::string_view{}
+                           : std::string_view(static_cast<const char *>(_data), static_cast<std::size_t>(_stat.st_size));
+            }
+
+            [[nodiscard]] const struct stat &info() const noexcept {
+                return _stat;
+            }
+
+        private:
+            int _fd = -1;
+            struct stat _stat{};
+            void *_data = nullptr;
+        };
+
+        bool same_time(const timespec &a, const timespec &b) {
+            return a.tv_sec == b.tv_sec && a.tv_nsec == b.tv_nsec;
+        }
+    } // namespace
+
+    ConfigFile::ConfigFile(std::string name, uint64_t hash, toml::table table)
+        : _name(std::move(name)), _hash(hash), _table(std::move(table)) {
+        flatten(_table, "");
+    }
+
+    void ConfigFile::flatten(const toml::table &table, const std::string &prefix) {
+        for (const auto &[key, node]: table) {
+            const std::string path = prefix.empty() ? std::string(key.str()) : prefix + "." + std::string(key.str());
+            if (const auto *child = node.as_table()) {
+                flatten(*child, path);
+            } else if (auto value = param_types::to_param(node)) {
+                _values.emplace(path, std::move(*value));
+            } else {
+                debug::print(debug::PrintMode::WARNING, "static_param", "{}: 参数 {} 的类型不受支持，已忽略", _name, path);
+            }
+        }
+    }
+
+    ConfigRegistry &ConfigRegistry::instance() {
+        static ConfigRegistry registry;
+        return registry;
+    }
+
+    std::shared_ptr<ConfigRegistry::Slot> ConfigRegistry::slot(const std::string &filename) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto &slot = _slots[filename];
+        if (slot == nullptr) {
+            slot = std::make_shared<Slot>();
+        }
+        return slot;
+    }
+
+    std::shared_ptr<const ConfigFile> ConfigRegistry::load(const std::string &filename) {
+        const std::string path = std::string(CONFIG_DIR) + "/" + filename;
+        // 不同文件可以并行解析
+        const auto entry = slot(filename);
+        std::lock_guard<std::mutex> lock(entry->mutex);
+
+        struct stat info{};
+        if (entry->file != nullptr && ::stat(path.c_str(), &info) == 0
+            && info.st_dev == entry->device && info.st_ino == entry->inode
+            && info.st_size == entry->size && same_time(info.st_mtim, entry->mtime)) {
+            return entry->file;
+        }
+
+        const MappedFile mapped(path);
+        const auto content = mapped.content();
+        const uint64_t hash = fnv1a(content);
+        if (entry->file == nullptr || entry->file->hash() != hash) {
+            entry->file = std::make_shared<const ConfigFile>(filename, hash, toml::parse(content, path));
+        }
+        entry->device = mapped.info().st_dev;
+        entry->inode = mapped.info().st_ino;
+        entry->size = mapped.info().st_size;
+        entry->mtime = mapped.info().st_mtim;
+        return entry->file;
+    }
+
+    void ConfigRegistry::invalidate(const std::string &filename) {
+        const auto entry = slot(filename);
+        std::lock_guard<std::mutex> lock(entry->mutex);
+        entry->file.reset();
+        entry->size = -1;
+    }
+} // namespace static_param
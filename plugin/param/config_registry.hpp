@@ -0,0 +1,131 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef RMCV2026_CONFIG_REGISTRY_HPP
+#define RMCV2026_CONFIG_REGISTRY_HPP
+
+// C system headers
+#include <sys/types.h>
+
+// C++ system headers
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <variant>
+
+// Third-party library headers
+#include <toml++/toml.hpp>
+
+// Project headers
+#include "plugin/param/param_types.hpp"
+
+namespace static_param {
+    /**
+     * @brief 解析好的配置文件，创建后不再修改，可在线程间共享
+     * 除 TOML 表本身外，还建有"完整路径 -> 值"的扁平索引，如 "Camera.use_camera_sn"
+     */
+    class ConfigFile {
+    public:
+        using Index = std::unordered_map<std::string, param_types::Param>;
+
+        ConfigFile(std::string name, uint64_t hash, toml::table table);
+
+        [[nodiscard]] const std::string &name() const noexcept {
+            return _name;
+        }
+
+        /**
+         * @brief 文件内容的 FNV-1a 哈希，内容不变则不变
+         */
+        [[nodiscard]] uint64_t hash() const noexcept {
+            return _hash;
+        }
+
+        [[nodiscard]] const toml::table &table() const noexcept {
+            return _table;
+        }
+
+        [[nodiscard]] const Index &values() const noexcept {
+            return _values;
+        }
+
+        /**
+         * @brief 按完整路径查找，不存在时返回 nullptr
+         */
+        [[nodiscard]] const param_types::Param *find(const std::string &path) const {
+            const auto iter = _values.find(path);
+            return iter == _values.end() ? nullptr : &iter->second;
+        }
+
+        /**
+         * @brief 按完整路径查找，不存在或类型不符时返回 nullptr
+         */
+        template<typename T>
+        [[nodiscard]] const T *find(const std::string &path) const {
+            const auto *value = find(path);
+            return value == nullptr ? nullptr : std::get_if<T>(value);
+        }
+
+    private:
+        void flatten(const toml::table &table, const std::string &prefix);
+
+        std::string _name;
+        uint64_t _hash;
+        toml::table _table;
+        Index _values;
+    };
+
+    /**
+     * @brief 进程内的配置文件缓存，每个文件只解析一次
+     * 文件以 mmap 读入并计算内容哈希；修改时间、大小均未变时直接返回缓存，
+     * 变了但哈希相同(如编辑器原样保存)时也不重新解析。
+     */
+    class ConfigRegistry {
+    public:
+        static ConfigRegistry &instance();
+
+        /**
+         * @brief 加载 CONFIG_DIR 下的配置文件
+         * @param filename 文件名，如 "hardware.toml"
+         * @throws toml::parse_error 解析失败
+         * @throws std::runtime_error 文件无法读取
+         */
+        std::shared_ptr<const ConfigFile> load(const std::string &filename);
+
+        /**
+         * @brief 从缓存中移除，下次 load 时重新读取
+         */
+        void invalidate(const std::string &filename);
+
+    private:
+        ConfigRegistry() = default;
+
+        struct Slot {
+            std::mutex mutex;
+            // 用于快速判断文件是否被改动过
+            dev_t device = 0;
+            ino_t inode = 0;
+            off_t size = -1;
+            timespec mtime{};
+            std::shared_ptr<const ConfigFile> file;
+        };
+
+        std::shared_ptr<Slot> slot(const std::string &filename);
+
+        std::mutex _mutex;
+        std::unordered_map<std::string, std::shared_ptr<Slot> > _slots;
+    };
+
+    /**
+     * @brief ConfigRegistry::instance().load(filename) 的简写
+     */
+    inline std::shared_ptr<const ConfigFile> load_file(const std::string &filename) {
+        return ConfigRegistry::instance().load(filename);
+    }
+} // namespace static_param
+
+#endif //RMCV2026_CONFIG_REGISTRY_HPP
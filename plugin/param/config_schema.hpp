@@ -0,0 +1,258 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef RMCV2026_CONFIG_SCHEMA_HPP
+#define RMCV2026_CONFIG_SCHEMA_HPP
+
+// C system headers
+
+// C++ system headers
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+// Third-party library headers
+#include <fmt/format.h>
+#include <toml++/toml.hpp>
+
+// Project headers
+#include "plugin/debug/logger.hpp"
+#include "plugin/param/param_types.hpp"
+
+/**
+ * 声明式配置表
+ *
+ * 用一个 X-macro 列出表中每个字段的类型、名称、默认值和约束，再用 RMCV_CONFIG_STRUCT 生成普通结构体：
+ *
+ *     #define SIM_FIELDS(FIELD)                                             \
+ *         FIELD(double, rate_hz, 1000.0, ::config_schema::range(0.0, 1e5))  \
+ *         FIELD(bool, echo, false, ::config_schema::any)
+ *     RMCV_CONFIG_STRUCT(SimConfig, "Serial.sim", SIM_FIELDS)
+ *
+ *     config_schema::ConfigErrors errors;
+ *     const auto config = SimConfig::load(table, errors);
+ *     config_schema::report("Serial.sim", errors);
+ *
+ * load() 只遍历一次 TOML 表，类型错误、超出范围和未知键全部记入 errors 而不是遇到第一个就停止；
+ * 出错或缺失的字段保持默认值。之后直接访问结构体成员，不再有字符串查找。
+ */
+namespace config_schema {
+    struct ConfigError {
+        // 出错的完整路径，如 "Serial.sim.rate_hz"
+        std::string path;
+        std::string message;
+    };
+
+    using ConfigErrors = std::vector<ConfigError>;
+
+    // 不做取值约束
+    struct AnyValue {
+    };
+
+    inline constexpr AnyValue any{};
+
+    // 闭区间 [min, max]
+    template<typename T>
+    struct Range {
+        T min;
+        T max;
+    };
+
+    template<typename T>
+    constexpr Range<T> range(T min, T max) {
+        return Range<T>{min, max};
+    }
+
+    template<typename T>
+    constexpr const char *type_name() {
+        if constexpr (std::is_same_v<T, bool>) {
+            return "bool";
+        } else if constexpr (std::is_same_v<T, int64_t>) {
+            return "int";
+        } else if constexpr (std::is_same_v<T, double>) {
+            return "float";
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            return "string";
+        } else if constexpr (std::is_same_v<T, std::vector<int64_t> >) {
+            return "int array";
+        } else if constexpr (std::is_same_v<T, param_types::ParamVector>) {
+            return "float array";
+        } else if constexpr (std::is_same_v<T, param_types::ParamMatrix>) {
+            return "matrix";
+        } else {
+            static_assert(!sizeof(T), "unsupported config field type");
+        }
+    }
+
+    /**
+     * @brief 按字段类型读取节点，整数可以赋给 float 字段
+     * @return false 类型不符
+     */
+    template<typename T>
+    bool read_value(const toml::node &node, T &out) {
+        if constexpr (std::is_same_v<T, bool>) {
+            if (const auto *value = node.as_boolean()) {
+                out = value->get();
+                return true;
+            }
+        } else if constexpr (std::is_same_v<T, int64_t>) {
+            if (const auto *value = node.as_integer()) {
+                out = value->get();
+                return true;
+            }
+        } else if constexpr (std::is_same_v<T, double>) {
+            if (const auto *value = node.as_floating_point()) {
+                out = value->get();
+                return true;
+            }
+            if (const auto *value = node.as_integer()) {
+                out = static_cast<double>(value->get());
+                return true;
+            }
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            if (const auto *value = node.as_string()) {
+                out = value->get();
+                return true;
+            }
+        } else if constexpr (std::is_same_v<T, std::vector<int64_t> >) {
+            const auto *array = node.as_array();
+            if (array != nullptr && (array->empty() || array->template is_homogeneous<int64_t>())) {
+                T values;
+                values.reserve(array->size());
+                for (const auto &element: *array) {
+                    values.push_back(element.as_integer()->get());
+                }
+                out = std::move(values);
+                return true;
+            }
+        } else if constexpr (std::is_same_v<T, param_types::ParamVector> || std::is_same_v<T, param_types::ParamMatrix>) {
+            auto value = param_types::to_param(node);
+            if (value && std::holds_alternative<std::vector<int64_t> >(*value)) {
+                // 全部写成整数的浮点数组
+                const auto &ints = std::get<std::vector<int64_t> >(*value);
+                value = param_types::ParamVector(ints.begin(), ints.end());
+            }
+            if (value && std::holds_alternative<T>(*value)) {
+                out = std::get<T>(std::move(*value));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template<typename T>
+    bool satisfies(const T &, AnyValue) {
+        return true;
+    }
+
+    template<typename T, typename R>
+    bool satisfies(const T &value, const Range<R> &range) {
+        return value >= static_cast<T>(range.min) && value <= static_cast<T>(range.max);
+    }
+
+    inline std::string describe(AnyValue) {
+        return "";
+    }
+
+    template<typename R>
+    std::string describe(const Range<R> &range) {
+        return fmt::format("[{}, {}]", range.min, range.max);
+    }
+
+    /**
+     * @brief 读取并校验一个字段，失败时记录错误并保留默认值
+     */
+    template<typename T, typename Constraint>
+    void load_field(const toml::node &node, const char *table, std::string_view key,
+                    T &field, const Constraint &constraint, ConfigErrors &errors) {
+        T value = field;
+        if (!read_value(node, value)) {
+            errors.push_back({fmt::format("{}.{}", table, key), fmt::format("expected {}", type_name<T>())});
+            return;
+        }
+        if constexpr (!std::is_same_v<Constraint, AnyValue>) {
+            if (!satisfies(value, constraint)) {
+                errors.push_back({
+                    fmt::format("{}.{}", table, key),
+                    fmt::format("value {} out of range {}", value, describe(constraint))
+                });
+                return;
+            }
+        }
+        field = std::move(value);
+    }
+
+    /**
+     * @brief 查找表，不存在时记录错误
+     */
+    inline const toml::table *find_table(const toml::table &root, const char *path, ConfigErrors &errors) {
+        const toml::node *node = root.at_path(path).node();
+        const toml::table *table = node ? node->as_table() : nullptr;
+        if (table == nullptr) {
+            errors.push_back({path, "table not found"});
+        }
+        return table;
+    }
+
+    /**
+     * @brief 记录未在模式中声明的键，子表由各自的模式负责，不算未知键
+     */
+    inline void unknown_key(const char *table, std::string_view key, const toml::node &node, ConfigErrors &errors) {
+        if (!node.is_table()) {
+            errors.push_back({fmt::format("{}.{}", table, key), "unknown key"});
+        }
+    }
+
+    /**
+     * @brief 打印全部错误
+     * @return true 没有错误
+     */
+    inline bool report(const std::string &name, const ConfigErrors &errors) {
+        for (const auto &error: errors) {
+            debug::print(debug::PrintMode::ERROR, "config", "{}: {}", error.path, error.message);
+        }
+        if (!errors.empty()) {
+            debug::print(debug::PrintMode::ERROR, "config", "{} 共有 {} 处配置错误，相关字段使用默认值", name, errors.size());
+        }
+        return errors.empty();
+    }
+} // namespace config_schema
+
+#define RMCV_CONFIG_FIELD_DECLARE(type, name, default_value, constraint) \
+    type name = default_value;
+
+#define RMCV_CONFIG_FIELD_LOAD(type, name, default_value, constraint)                          \
+    if (key_name == #name) {                                                                    \
+        ::config_schema::load_field(node, TABLE, key_name, config.name, constraint, errors);    \
+        continue;                                                                               \
+    }
+
+/**
+ * @brief 由字段列表生成配置结构体
+ * @param struct_name 结构体名
+ * @param table_path 对应的 TOML 表路径，如 "Serial.sim"
+ * @param FIELDS 形如 FIELDS(FIELD) 的宏，每个字段写作 FIELD(类型, 名称, 默认值, 约束)
+ */
+#define RMCV_CONFIG_STRUCT(struct_name, table_path, FIELDS)                                       \
+    struct struct_name {                                                                          \
+        static constexpr const char *TABLE = table_path;                                          \
+        FIELDS(RMCV_CONFIG_FIELD_DECLARE)                                                         \
+        static struct_name load(const toml::table &root, ::config_schema::ConfigErrors &errors) { \
+            struct_name config;                                                                   \
+            const toml::table *table = ::config_schema::find_table(root, TABLE, errors);          \
+            if (table == nullptr) {                                                               \
+                return config;                                                                    \
+            }                                                                                     \
+            for (const auto &[key, node]: *table) {                                               \
+                const std::string_view key_name = key.str();                                      \
+                FIELDS(RMCV_CONFIG_FIELD_LOAD)                                                    \
+                ::config_schema::unknown_key(TABLE, key_name, node, errors);                      \
+            }                                                                                     \
+            return config;                                                                        \
+        }                                                                                         \
+    };
+
+#endif //RMCV2026_CONFIG_SCHEMA_HPP
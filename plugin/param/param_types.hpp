@@ -0,0 +1,198 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+#ifndef RMCV2026_PARAM_TYPES_HPP
+#define RMCV2026_PARAM_TYPES_HPP
+
+// C system headers
+
+// C++ system headers
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+// Third-party library headers
+#include <Eigen/Core>
+#include <fmt/format.h>
+#include <toml++/toml.hpp>
+
+// Project headers
+
+/**
+ * static_param 与 runtime_param 共用的参数类型及 TOML 转换
+ */
+namespace param_types {
+    /**
+     * @brief 浮点数组参数，按 Eigen 要求对齐，热路径上用 map_vector() 直接映射为 Eigen 向量
+     */
+    using ParamVector = std::vector<double, Eigen::aligned_allocator<double> >;
+
+    /**
+     * @brief 矩阵参数，如相机内参、畸变系数、外参、弹道表
+     * 在 TOML 中写作等长的二维数值数组 [[1, 0, 0], [0, 1, 0], [0, 0, 1]]，按行优先连续存放并按 Eigen 要求对齐，
+     * 热路径上用 map<Rows, Cols>() 直接映射为 Eigen 矩阵，不拷贝
+     */
+    struct ParamMatrix {
+        using Storage = ParamVector;
+
+        template<int Rows, int Cols>
+        using FixedMap = Eigen::Map<
+            const Eigen::Matrix<double, Rows, Cols, (Cols == 1 && Rows != 1) ? Eigen::ColMajor : Eigen::RowMajor>,
+            Eigen::AlignedMax>;
+        using DynamicMap = Eigen::Map<
+            const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>, Eigen::AlignedMax>;
+
+        int64_t rows = 0;
+        int64_t cols = 0;
+        // 行优先
+        Storage data;
+
+        /**
+         * @brief 以固定尺寸映射，数据的生命周期与本对象相同
+         * @throws std::invalid_argument 尺寸不符
+         */
+        template<int Rows, int Cols>
+        [[nodiscard]] FixedMap<Rows, Cols> map() const {
+            if (rows != Rows || cols != Cols) {
+                throw std::invalid_argument(fmt::format("expected {}x{} matrix, got {}x{}", Rows, Cols, rows, cols));
+            }
+            return FixedMap<Rows, Cols>(data.data());
+        }
+
+        [[nodiscard]] DynamicMap map() const {
+            return DynamicMap(data.data(), rows, cols);
+        }
+
+        bool operator==(const ParamMatrix &other) const {
+            return rows == other.rows && cols == other.cols && data == other.data;
+        }
+
+        bool operator!=(const ParamMatrix &other) const {
+            return !(*this == other);
+        }
+    };
+
+    using Param = std::variant<bool, int64_t, double, std::string, std::vector<int64_t>, ParamVector, ParamMatrix>;
+
+    /**
+     * @brief 可以直接写入相机等设备的标量类型
+     */
+    template<typename T>
+    inline constexpr bool is_scalar_v =
+            std::is_same_v<T, bool> || std::is_same_v<T, int64_t> || std::is_same_v<T, double>
+            || std::is_same_v<T, std::string>;
+
+    /**
+     * @brief 浮点数组不拷贝地映射为 Eigen 向量，数据的生命周期与 values 相同
+     */
+    inline Eigen::Map<const Eigen::VectorXd, Eigen::AlignedMax> map_vector(const ParamVector &values) {
+        return Eigen::Map<const Eigen::VectorXd, Eigen::AlignedMax>(values.data(),
+                                                                    static_cast<Eigen::Index>(values.size()));
+    }
+
+    namespace detail {
+        inline std::optional<double> as_number(const toml::node &node) {
+            if (const auto *value = node.as_floating_point()) {
+                return value->get();
+            }
+            if (const auto *value = node.as_integer()) {
+                return static_cast<double>(value->get());
+            }
+            return std::nullopt;
+        }
+
+        inline std::optional<Param> to_matrix(const toml::array &array) {
+            ParamMatrix matrix;
+            matrix.rows = static_cast<int64_t>(array.size());
+            for (const auto &row_node: array) {
+                const auto *row = row_node.as_array();
+                if (row == nullptr || row->empty()
+                    || (matrix.cols != 0 && static_cast<int64_t>(row->size()) != matrix.cols)) {
+                    return std::nullopt;
+                }
+                matrix.cols = static_cast<int64_t>(row->size());
+                for (const auto &element: *row) {
+                    const auto number = as_number(element);
+                    if (!number) {
+                        return std::nullopt;
+                    }
+                    matrix.data.push_back(*number);
+                }
+            }
+            return matrix;
+        }
+    } // namespace detail
+
+    /**
+     * @brief 将 TOML 节点转换为 Param
+     * 整数数组为 vector<int64_t>，含浮点数的数值数组为 ParamVector，等长的二维数值数组为 ParamMatrix。
+     * 与标量一样按字面判断类型，浮点数组请至少写一个小数(如 [0.0, 0, 0])
+     * @return 表或不支持的类型(如字符串数组、不等长的二维数组)返回空
+     */
+    inline std::optional<Param> to_param(const toml::node &node) {
+        if (const auto *value = node.as_boolean()) {
+            return value->get();
+        }
+        if (const auto *value = node.as_integer()) {
+            return value->get();
+        }
+        if (const auto *value = node.as_floating_point()) {
+            return value->get();
+        }
+        if (const auto *value = node.as_string()) {
+            return value->get();
+        }
+        const auto *array = node.as_array();
+        if (array == nullptr) {
+            return std::nullopt;
+        }
+        if (array->empty() || array->is_homogeneous<int64_t>()) {
+            std::vector<int64_t> values;
+            values.reserve(array->size());
+            for (const auto &element: *array) {
+                values.push_back(element.as_integer()->get());
+            }
+            return values;
+        }
+        if ((*array)[0].is_array()) {
+            return detail::to_matrix(*array);
+        }
+        ParamVector values;
+        values.reserve(array->size());
+        for (const auto &element: *array) {
+            const auto number = detail::as_number(element);
+            if (!number) {
+                return std::nullopt;
+            }
+            values.push_back(*number);
+        }
+        return values;
+    }
+} // namespace param_types
+
+template<>
+struct fmt::formatter<param_types::ParamMatrix> : fmt::formatter<std::string_view> {
+    template<typename FormatContext>
+    auto format(const param_types::ParamMatrix &matrix, FormatContext &ctx) const {
+        std::string str = "[";
+        for (int64_t row = 0; row < matrix.rows; ++row) {
+            str += row == 0 ? "[" : ", [";
+            for (int64_t col = 0; col < matrix.cols; ++col) {
+                if (col != 0) {
+                    str += ", ";
+                }
+                str += fmt::format("{}", matrix.data[row * matrix.cols + col]);
+            }
+            str += "]";
+        }
+        str += "]";
+        return fmt::formatter<std::string_view>::format(str, ctx);
+    }
+};
+
+#endif //RMCV2026_PARAM_TYPES_HPP
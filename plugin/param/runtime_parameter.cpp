@@ -2,47 +2,72 @@
 #include "runtime_parameter.hpp"
 
 // C system headers
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
 
 // C++ system headers
+#include <atomic>
+#include <cerrno>
 #include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
 
 // Third-party library headers
-#include <toml++/toml.hpp>
 
 // Project headers
 #include "plugin/debug/logger.hpp"
+#include "plugin/param/config_registry.hpp"
 #include "umt/ObjManager.hpp"
 
 namespace runtime_param {
     const std::string PARAM_PREFIX = "param.";
 
-    Param get_value(const toml::node &node) {
-        if (node.is_boolean()) {
-            return (*node.as_boolean()).get();
-        }
-        if (node.is_integer()) {
-            return (*node.as_integer()).get();
-        }
-        if (node.is_floating_point()) {
-            return (*node.as_floating_point()).get();
+    namespace {
+        /**
+         * @brief 文件中写成整数的浮点参数(如 4000 / [0, 0, 0])，按原来的浮点类型接收，不算类型改变
+         */
+        Param promote(const Param &old_value, const Param &value) {
+            if (std::holds_alternative<double>(old_value) && std::holds_alternative<int64_t>(value)) {
+                return static_cast<double>(std::get<int64_t>(value));
+            }
+            if (std::holds_alternative<param_types::ParamVector>(old_value)
+                && std::holds_alternative<std::vector<int64_t> >(value)) {
+                const auto &ints = std::get<std::vector<int64_t> >(value);
+                return param_types::ParamVector(ints.begin(), ints.end());
+            }
+            return value;
         }
-        if (node.is_string()) {
-            return (*node.as_string()).get();
+    } // namespace
+
+    namespace {
+        std::mutex ready_mutex;
+        std::condition_variable ready_cv;
+
+        void notify_ready() {
+            // 持锁后再通知，避免等待方检查条件后、开始等待前错过通知
+            { std::lock_guard<std::mutex> lock(ready_mutex); }
+            ready_cv.notify_all();
         }
-        if (node.is_array() && (node.as_array()->is_homogeneous<int64_t>() || node.as_array()->empty())) {
-            std::vector<int64_t> vec_int;
-            for (const auto &ele: *node.as_array()) {
-                vec_int.push_back((*ele.as_integer()).get());
-            }
-            return vec_int;
+
+        std::shared_ptr<Param> create_object(const std::string &name) {
+            namespace umt = ::umt;
+            return umt::ObjManager<Param>::create(PARAM_PREFIX + name);
         }
-        return Param();
-    }
+    } // namespace
 
     std::shared_ptr<Param> create_param(const std::string &name) {
-        namespace umt = ::umt;
-        return umt::ObjManager<Param>::create(PARAM_PREFIX + name);
+        auto param = create_object(name);
+        if (param != nullptr) {
+            notify_ready();
+        }
+        return param;
     }
 
     std::shared_ptr<Param> find_param(const std::string &name) {
@@ -50,80 +75,457 @@ namespace runtime_param {
         return umt::ObjManager<Param>::find(PARAM_PREFIX + name);
     }
 
+    namespace {
+        std::mutex cell_mutex;
+        std::unordered_map<std::string, std::shared_ptr<ParamCell> > cells;
+
+        std::shared_ptr<ParamCell> create_cell(const std::string &name) {
+            std::lock_guard<std::mutex> lock(cell_mutex);
+            auto &cell = cells[name];
+            if (cell == nullptr) {
+                cell = std::make_shared<ParamCell>();
+            }
+            return cell;
+        }
+    } // namespace
+
+    std::shared_ptr<ParamCell> find_cell(const std::string &name) {
+        std::lock_guard<std::mutex> lock(cell_mutex);
+        const auto iter = cells.find(name);
+        return iter == cells.end() ? nullptr : iter->second;
+    }
+
+    namespace {
+        // 快照槽位数，同一时刻被钉住的旧快照不超过 SNAPSHOT_SLOTS - 1 个时发布不会等待
+        constexpr std::size_t SNAPSHOT_SLOTS = 8;
+
+        struct SnapshotSlot {
+            std::atomic<uint32_t> readers{0};
+            std::unique_ptr<const ParamSnapshot> snapshot;
+        };
+
+        /**
+         * 读端：读取当前槽位号，给该槽位的读者计数加一，再确认槽位号没变，否则撤销重试。
+         * 写端：只复用不是当前槽位且读者计数为0的槽位，写入新快照后再切换槽位号。
+         * 读者计数非0的槽位不会被复用，因此被钉住的快照在释放前一直有效。
+         */
+        struct SnapshotStore {
+            SnapshotStore() {
+                slots[0].snapshot = std::make_unique<const ParamSnapshot>(0, ParamSnapshot::Values{});
+            }
+
+            SnapshotSlot slots[SNAPSHOT_SLOTS];
+            std::atomic<std::size_t> current{0};
+            std::mutex write_mutex;
+        };
+
+        SnapshotStore &snapshot_store() {
+            static SnapshotStore store;
+            return store;
+        }
+
+        void publish_snapshot(const std::map<std::string, Param> &updates, const std::vector<std::string> &removed) {
+            auto &store = snapshot_store();
+            std::lock_guard<std::mutex> lock(store.write_mutex);
+            const std::size_t current = store.current.load(std::memory_order_relaxed);
+            const ParamSnapshot &base = *store.slots[current].snapshot;
+
+            ParamSnapshot::Values values = base.values();
+            for (const auto &[name, value]: updates) {
+                values[name] = value;
+            }
+            for (const auto &name: removed) {
+                values.erase(name);
+            }
+            auto snapshot = std::make_unique<const ParamSnapshot>(base.version() + 1, std::move(values));
+
+            while (true) {
+                for (std::size_t i = 1; i < SNAPSHOT_SLOTS; ++i) {
+                    const std::size_t index = (current + i) % SNAPSHOT_SLOTS;
+                    auto &slot = store.slots[index];
+                    if (slot.readers.load(std::memory_order_seq_cst) != 0) {
+                        continue;
+                    }
+                    // 此后才来的读者会发现槽位号不符而撤销，不会读取这里的内容
+                    slot.snapshot = std::move(snapshot);
+                    store.current.store(index, std::memory_order_seq_cst);
+                    return;
+                }
+                // 每 1ms 重试一次，警告限频
+                RMCV_LOG_EVERY_MS(WARNING, 1000, "param", "所有快照槽位都被钉住，等待读者释放。");
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    } // namespace
+
+    SnapshotPin pin_snapshot() noexcept {
+        auto &store = snapshot_store();
+        while (true) {
+            const std::size_t index = store.current.load(std::memory_order_seq_cst);
+            auto &slot = store.slots[index];
+            slot.readers.fetch_add(1, std::memory_order_seq_cst);
+            if (store.current.load(std::memory_order_seq_cst) == index) {
+                return SnapshotPin(&slot.readers, slot.snapshot.get());
+            }
+            slot.readers.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    namespace {
+        struct Subscription {
+            std::string prefix;
+            ChangeCallback callback;
+            std::atomic<bool> active{true};
+        };
+
+        std::mutex subscription_mutex;
+        uint64_t next_subscription_id = 1;
+        std::map<uint64_t, std::shared_ptr<Subscription> > subscriptions;
+        // 回调期间持有，unsubscribe 借此等待正在执行的回调结束
+        std::mutex dispatch_mutex;
+        thread_local bool in_dispatch = false;
+
+        bool match_prefix(const std::string &name, const std::string &prefix) {
+            if (prefix.empty()) {
+                return true;
+            }
+            return name.compare(0, prefix.size(), prefix) == 0
+                   && (name.size() == prefix.size() || name[prefix.size()] == '.');
+        }
+
+        void dispatch(const ParamChanges &changes) {
+            std::lock_guard<std::mutex> dispatch_lock(dispatch_mutex);
+            std::vector<std::shared_ptr<Subscription> > targets;
+            {
+                std::lock_guard<std::mutex> lock(subscription_mutex);
+                targets.reserve(subscriptions.size());
+                for (const auto &[id, subscription]: subscriptions) {
+                    targets.push_back(subscription);
+                }
+            }
+            // 回调中允许订阅或取消订阅，因此不持 subscription_mutex 调用
+            in_dispatch = true;
+            for (const auto &subscription: targets) {
+                if (!subscription->active.load(std::memory_order_acquire)) {
+                    continue;
+                }
+                ParamChanges matched;
+                for (const auto &change: changes) {
+                    if (match_prefix(change.name, subscription->prefix)) {
+                        matched.push_back(change);
+                    }
+                }
+                if (matched.empty()) {
+                    continue;
+                }
+                try {
+                    subscription->callback(matched);
+                } catch (const std::exception &e) {
+                    debug::print(debug::PrintMode::ERROR, "param", "参数订阅 {} 的回调出错: {}", subscription->prefix, e.what());
+                }
+            }
+            in_dispatch = false;
+
+            // 参数线程是分离的，进程退出时可能仍在发布，故不析构
+            static auto *publisher = new umt::Publisher<ParamChanges>(PARAM_CHANGE_TOPIC);
+            publisher->push(changes);
+        }
+    } // namespace
+
+    uint64_t subscribe(const std::string &prefix, ChangeCallback callback) {
+        auto subscription = std::make_shared<Subscription>();
+        subscription->prefix = prefix;
+        subscription->callback = std::move(callback);
+        std::lock_guard<std::mutex> lock(subscription_mutex);
+        const uint64_t id = next_subscription_id++;
+        subscriptions.emplace(id, std::move(subscription));
+        return id;
+    }
+
+    void unsubscribe(uint64_t id) {
+        {
+            std::lock_guard<std::mutex> lock(subscription_mutex);
+            const auto iter = subscriptions.find(id);
+            if (iter == subscriptions.end()) {
+                return;
+            }
+            iter->second->active.store(false, std::memory_order_release);
+            subscriptions.erase(iter);
+        }
+        // 等待正在执行的回调结束，返回后回调不会再被调用，订阅者可以安全析构
+        if (!in_dispatch) {
+            std::lock_guard<std::mutex> dispatch_lock(dispatch_mutex);
+        }
+    }
+
+    bool wait_for(const std::vector<std::string> &names, std::chrono::milliseconds timeout) {
+        const auto ready = [&names]() {
+            const auto snapshot = pin_snapshot();
+            for (const auto &name: names) {
+                if (!snapshot->contains(name) && find_param(name) == nullptr) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        std::unique_lock<std::mutex> lock(ready_mutex);
+        return ready_cv.wait_for(lock, timeout, ready);
+    }
+
+    std::string ready_name(const std::string &param_file_path) {
+        return "ok." + param_file_path;
+    }
+
     void wait_for_param(const std::string &name) {
-        while (runtime_param::find_param(name) == nullptr) {
-            using namespace std::chrono_literals;
-            debug::print(::debug::PrintMode::WARNING, "param", "参数还未创建完毕。");
-            std::this_thread::sleep_for(200ms);
+        using namespace std::chrono_literals;
+        if (wait_for({name}, 1s)) {
+            return;
+        }
+        // 多个线程可能同时在等
+        RMCV_LOG_EVERY_MS(WARNING, 1000, "param", "参数 {} 还未创建完毕，继续等待。", name);
+        while (!wait_for({name}, 1h)) {
         }
     }
 
+    namespace {
+        // 一次保存可能触发多个事件(写临时文件、改名、关闭)，静默这么久后才重新加载
+        constexpr int RELOAD_DEBOUNCE_MS = 20;
+        // inotify不可用时退化为按修改时间轮询
+        constexpr auto FALLBACK_POLL_INTERVAL = std::chrono::seconds(1);
+    } // namespace
+
     class ParamManager {
     public:
-        void load_and_update(const std::string &param_file_path);
+        explicit ParamManager(const std::string &param_file_path);
+
+        ~ParamManager();
+
+        void load_and_update();
 
     private:
-        void parse(const toml::node &node, const std::string &prefix);
+        using FlatParams = std::map<std::string, Param>;
+
+        void reload();
+
+        void apply(const static_param::ConfigFile::Index &params);
 
+        bool wait_for_change();
+
+        void poll_for_change();
+
+        std::string file_name;
+        std::filesystem::path file_path;
+        int inotify_fd = -1;
         bool init_ok = false;
+        // 上一次应用的文件内容哈希
+        uint64_t file_hash = 0;
+        // 上一次应用的参数，用于计算差异
+        FlatParams values;
+        struct Entry {
+            std::shared_ptr<Param> param;
+            std::shared_ptr<ParamCell> cell;
+        };
+
+        // 缓存参数对象，避免每次重载都经过ObjManager的全局锁查找
+        std::unordered_map<std::string, Entry> handles;
         std::set<std::shared_ptr<Param> > param_set;
     };
 
-    void ParamManager::load_and_update(const std::string &param_file_path) {
-        using namespace std::chrono_literals;
+    ParamManager::ParamManager(const std::string &param_file_path)
+        : file_name(param_file_path), file_path(std::filesystem::path(CONFIG_DIR) / param_file_path) {
+        // 监听所在目录而不是文件本身：编辑器保存时常用改名替换，文件的inode会变
+        inotify_fd = inotify_init1(IN_CLOEXEC);
+        if (inotify_fd >= 0
+            && inotify_add_watch(inotify_fd, file_path.parent_path().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+            const int err = errno;
+            ::close(inotify_fd);
+            inotify_fd = -1;
+            errno = err;
+        }
+        if (inotify_fd < 0) {
+            debug::print(debug::PrintMode::WARNING, "param", "inotify不可用({})，改为每秒检查修改时间。", std::strerror(errno));
+        }
+    }
+
+    ParamManager::~ParamManager() {
+        if (inotify_fd >= 0) {
+            ::close(inotify_fd);
+        }
+    }
+
+    void ParamManager::load_and_update() {
+        reload();
         while (true) {
-            try {
-                const auto table =
-                        toml::parse_file(std::string(CONFIG_DIR) + "/" + param_file_path);
-                parse(table, "");
-                if (!this->init_ok) {
-                    this->init_ok = true;
-                    this->param_set.emplace(create_param("ok"));
-                    debug::print(debug::PrintMode::INFO, "param", "参数创建完毕！");
+            if (inotify_fd >= 0 && wait_for_change()) {
+                reload();
+            } else {
+                poll_for_change();
+            }
+        }
+    }
+
+    bool ParamManager::wait_for_change() {
+        alignas(inotify_event) char buffer[4096];
+        const auto file_name = file_path.filename().string();
+        bool changed = false;
+        while (!changed) {
+            const auto len = ::read(inotify_fd, buffer, sizeof(buffer));
+            if (len <= 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                debug::print(debug::PrintMode::ERROR, "param", "读取inotify事件失败: {}", std::strerror(errno));
+                ::close(inotify_fd);
+                inotify_fd = -1;
+                return false;
+            }
+            for (char *ptr = buffer; ptr < buffer + len;) {
+                const auto *event = reinterpret_cast<const inotify_event *>(ptr);
+                if ((event->mask & IN_Q_OVERFLOW) || (event->len > 0 && file_name == event->name)) {
+                    changed = true;
                 }
-            } catch (const std::exception &e) {
-                debug::print(debug::PrintMode::ERROR, "param", "{}", e.what());
+                ptr += sizeof(inotify_event) + event->len;
             }
-            std::this_thread::sleep_for(1s);
+        }
+        // 合并短时间内的连续事件
+        pollfd pfd{inotify_fd, POLLIN, 0};
+        while (::poll(&pfd, 1, RELOAD_DEBOUNCE_MS) > 0) {
+            if (::read(inotify_fd, buffer, sizeof(buffer)) <= 0) {
+                break;
+            }
+        }
+        return true;
+    }
+
+    void ParamManager::poll_for_change() {
+        std::error_code last_ec;
+        const auto last = std::filesystem::last_write_time(file_path, last_ec);
+        std::this_thread::sleep_for(FALLBACK_POLL_INTERVAL);
+        std::error_code now_ec;
+        const auto now = std::filesystem::last_write_time(file_path, now_ec);
+        if (!now_ec && (last_ec || now != last)) {
+            reload();
+        }
+    }
+
+    void ParamManager::reload() {
+        std::shared_ptr<const static_param::ConfigFile> file;
+        try {
+            // 与 static_param 共用缓存，内容没变时不重新解析
+            file = static_param::load_file(this->file_name);
+        } catch (const std::exception &e) {
+            // 解析失败时保留上一次的参数
+            debug::print(debug::PrintMode::ERROR, "param", "{}", e.what());
+            return;
+        }
+        if (this->init_ok && file->hash() == this->file_hash) {
+            return;
+        }
+        this->file_hash = file->hash();
+        apply(file->values());
+        if (!this->init_ok) {
+            this->init_ok = true;
+            this->param_set.emplace(create_param(ready_name(this->file_name)));
+            this->param_set.emplace(create_param("ok"));
+            debug::print(debug::PrintMode::INFO, "param", "参数创建完毕！");
         }
     }
 
-    void ParamManager::parse(const toml::node &node, const std::string &prefix) {
-        if (node.is_table()) {
-            for (const auto &child: *node.as_table()) {
-                parse(
-                    child.second,
-                    (prefix == "" ? "" : prefix + ".") + std::string(child.first.str())
+    void ParamManager::apply(const static_param::ConfigFile::Index &params) {
+        FlatParams applied;
+        ParamChanges changes;
+        std::vector<std::string> created;
+        // 值有变化的参数，快照发布后再递增它们的版本号
+        std::vector<std::string> updated;
+        for (const auto &[name, value]: params) {
+            const auto old = this->values.find(name);
+            const Param res = old != this->values.end() ? promote(old->second, value) : value;
+            if (old != this->values.end() && old->second == res) {
+                applied.emplace(name, res);
+                continue;
+            }
+            if (old != this->values.end() && old->second.index() != res.index()) {
+                // 已绑定的 Handle<T> 依赖类型不变
+                debug::print(
+                    debug::PrintMode::ERROR,
+                    "param",
+                    "参数 {} 的类型不能在运行时修改，保留原值 {}",
+                    name,
+                    std::visit(PARAM_VISITOR, old->second)
+                );
+                applied.emplace(name, old->second);
+                continue;
+            }
+            if (this->handles[name].cell == nullptr) {
+                created.push_back(name);
+            }
+            if (old != this->values.end()) {
+                debug::print(
+                    debug::PrintMode::INFO,
+                    "param",
+                    "参数 {} 被修改: {} -> {}",
+                    name,
+                    std::visit(PARAM_VISITOR, old->second),
+                    std::visit(PARAM_VISITOR, res)
                 );
             }
-        } else {
-            const Param res = get_value(node);
-            const auto found = find_param(prefix);
-            if (found == nullptr) {
-                const auto ptr = create_param(prefix);
-                this->param_set.emplace(ptr);
-                *ptr = res;
+            applied.emplace(name, res);
+            updated.push_back(name);
+            if (this->init_ok) {
+                changes.push_back(ParamChange{
+                    name,
+                    old != this->values.end() ? std::optional<Param>(old->second) : std::nullopt,
+                    res
+                });
+            }
+        }
+        // 上次有、这次文件中没有的参数
+        std::vector<std::string> removed;
+        for (const auto &[name, value]: this->values) {
+            if (params.find(name) != params.end()) {
+                continue;
+            }
+            removed.push_back(name);
+            debug::print(debug::PrintMode::INFO, "param", "参数 {} 已从文件中删除", name);
+            changes.push_back(ParamChange{name, value, value, true});
+        }
+        if (!updated.empty() || !removed.empty()) {
+            publish_snapshot(applied, removed);
+        }
+        // Handle 看到版本号变化时，新值所在的快照已经发布，不会读到重载一半的参数表
+        for (const auto &name: updated) {
+            auto &entry = this->handles[name];
+            if (entry.cell == nullptr) {
+                entry.cell = create_cell(name);
+            }
+            entry.cell->version.fetch_add(1, std::memory_order_release);
+        }
+        // 快照发布之后才创建umt对象，wait_for 一旦看到对象，快照中必然已有该参数
+        for (const auto &name: created) {
+            auto &entry = this->handles[name];
+            entry.param = create_object(name);
+            if (entry.param != nullptr) {
+                // umt对象只在创建时赋值一次，之后其他线程可能正在读取它
+                *entry.param = applied.at(name);
             } else {
-                if (*found != res) {
-                    const auto tmp = *found;
-                    *found = res;
-                    debug::print(
-                        debug::PrintMode::INFO,
-                        "param",
-                        "参数 {} 被修改: {} -> {}",
-                        prefix,
-                        std::visit(PARAM_VISITOR, tmp),
-                        std::visit(PARAM_VISITOR, res)
-                    );
-                }
+                // 已被其他模块创建
+                entry.param = find_param(name);
             }
         }
+        if (!created.empty()) {
+            notify_ready();
+        }
+        this->values = std::move(applied);
+        // 整批参数都生效后再通知
+        if (!changes.empty()) {
+            dispatch(changes);
+        }
     }
 
     void parameter_run(const std::string &param_file_path) {
         using namespace std::chrono_literals;
 
-        ParamManager manager;
-        manager.load_and_update(param_file_path);
+        ParamManager manager(param_file_path);
+        manager.load_and_update();
     }
 } // namespace base
\ No newline at end of file
@@ -4,27 +4,106 @@
 // C system headers
 
 // C++ system headers
+#include <atomic>
 #include <chrono>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <optional>
+#include <stdexcept>
 #include <string>
 #include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <variant>
+#include <vector>
 
 // Third-party library headers
 #include <opencv2/core/core.hpp>
 
 // Project headers
 #include <plugin/debug/logger.hpp>
+#include <plugin/param/param_types.hpp>
 #include <umt/umt.hpp>
 
 namespace runtime_param {
-	using Param = std::variant<bool, int64_t, double, std::string, std::vector<int64_t> >;
+	using Param = param_types::Param;
+	using param_types::ParamMatrix;
+	using param_types::ParamVector;
 
 	std::shared_ptr<Param> create_param(const std::string &name);
 
+	/**
+	 * @brief 查找参数对应的umt对象
+	 * 由参数文件加载的参数，对象中只保存首次加载的值，重载不会原地修改它；
+	 * 读取最新值请使用 get_param、Handle 或 pin_snapshot
+	 */
 	std::shared_ptr<Param> find_param(const std::string &name);
 
+	/**
+	 * @brief 参数的变更计数，新值所在的快照发布之后才递增，值本身只保存在快照中
+	 */
+	struct ParamCell {
+		std::atomic<uint64_t> version{0};
+	};
+
+	std::shared_ptr<ParamCell> find_cell(const std::string &name);
+
+	/**
+	 * @brief 一次重载中某个参数的变化
+	 */
+	struct ParamChange {
+		std::string name;
+		// 重载时新增的参数为空
+		std::optional<Param> old_value;
+		Param new_value;
+		// 参数已从文件中删除：快照中不再有它，new_value 为删除前的值，已绑定的 Handle 保留这个值
+		bool removed = false;
+	};
+
+	using ParamChanges = std::vector<ParamChange>;
+	using ChangeCallback = std::function<void(const ParamChanges &)>;
+
+	// 每次重载的全部变化也会整体发布到这个umt话题
+	inline const std::string PARAM_CHANGE_TOPIC = "param.changes";
+
+	/**
+	 * @brief 订阅某个参数或某个表下所有参数的变化
+	 * 每次重载后每个订阅最多回调一次，传入本次重载中匹配的全部变化；
+	 * 回调执行时本次重载的所有参数均已生效，在回调中读取同一个表不会读到一半新一半旧的值。
+	 * 回调在参数线程中执行，耗时操作请自行转交其他线程。首次加载不会触发回调。
+	 * @param prefix 参数名或表名，如 "Camera.config.ExposureTime"、"Camera.config"，为空时订阅全部参数
+	 * @param callback 回调
+	 * @return 订阅id，用于 unsubscribe
+	 */
+	uint64_t subscribe(const std::string &prefix, ChangeCallback callback);
+
+	/**
+	 * @brief 取消订阅，返回后回调不会再被调用
+	 * 在其他线程调用时会等待正在执行的回调结束
+	 */
+	void unsubscribe(uint64_t id);
+
+	/**
+	 * @brief 等待参数全部就绪
+	 * 参数文件首次加载完成(或有新参数出现)时立即唤醒，不轮询
+	 * @param names 参数名，首次加载完成的标志为 "ok"
+	 * @param timeout 最长等待时间
+	 * @return false 超时仍有参数未就绪
+	 */
+	bool wait_for(const std::vector<std::string> &names, std::chrono::milliseconds timeout);
+
+	/**
+	 * @brief 参数文件首次加载完成的标志名，如 ready_name("hardware.toml") == "ok.hardware.toml"
+	 * 同时运行多个参数文件时，"ok" 只表示其中任意一个加载完成
+	 */
+	std::string ready_name(const std::string &param_file_path);
+
+	/**
+	 * @brief 一直等到参数就绪，超过1秒时打印一次警告
+	 */
 	void wait_for_param(const std::string &name);
 
 	template<class... Ts>
@@ -40,11 +119,157 @@ namespace runtime_param {
 				[](const auto &arg) -> std::string { return fmt::format("{}", arg); },
 				[](const std::vector<int64_t> &arg) -> std::string {
 					return debug::vec_to_str<int64_t>(arg);
+				},
+				[](const ParamVector &arg) -> std::string {
+					return debug::vec_to_str<double>(arg);
 				}
 			};
 
+	/**
+	 * @brief 某一时刻全部参数的不可变快照
+	 * 每次重载完成后整体发布一个新快照，同一快照内的所有值来自同一批重载
+	 */
+	class ParamSnapshot {
+	public:
+		using Values = std::unordered_map<std::string, Param>;
+
+		ParamSnapshot(uint64_t version, Values values) : _version(version), _values(std::move(values)) {
+		}
+
+		/**
+		 * @brief 快照版本号，每次发布加一
+		 */
+		[[nodiscard]] uint64_t version() const noexcept {
+			return _version;
+		}
+
+		[[nodiscard]] bool contains(const std::string &name) const {
+			return _values.find(name) != _values.end();
+		}
+
+		/**
+		 * @brief 查找参数，不存在或类型不符时返回 nullptr
+		 * 返回的指针在快照被释放前有效
+		 */
+		template<typename T>
+		[[nodiscard]] const T *find(const std::string &name) const {
+			const auto iter = _values.find(name);
+			return iter == _values.end() ? nullptr : std::get_if<T>(&iter->second);
+		}
+
+		/**
+		 * @brief 读取参数，不存在或类型不符时打印错误并返回 T()
+		 */
+		template<typename T>
+		[[nodiscard]] T get(const std::string &name) const {
+			if (const T *value = find<T>(name)) {
+				return *value;
+			}
+			::debug::print(
+				::debug::PrintMode::ERROR,
+				"param",
+				"快照 {} 中找不到类型匹配的参数 \"{}\"，将返回 {}。",
+				_version,
+				name,
+				PARAM_VISITOR(T())
+			);
+			return T();
+		}
+
+		[[nodiscard]] const Values &values() const noexcept {
+			return _values;
+		}
+
+	private:
+		uint64_t _version;
+		Values _values;
+	};
+
+	/**
+	 * @brief 被钉住的快照，存活期间快照不会被回收
+	 * 只能移动；应短暂持有(如一帧)，长期持有会使发布方无可用槽位而等待
+	 */
+	class SnapshotPin {
+	public:
+		SnapshotPin() = default;
+
+		SnapshotPin(std::atomic<uint32_t> *readers, const ParamSnapshot *snapshot) noexcept
+			: _readers(readers), _snapshot(snapshot) {
+		}
+
+		SnapshotPin(SnapshotPin &&other) noexcept
+			: _readers(std::exchange(other._readers, nullptr)), _snapshot(std::exchange(other._snapshot, nullptr)) {
+		}
+
+		SnapshotPin &operator=(SnapshotPin &&other) noexcept {
+			if (this != &other) {
+				release();
+				_readers = std::exchange(other._readers, nullptr);
+				_snapshot = std::exchange(other._snapshot, nullptr);
+			}
+			return *this;
+		}
+
+		SnapshotPin(const SnapshotPin &) = delete;
+
+		SnapshotPin &operator=(const SnapshotPin &) = delete;
+
+		~SnapshotPin() {
+			release();
+		}
+
+		const ParamSnapshot &operator*() const noexcept {
+			return *_snapshot;
+		}
+
+		const ParamSnapshot *operator->() const noexcept {
+			return _snapshot;
+		}
+
+		explicit operator bool() const noexcept {
+			return _snapshot != nullptr;
+		}
+
+	private:
+		void release() noexcept {
+			if (_readers != nullptr) {
+				_readers->fetch_sub(1, std::memory_order_release);
+				_readers = nullptr;
+			}
+			_snapshot = nullptr;
+		}
+
+		std::atomic<uint32_t> *_readers = nullptr;
+		const ParamSnapshot *_snapshot = nullptr;
+	};
+
+	/**
+	 * @brief 钉住当前快照，读端无锁
+	 * 流水线在每帧开始时钉住一次，整帧从同一快照读取，不会读到重载一半的参数表。
+	 * 尚未加载任何参数时返回版本号为0的空快照。
+	 */
+	SnapshotPin pin_snapshot() noexcept;
+
 	template<typename T>
 	T get_param(const std::string &name) {
+		{
+			const auto snapshot = pin_snapshot();
+			if (const auto iter = snapshot->values().find(name); iter != snapshot->values().end()) {
+				if (const T *res = std::get_if<T>(&iter->second)) {
+					return *res;
+				}
+				T value = T();
+				::debug::print(
+					::debug::PrintMode::ERROR,
+					"param",
+					"get_param() 查询 \"{}\" 的类型错误，将返回 {}。",
+					name,
+					PARAM_VISITOR(value)
+				);
+				return value;
+			}
+		}
+		// 不是由参数文件加载的参数
 		auto ptr = find_param(name);
 		// 找不到 variant 实例
 		if (ptr == nullptr) {
@@ -75,6 +300,97 @@ namespace runtime_param {
 		return *res;
 	}
 
+	template<typename T, typename Variant>
+	struct is_variant_member;
+
+	template<typename T, typename... Ts>
+	struct is_variant_member<T, std::variant<Ts...> > : std::disjunction<std::is_same<T, Ts>...> {
+	};
+
+	/**
+	 * @brief 按名称绑定一次的类型化参数句柄
+	 * 绑定时检查类型；读取时只比较一次版本号，版本变化时从钉住的快照中拷贝新值，之后返回缓存值的引用。
+	 * 缓存值总是来自某个完整发布的快照，但不同句柄各自切换，需要多个参数彼此一致时请使用 pin_snapshot。
+	 * 句柄本身不加锁，不要在多个线程间共享同一个句柄，每个线程各自绑定即可。
+	 * @tparam T Param 中的某一种类型
+	 */
+	template<typename T>
+	class Handle {
+		static_assert(is_variant_member<T, Param>::value, "Handle<T> requires T to be one of the Param types");
+
+	public:
+		/**
+		 * @brief 绑定参数
+		 * @param name 参数名，如 "database.server"
+		 * @throws std::invalid_argument 参数不存在或类型不匹配
+		 */
+		explicit Handle(const std::string &name) : _name(name), _cell(find_cell(name)) {
+			if (_cell == nullptr) {
+				throw std::invalid_argument("param \"" + name + "\" not found");
+			}
+			refresh(_cell->version.load(std::memory_order_acquire));
+			if (!_value.has_value()) {
+				throw std::invalid_argument("param \"" + name + "\" type mismatch");
+			}
+		}
+
+		/**
+		 * @brief 当前值，参数被修改后的第一次调用会从新快照中拷贝
+		 * 返回的引用在下一次切换前有效
+		 */
+		const T &get() {
+			const uint64_t version = _cell->version.load(std::memory_order_acquire);
+			if (version != _version) {
+				refresh(version);
+			}
+			return *_value;
+		}
+
+		const T &operator*() {
+			return get();
+		}
+
+		const T *operator->() {
+			return &get();
+		}
+
+		/**
+		 * @brief 参数的最新版本号，每次被修改加一，可用于判断是否需要重建派生状态
+		 */
+		[[nodiscard]] uint64_t version() const noexcept {
+			return _cell->version.load(std::memory_order_acquire);
+		}
+
+		/**
+		 * @brief 缓存值所在快照的版本号，与 pin_snapshot()->version() 相同时两者读到的是同一批参数
+		 */
+		[[nodiscard]] uint64_t snapshot_version() const noexcept {
+			return _snapshot_version;
+		}
+
+		[[nodiscard]] const std::string &name() const noexcept {
+			return _name;
+		}
+
+	private:
+		void refresh(uint64_t version) {
+			// 只短暂钉住快照，长期持有会使发布方等待
+			const auto snapshot = pin_snapshot();
+			// 参数已从文件中删除时快照中没有它，保留删除前的值
+			if (const T *value = snapshot->template find<T>(_name)) {
+				_value = *value;
+				_snapshot_version = snapshot->version();
+			}
+			_version = version;
+		}
+
+		std::string _name;
+		std::shared_ptr<ParamCell> _cell;
+		std::optional<T> _value;
+		uint64_t _version = 0;
+		uint64_t _snapshot_version = 0;
+	};
+
 	class ParameterManager {
 	public:
 		explicit ParameterManager(const std::string &param_file_path) : param_file_path(param_file_path) {
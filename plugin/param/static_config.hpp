@@ -9,6 +9,7 @@
 
 // C++ system headers
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <stdexcept>
 #include <string>
@@ -20,40 +21,25 @@
 
 // Project headers
 #include "plugin/debug/logger.hpp"
+#include "plugin/param/config_registry.hpp"
+#include "plugin/param/param_types.hpp"
 
 // 定义 Param variant 类型
-using Param = std::variant<bool, int64_t, double, std::string, std::vector<int64_t> >;
+using Param = param_types::Param;
 
 namespace static_param {
     // 内部辅助函数，将 toml::node 转换为我们的 Param variant
-    // 与之前相同，这是核心转换逻辑
     inline Param get_value(const toml::node &node) {
-        if (node.is_boolean()) {
-            return (*node.as_boolean()).get();
+        if (auto value = param_types::to_param(node)) {
+            return std::move(*value);
         }
-        if (node.is_integer()) {
-            return (*node.as_integer()).get();
-        }
-        if (node.is_floating_point()) {
-            return (*node.as_floating_point()).get();
-        }
-        if (node.is_string()) {
-            return (*node.as_string()).get();
-        }
-        if (node.is_array() && (node.as_array()->is_homogeneous<int64_t>() || node.as_array()->empty())) {
-            std::vector<int64_t> vec_int;
-            for (const auto &ele: *node.as_array()) {
-                vec_int.push_back((*ele.as_integer()).get());
-            }
-            return vec_int;
-        }
-        // 如果遇到不支持的类型（例如，一个浮点数组或一个嵌套表）
+        // 如果遇到不支持的类型（例如，一个字符串数组或一个嵌套表）
         throw std::runtime_error("Unsupported TOML value type encountered.");
     }
 
 
     /**
-     * @brief 从配置目录加载并解析 TOML 文件（自动添加 CONFIG_DIR 前缀）。
+     * @brief 从配置目录加载并解析 TOML 文件（自动添加 CONFIG_DIR 前缀），经由 ConfigRegistry 缓存，同一文件只解析一次。
      *
      * @param filename TOML 文件名（不需要路径前缀）。
      * @return toml::table 解析后的 table 对象。
@@ -61,13 +47,62 @@ namespace static_param {
      */
     inline toml::table parse_file(const std::string &filename) {
         try {
-            return toml::parse_file(CONFIG_DIR"/" + filename);
-        } catch (const toml::parse_error &err) {
-            debug::print("error", "static_param", "Failed to parse config file '{}': {}", filename, err.what());
+            return load_file(filename)->table();
+        } catch (const std::exception &err) {
+            debug::print(debug::PrintMode::ERROR, "static_param", "Failed to parse config file '{}': {}", filename, err.what());
             throw;
         }
     }
 
+    /**
+     * @brief 从进程内缓存加载配置文件，同一文件只解析一次，之后按完整路径查表。
+     *
+     * @param filename TOML 文件名（不需要路径前缀）。
+     * @return 解析好的文件，可以在线程间共享。
+     * @throws std::runtime_error 如果读取或解析失败，抛出异常。
+     */
+    inline std::shared_ptr<const ConfigFile> open_file(const std::string &filename) {
+        try {
+            return load_file(filename);
+        } catch (const std::exception &err) {
+            debug::print(debug::PrintMode::ERROR, "static_param", "Failed to parse config file '{}': {}", filename, err.what());
+            throw;
+        }
+    }
+
+    /**
+    * @brief 从 open_file 返回的文件中按完整路径获取参数，只做一次哈希查找，不拆分路径也不构造临时 Param。
+    *
+    * @tparam T 你期望获取的类型 (e.g., int64_t, double, std::string)。
+    * @param file 由 open_file 返回的文件。
+    * @param path 完整路径 (e.g., "Camera.use_camera_sn")。
+    * @return T 获取到的参数值。如果找不到或类型不匹配，返回一个默认构造的 T() 并打印错误信息。
+    */
+    template<typename T>
+    T get_param(const ConfigFile &file, const std::string &path) {
+        const Param *value = file.find(path);
+        if (value == nullptr) {
+            debug::print(debug::PrintMode::ERROR,
+                         "static_param",
+                         "Parameter \"{}\" not found in {}. Returning default value.",
+                         path, file.name());
+            return T{};
+        }
+        if (const T *res = std::get_if<T>(value)) {
+            return *res;
+        }
+        debug::print(debug::PrintMode::ERROR,
+                     "static_param",
+                     "Parameter \"{}\" found but type mismatch. Returning default value.",
+                     path);
+        return T{};
+    }
+
+    template<typename T>
+    T get_param(const ConfigFile &file, const std::string &table_name, const std::string &key_name) {
+        return get_param<T>(file, table_name + "." + key_name);
+    }
+
     /**
     * @brief 从解析好的 TOML table 中获取一个指定类型的参数。
     *
@@ -83,7 +118,7 @@ namespace static_param {
         const toml::node *node = data.at_path(path).node();
 
         if (!node) {
-            debug::print("error",
+            debug::print(debug::PrintMode::ERROR,
                          "static_param",
                          "Parameter \"{}\" not found. Returning default value.",
                          path);
@@ -96,7 +131,7 @@ namespace static_param {
                 return *val;
             } else {
                 // 为了更好地报告错误，我们可以访问原始值
-                debug::print("error",
+                debug::print(debug::PrintMode::ERROR,
                              "static_param",
                              "Parameter \"{}\" found but type mismatch.Expected type that holds T,\
                                 but got incompatible type. Returning default value.",
@@ -104,7 +139,7 @@ namespace static_param {
                 return T{};
             }
         } catch (const std::runtime_error &e) {
-            debug::print("error",
+            debug::print(debug::PrintMode::ERROR,
                          "static_param",
                          "Failed to convert parameter \"{}\" :{}. Returning default value.",
                          path, e.what());
@@ -128,7 +163,7 @@ namespace static_param {
         const toml::table *sub_table = node ? node->as_table() : nullptr;
 
         if (!sub_table) {
-            debug::print("error",
+            debug::print(debug::PrintMode::ERROR,
                          "static_param",
                          "Table \"{}\" not found. Returning empty table.",
                          table_path);
@@ -141,7 +176,7 @@ namespace static_param {
                 Param value = get_value(node);
                 result.emplace_back(std::string(key), value);
             } catch (const std::runtime_error &e) {
-                debug::print("error",
+                debug::print(debug::PrintMode::ERROR,
                              "static_param",
                              "Skipping key \"{}\" in table \"{}\" due to error:{}",
                              key, table_path, e.what());
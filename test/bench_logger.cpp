@@ -0,0 +1,129 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// C system headers
+#include <fcntl.h>
+#include <unistd.h>
+
+// C++ system headers
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <string>
+
+// Third-party library headers
+#include <fmt/chrono.h>
+#include <fmt/color.h>
+#include <fmt/core.h>
+
+// Project headers
+#include "plugin/debug/logger.hpp"
+#include "plugin/debug/timestamp.hpp"
+
+namespace {
+    constexpr int TIMESTAMP_ITERATIONS = 2'000'000;
+    constexpr int LINE_ITERATIONS = 500'000;
+
+    // 阻止编译器把循环体整体优化掉
+    template<typename T>
+    inline void do_not_optimize(T const& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    template<typename F>
+    double run_ns_per_op(int iterations, F&& func) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            func(i);
+        }
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    }
+
+    void report_ns(const char* name, double ns) {
+        fmt::print("{:<36} {:>8.2f} ns/op\n", name, ns);
+    }
+
+    void report_lines(const char* name, double ns) {
+        fmt::print("{:<36} {:>8.2f} ns/line {:>12.0f} lines/s\n", name, ns, 1e9 / ns);
+    }
+
+    // 改动前的实现：每次调用 std::localtime 和完整的 fmt 时间格式化
+    std::string legacy_time_string() {
+        auto now = std::chrono::system_clock::now();
+        auto time_t_now = std::chrono::system_clock::to_time_t(now);
+        auto microseconds =
+                std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()) % 1000000 % 1000;
+        auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
+        return fmt::format("{:%H:%M:%S}.{:03},{:03}", *std::localtime(&time_t_now), milliseconds.count(),
+                           microseconds.count());
+    }
+
+    void legacy_write_line(debug::PrintMode mode, const std::string& node_name, const std::string& content) {
+        std::string full_message = fmt::format("{} {} {}: {}", legacy_time_string(), debug::PRINT_PREFIX.at(mode),
+                                               node_name.empty() ? "" : "@" + node_name, content);
+        fmt::print(fmt::fg(debug::PRINT_COLOR.at(mode)), "{}\n", full_message);
+    }
+
+    /**
+     * @brief 测量期间把标准输出重定向到 /dev/null，只计格式化和 write 的开销
+     */
+    template<typename F>
+    double run_silenced(F&& func) {
+        std::fflush(stdout);
+        const int saved = ::dup(STDOUT_FILENO);
+        const int null = ::open("/dev/null", O_WRONLY);
+        ::dup2(null, STDOUT_FILENO);
+        const double ns = run_ns_per_op(LINE_ITERATIONS, func);
+        std::fflush(stdout);
+        ::dup2(saved, STDOUT_FILENO);
+        ::close(null);
+        ::close(saved);
+        return ns;
+    }
+} // namespace
+
+int main() {
+    namespace timestamp = debug::timestamp;
+
+    fmt::print(fmt::fg(fmt::color::gold), "==================timestamp==================\n");
+
+    report_ns("legacy localtime + fmt", run_ns_per_op(TIMESTAMP_ITERATIONS, [](int) {
+        const auto value = legacy_time_string();
+        do_not_optimize(value.size());
+    }));
+    report_ns("cached wall clock", run_ns_per_op(TIMESTAMP_ITERATIONS, [](int) {
+        char text[timestamp::MAX_SIZE];
+        do_not_optimize(timestamp::format(timestamp::now_ns(timestamp::Clock::WALL), timestamp::Clock::WALL, text));
+    }));
+    report_ns("monotonic clock", run_ns_per_op(TIMESTAMP_ITERATIONS, [](int) {
+        char text[timestamp::MAX_SIZE];
+        do_not_optimize(timestamp::format(timestamp::now_ns(timestamp::Clock::MONOTONIC),
+                                          timestamp::Clock::MONOTONIC, text));
+    }));
+    report_ns("get_current_time_string", run_ns_per_op(TIMESTAMP_ITERATIONS, [](int) {
+        const auto value = debug::get_current_time_string();
+        do_not_optimize(value.size());
+    }));
+
+    fmt::print(fmt::fg(fmt::color::gold), "==================sync log line==================\n");
+
+    const double legacy = run_silenced([](int i) {
+        legacy_write_line(debug::PrintMode::INFO, "bench", fmt::format("frame {} latency {:.3f} ms", i, 1.25));
+    });
+    const double wall = run_silenced([](int i) {
+        RMCV_LOG(INFO, "bench", "frame {} latency {:.3f} ms", i, 1.25);
+    });
+    timestamp::use_clock(timestamp::Clock::MONOTONIC);
+    const double monotonic = run_silenced([](int i) {
+        RMCV_LOG(INFO, "bench", "frame {} latency {:.3f} ms", i, 1.25);
+    });
+    timestamp::use_clock(timestamp::Clock::WALL);
+
+    report_lines("legacy write_line", legacy);
+    report_lines("RMCV_LOG wall clock", wall);
+    report_lines("RMCV_LOG monotonic clock", monotonic);
+    return 0;
+}
@@ -0,0 +1,127 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// C system headers
+
+// C++ system headers
+#include <chrono>
+#include <cstdint>
+
+// Third-party library headers
+#include <fmt/color.h>
+#include <fmt/core.h>
+
+// Project headers
+#include "hardware/serial/fixed_packet.hpp"
+#include "hardware/serial/packet_schema.hpp"
+
+namespace {
+    struct GimbalCmd {
+        float yaw;
+        float pitch;
+        float distance;
+        uint8_t fire;
+        uint8_t mode;
+        uint16_t frame_id;
+    };
+
+    using GimbalCmdLittle = serial::PacketSchema<
+        GimbalCmd, serial::ByteOrder::Little,
+        &GimbalCmd::yaw, &GimbalCmd::pitch, &GimbalCmd::distance,
+        &GimbalCmd::fire, &GimbalCmd::mode, &GimbalCmd::frame_id>;
+    using GimbalCmdBig = serial::PacketSchema<
+        GimbalCmd, serial::ByteOrder::Big,
+        &GimbalCmd::yaw, &GimbalCmd::pitch, &GimbalCmd::distance,
+        &GimbalCmd::fire, &GimbalCmd::mode, &GimbalCmd::frame_id>;
+
+    static_assert(GimbalCmdLittle::PAYLOAD_SIZE == 16);
+    static_assert(GimbalCmdLittle::offset_of<3>() == 13);
+    static_assert(!GimbalCmdLittle::fits<16>() && GimbalCmdLittle::fits<32>());
+
+    constexpr int ITERATIONS = 20'000'000;
+
+    // 阻止编译器把循环体整体优化掉
+    template<typename T>
+    inline void do_not_optimize(T const& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    template<typename F>
+    double run_ns_per_op(F&& func) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ITERATIONS; ++i) {
+            func(i);
+        }
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+    }
+
+    void report(const char* name, double ns) {
+        fmt::print("{:<28} {:>8.2f} ns/op\n", name, ns);
+    }
+} // namespace
+
+int main() {
+    serial::FixedPacket32 packet;
+    GimbalCmd cmd { 1.5f, -0.25f, 4.0f, 1, 2, 0 };
+    GimbalCmd out {};
+
+    fmt::print(fmt::fg(fmt::color::gold), "==================FixedPacket encode/decode==================\n");
+
+    report("load_data (manual offsets)", run_ns_per_op([&](int i) {
+        cmd.frame_id = static_cast<uint16_t>(i);
+        bool ok = packet.load_data(cmd.yaw, 1).has_value();
+        ok &= packet.load_data(cmd.pitch, 5).has_value();
+        ok &= packet.load_data(cmd.distance, 9).has_value();
+        ok &= packet.load_data(cmd.fire, 13).has_value();
+        ok &= packet.load_data(cmd.mode, 14).has_value();
+        ok &= packet.load_data(cmd.frame_id, 15).has_value();
+        do_not_optimize(ok);
+        do_not_optimize(packet);
+    }));
+
+    report("schema encode (little)", run_ns_per_op([&](int i) {
+        cmd.frame_id = static_cast<uint16_t>(i);
+        GimbalCmdLittle::encode(cmd, packet);
+        do_not_optimize(packet);
+    }));
+
+    report("schema encode (big)", run_ns_per_op([&](int i) {
+        cmd.frame_id = static_cast<uint16_t>(i);
+        GimbalCmdBig::encode(cmd, packet);
+        do_not_optimize(packet);
+    }));
+
+    GimbalCmdLittle::encode(cmd, packet);
+    report("unload_data (manual offsets)", run_ns_per_op([&](int) {
+        bool ok = packet.unload_data(out.yaw, 1).has_value();
+        ok &= packet.unload_data(out.pitch, 5).has_value();
+        ok &= packet.unload_data(out.distance, 9).has_value();
+        ok &= packet.unload_data(out.fire, 13).has_value();
+        ok &= packet.unload_data(out.mode, 14).has_value();
+        ok &= packet.unload_data(out.frame_id, 15).has_value();
+        do_not_optimize(ok);
+        do_not_optimize(out);
+    }));
+
+    report("schema decode (little)", run_ns_per_op([&](int) {
+        GimbalCmdLittle::decode(packet, out);
+        do_not_optimize(out);
+    }));
+
+    GimbalCmdBig::encode(cmd, packet);
+    report("schema decode (big)", run_ns_per_op([&](int) {
+        GimbalCmdBig::decode(packet, out);
+        do_not_optimize(out);
+    }));
+
+    // 往返校验
+    GimbalCmdBig::encode(cmd, packet);
+    const auto decoded = GimbalCmdBig::decode(packet);
+    if (decoded.yaw != cmd.yaw || decoded.pitch != cmd.pitch || decoded.frame_id != cmd.frame_id) {
+        fmt::print(fmt::fg(fmt::color::red), "round trip mismatch!\n");
+        return 1;
+    }
+    return 0;
+}
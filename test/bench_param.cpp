@@ -0,0 +1,143 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// C system headers
+
+// C++ system headers
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Third-party library headers
+#include <fmt/color.h>
+#include <fmt/core.h>
+
+// Project headers
+#include "param/runtime_parameter.hpp"
+#include "param/static_config.hpp"
+#include "plugin/debug/logger.hpp"
+
+namespace {
+    constexpr int ITERATIONS = 2'000'000;
+
+    // 阻止编译器把循环体整体优化掉
+    template<typename T>
+    inline void do_not_optimize(T const& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    template<typename F>
+    double run_ns_per_op(F&& func) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ITERATIONS; ++i) {
+            func();
+        }
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+    }
+
+    void report(const char* name, double ns) {
+        fmt::print("{:<36} {:>8.2f} ns/op\n", name, ns);
+    }
+} // namespace
+
+int main() {
+    const auto param_file_name = "test.toml";
+    std::thread([=]() { runtime_param::parameter_run(param_file_name); }).detach();
+    runtime_param::wait_for_param("ok");
+
+    fmt::print(fmt::fg(fmt::color::gold), "==================runtime param read==================\n");
+
+    report("get_param<int64_t>", run_ns_per_op([]() {
+        do_not_optimize(runtime_param::get_param<int64_t>("database.connection_max"));
+    }));
+    report("get_param<bool>", run_ns_per_op([]() {
+        do_not_optimize(runtime_param::get_param<bool>("database.enabled"));
+    }));
+    report("get_param<std::string>", run_ns_per_op([]() {
+        const auto value = runtime_param::get_param<std::string>("database.server");
+        do_not_optimize(value.size());
+    }));
+    report("get_param<std::vector<int64_t>>", run_ns_per_op([]() {
+        const auto value = runtime_param::get_param<std::vector<int64_t> >("database.ports");
+        do_not_optimize(value.size());
+    }));
+
+    runtime_param::Handle<int64_t> connection_max("database.connection_max");
+    runtime_param::Handle<bool> enabled("database.enabled");
+    runtime_param::Handle<std::string> server("database.server");
+    runtime_param::Handle<std::vector<int64_t> > ports("database.ports");
+
+    report("Handle<int64_t>::get", run_ns_per_op([&]() {
+        do_not_optimize(connection_max.get());
+    }));
+    report("Handle<bool>::get", run_ns_per_op([&]() {
+        do_not_optimize(enabled.get());
+    }));
+    report("Handle<std::string>::get", run_ns_per_op([&]() {
+        do_not_optimize(server.get().size());
+    }));
+    report("Handle<std::vector<int64_t>>::get", run_ns_per_op([&]() {
+        do_not_optimize(ports.get().size());
+    }));
+    report("Handle::version", run_ns_per_op([&]() {
+        do_not_optimize(connection_max.version());
+    }));
+
+    report("pin_snapshot", run_ns_per_op([]() {
+        const auto snapshot = runtime_param::pin_snapshot();
+        do_not_optimize(snapshot->version());
+    }));
+    {
+        const auto snapshot = runtime_param::pin_snapshot();
+        report("ParamSnapshot::find<int64_t>", run_ns_per_op([&]() {
+            do_not_optimize(*snapshot->find<int64_t>("database.connection_max"));
+        }));
+    }
+
+    fmt::print(fmt::fg(fmt::color::gold), "==================static param read===================\n");
+
+    {
+        const auto start = std::chrono::steady_clock::now();
+        constexpr int parse_count = 1000;
+        for (int i = 0; i < parse_count; ++i) {
+            const auto table = toml::parse_file(CONFIG_DIR "/test.toml");
+            do_not_optimize(table.size());
+        }
+        const auto end = std::chrono::steady_clock::now();
+        report("toml::parse_file", std::chrono::duration<double, std::nano>(end - start).count() / parse_count);
+    }
+    report("static_param::open_file (cached)", run_ns_per_op([]() {
+        const auto file = static_param::open_file("test.toml");
+        do_not_optimize(file->hash());
+    }));
+    {
+        const auto file = static_param::open_file("test.toml");
+        const auto& table = file->table();
+        report("get_param<int64_t>(table, at_path)", run_ns_per_op([&]() {
+            do_not_optimize(static_param::get_param<int64_t>(table, "database", "connection_max"));
+        }));
+        report("get_param<int64_t>(ConfigFile)", run_ns_per_op([&]() {
+            do_not_optimize(static_param::get_param<int64_t>(*file, "database.connection_max"));
+        }));
+    }
+
+    if (connection_max.get() != runtime_param::get_param<int64_t>("database.connection_max")
+        || server.get() != runtime_param::get_param<std::string>("database.server")) {
+        fmt::print(fmt::fg(fmt::color::red), "handle and get_param disagree!\n");
+        return 1;
+    }
+
+    // 绑定时的类型检查
+    try {
+        runtime_param::Handle<double> wrong("database.connection_max");
+        fmt::print(fmt::fg(fmt::color::red), "type mismatch not detected!\n");
+        return 1;
+    } catch (const std::invalid_argument& e) {
+        debug::print(debug::PrintMode::INFO, "bench_param", "expected: {}", e.what());
+    }
+    return 0;
+}
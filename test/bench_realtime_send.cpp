@@ -0,0 +1,136 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// C system headers
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+
+// C++ system headers
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Third-party library headers
+#include <fmt/color.h>
+#include <fmt/core.h>
+
+// Project headers
+#include "hardware/serial/protocol/uart_protocol.hpp"
+#include "hardware/serial/transceiver_manager.hpp"
+
+namespace {
+    using Manager = serial::TransceiverManager<16>;
+    constexpr int PACKET_COUNT = 2000;
+
+    int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    double percentile(std::vector<int64_t>& samples, double p) {
+        if (samples.empty()) {
+            return 0.0;
+        }
+        const auto idx = static_cast<std::size_t>(p * static_cast<double>(samples.size() - 1));
+        std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+        return static_cast<double>(samples[idx]) / 1000.0;
+    }
+
+    // 在pty主端收包，统计从send_packet到数据出现在对端的延迟
+    void run(const char* name, Manager::SendMode mode, std::chrono::microseconds interval) {
+        int master = -1;
+        int slave = -1;
+        char slave_name[128] = {};
+        if (openpty(&master, &slave, slave_name, nullptr, nullptr) != 0) {
+            fmt::print(fmt::fg(fmt::color::red), "openpty failed\n");
+            return;
+        }
+        termios options {};
+        tcgetattr(master, &options);
+        cfmakeraw(&options);
+        tcsetattr(master, TCSANOW, &options);
+
+        auto uart = std::make_shared<UartProtocol>(slave_name);
+        if (!uart->open()) {
+            fmt::print(fmt::fg(fmt::color::red), "open {} failed: {}\n", slave_name, uart->error_message());
+            ::close(master);
+            ::close(slave);
+            return;
+        }
+
+        std::vector<int64_t> latencies;
+        latencies.reserve(PACKET_COUNT);
+        std::atomic<bool> running { true };
+        std::thread reader([&]() {
+            std::vector<uint8_t> pending;
+            uint8_t buf[4096];
+            while (running) {
+                const auto len = ::read(master, buf, sizeof(buf));
+                if (len <= 0) {
+                    continue;
+                }
+                const int64_t recv_ns = now_ns();
+                pending.insert(pending.end(), buf, buf + len);
+                std::size_t pos = 0;
+                while (pending.size() - pos >= 16) {
+                    if (pending[pos] != Manager::PacketType::HEAD_BYTE || pending[pos + 15] != Manager::PacketType::TAIL_BYTE) {
+                        ++pos;
+                        continue;
+                    }
+                    int64_t sent_ns = 0;
+                    std::memcpy(&sent_ns, pending.data() + pos + 1, sizeof(sent_ns));
+                    if (sent_ns < 0) {
+                        running = false;
+                        break;
+                    }
+                    latencies.push_back(recv_ns - sent_ns);
+                    pos += 16;
+                }
+                pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(pos));
+            }
+        });
+
+        {
+            Manager manager(uart, mode, 8);
+            manager.enable_realtime_send(true);
+            Manager::PacketType packet;
+            auto next = std::chrono::steady_clock::now();
+            for (int i = 0; i < PACKET_COUNT; ++i) {
+                next += interval;
+                std::this_thread::sleep_until(next);
+                (void)packet.load_data(now_ns(), 1);
+                (void)manager.send_packet(packet);
+            }
+            // 结束标记
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            (void)packet.load_data(int64_t { -1 }, 1);
+            (void)manager.send_packet(packet);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        running = false;
+        ::close(slave);
+        ::close(master);
+        reader.join();
+
+        const auto received = latencies.size();
+        fmt::print("{:<24} recv {:>5}/{}  p50 {:>8.1f} us  p99 {:>8.1f} us  max {:>8.1f} us\n",
+                   name, received, PACKET_COUNT,
+                   percentile(latencies, 0.5), percentile(latencies, 0.99), percentile(latencies, 1.0));
+    }
+} // namespace
+
+int main() {
+    using namespace std::chrono_literals;
+    fmt::print(fmt::fg(fmt::color::gold), "==================realtime send latency over pty==================\n");
+    run("FIFO 1kHz", Manager::SendMode::FIFO, 1000us);
+    run("LATEST_ONLY 1kHz", Manager::SendMode::LATEST_ONLY, 1000us);
+    run("LIMITED_FIFO 1kHz", Manager::SendMode::LIMITED_FIFO, 1000us);
+    run("FIFO burst", Manager::SendMode::FIFO, 5us);
+    run("LATEST_ONLY burst", Manager::SendMode::LATEST_ONLY, 5us);
+    return 0;
+}
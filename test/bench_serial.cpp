@@ -0,0 +1,459 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// 串口链路基准测试，结果以JSON写入argv[1](默认bench_serial.json)，同时在终端打印摘要
+//   roundtrip: 每个后端、每种包长的往返延迟p50/p99/p99.9和流水线吞吐
+//   cpu:       各发送模式和实时接收在本进程内消耗的CPU时间/包，对端放在子进程中不计入
+// 后端: pty  - UartProtocol打开raw pty从端，主端由子进程回传
+//       sim  - SimProtocol，进程内McuEmulator回传(echo)
+// UsbBulkProtocol需要真实设备，不在此测试
+
+// C system headers
+#include <pty.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+// C++ system headers
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Third-party library headers
+#include <fmt/core.h>
+
+// Project headers
+#include "hardware/serial/protocol/uart_protocol.hpp"
+#include "hardware/serial/sim/sim_protocol.hpp"
+#include "hardware/serial/transceiver_manager.hpp"
+
+namespace {
+    constexpr int ROUNDTRIP_COUNT = 2000;
+    constexpr int THROUGHPUT_COUNT = 20000;
+    // 流水线模式下未返回的包数上限，避免写满pty缓冲区
+    constexpr int THROUGHPUT_WINDOW = 16;
+    // 丢包或链路断开时各阶段最多等待的时间
+    constexpr auto ROUNDTRIP_TIMEOUT = std::chrono::seconds(10);
+    constexpr auto THROUGHPUT_TIMEOUT = std::chrono::seconds(30);
+    constexpr int CPU_SEND_COUNT = 5000;
+    constexpr auto CPU_SEND_INTERVAL = std::chrono::microseconds(20);
+    constexpr auto CPU_READ_DURATION = std::chrono::milliseconds(500);
+    constexpr auto CPU_READ_INTERVAL = std::chrono::microseconds(100);
+
+    enum class PeerMode {
+        LOOPBACK, // 原样回传
+        SINK,     // 只读不回
+        STREAM    // 按固定间隔发包
+    };
+
+    int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    int64_t process_cpu_ns() {
+        timespec ts {};
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+    }
+
+    double percentile_us(std::vector<int64_t>& samples, double p) {
+        if (samples.empty()) {
+            return 0.0;
+        }
+        const auto idx = static_cast<std::size_t>(p * static_cast<double>(samples.size() - 1));
+        std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+        return static_cast<double>(samples[idx]) / 1000.0;
+    }
+
+    /**
+     * @brief raw模式的pty，从端交给UartProtocol，主端交给对端子进程
+     */
+    struct PtyPeer {
+        int master { -1 };
+        int slave { -1 };
+        pid_t pid { -1 };
+        std::string slave_name;
+
+        bool open() {
+            termios options {};
+            cfmakeraw(&options);
+            char name[128] = {};
+            if (openpty(&master, &slave, name, &options, nullptr) != 0) {
+                return false;
+            }
+            slave_name = name;
+            return true;
+        }
+
+        /**
+         * @brief fork出对端进程，子进程只做read/write，不触碰父进程的其他状态
+         * @param packet STREAM模式下循环发送的数据
+         */
+        void spawn(PeerMode mode, const std::vector<uint8_t>& packet = {}, std::chrono::microseconds interval = {}) {
+            pid = fork();
+            if (pid != 0) {
+                return;
+            }
+            uint8_t buf[4096];
+            if (mode == PeerMode::STREAM) {
+                timespec next {};
+                clock_gettime(CLOCK_MONOTONIC, &next);
+                while (true) {
+                    next.tv_nsec += interval.count() * 1000;
+                    while (next.tv_nsec >= 1'000'000'000) {
+                        next.tv_nsec -= 1'000'000'000;
+                        ++next.tv_sec;
+                    }
+                    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+                    (void)::write(master, packet.data(), packet.size());
+                }
+            }
+            while (true) {
+                const auto len = ::read(master, buf, sizeof(buf));
+                if (len <= 0) {
+                    _exit(0);
+                }
+                if (mode == PeerMode::LOOPBACK) {
+                    (void)::write(master, buf, static_cast<std::size_t>(len));
+                }
+            }
+        }
+
+        ~PtyPeer() {
+            if (pid > 0) {
+                kill(pid, SIGKILL);
+                waitpid(pid, nullptr, 0);
+            }
+            if (slave >= 0) {
+                ::close(slave);
+            }
+            if (master >= 0) {
+                ::close(master);
+            }
+        }
+    };
+
+    /**
+     * @brief 超时仍未finish()时打断阻塞中的读写，丢包或链路断开时测试不会一直等下去
+     */
+    class Watchdog {
+    public:
+        Watchdog(std::shared_ptr<ProtocolInterface> transporter, std::chrono::milliseconds timeout)
+            : _thread([this, transporter = std::move(transporter), timeout]() {
+                  std::unique_lock<std::mutex> lock(_mutex);
+                  if (!_cv.wait_for(lock, timeout, [this]() { return _finished; })) {
+                      _expired.store(true, std::memory_order_release);
+                      transporter->interrupt();
+                  }
+              }) {}
+
+        ~Watchdog() {
+            finish();
+            _thread.join();
+        }
+
+        void finish() {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _finished = true;
+            }
+            _cv.notify_all();
+        }
+
+        [[nodiscard]] bool expired() const noexcept {
+            return _expired.load(std::memory_order_acquire);
+        }
+
+    private:
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        bool _finished { false };
+        std::atomic<bool> _expired { false };
+        // 最后构造，线程启动时其他成员已就绪
+        std::thread _thread;
+    };
+
+    struct RoundtripResult {
+        std::string backend;
+        std::size_t packet_size;
+        std::size_t received;
+        double p50, p99, p999, max;
+        double packets_per_s;
+    };
+
+    struct CpuResult {
+        std::string backend;
+        std::size_t packet_size;
+        std::string path;
+        uint64_t packets;
+        uint64_t packets_on_wire;
+        double cpu_us_per_packet;
+    };
+
+    template<std::size_t N>
+    void stamp_packet(serial::FixedPacket<N>& packet, int64_t stamp) {
+        static_assert(N >= sizeof(int64_t) + 3, "packet too small for a timestamp");
+        (void)packet.load_data(stamp, 1);
+    }
+
+    template<std::size_t N>
+    int64_t read_stamp(const serial::FixedPacket<N>& packet) {
+        int64_t stamp = 0;
+        (void)packet.unload_data(stamp, 1);
+        return stamp;
+    }
+
+    /**
+     * @brief 往返延迟(一问一答)与流水线吞吐
+     */
+    template<std::size_t N>
+    RoundtripResult run_roundtrip(const std::string& backend, const std::shared_ptr<ProtocolInterface>& transporter) {
+        using Manager = serial::TransceiverManager<N>;
+        Manager manager(transporter);
+        typename Manager::PacketType tx;
+        typename Manager::PacketType rx;
+
+        std::vector<int64_t> rtts;
+        rtts.reserve(ROUNDTRIP_COUNT);
+        {
+            Watchdog watchdog(transporter, ROUNDTRIP_TIMEOUT);
+            for (int i = 0; i < ROUNDTRIP_COUNT; ++i) {
+                stamp_packet(tx, now_ns());
+                if (!manager.send_packet(tx)) {
+                    break;
+                }
+                // 断帧，继续读直到拼出完整的包
+                bool ok = manager.recv_packet(rx);
+                while (!ok && !watchdog.expired()) {
+                    ok = manager.recv_packet(rx);
+                }
+                if (!ok) {
+                    break;
+                }
+                rtts.push_back(now_ns() - read_stamp(rx));
+            }
+        }
+
+        RoundtripResult result { backend, N, rtts.size(), 0, 0, 0, 0, 0 };
+        result.p50 = percentile_us(rtts, 0.5);
+        result.p99 = percentile_us(rtts, 0.99);
+        result.p999 = percentile_us(rtts, 0.999);
+        result.max = percentile_us(rtts, 1.0);
+        if (rtts.size() < static_cast<std::size_t>(ROUNDTRIP_COUNT)) {
+            // 链路已被打断，不再测吞吐
+            fmt::print(stderr, "{} {}B: only {} of {} round trips completed, packet lost or link down\n",
+                       backend, N, rtts.size(), ROUNDTRIP_COUNT);
+            return result;
+        }
+
+        std::atomic<int> received { 0 };
+        Watchdog watchdog(transporter, THROUGHPUT_TIMEOUT);
+        const int64_t begin = now_ns();
+        std::thread writer([&]() {
+            typename Manager::PacketType packet;
+            for (int i = 0; i < THROUGHPUT_COUNT && !watchdog.expired(); ++i) {
+                while (i - received.load(std::memory_order_acquire) >= THROUGHPUT_WINDOW && !watchdog.expired()) {
+                    std::this_thread::yield();
+                }
+                stamp_packet(packet, static_cast<int64_t>(i));
+                (void)manager.send_packet(packet);
+            }
+        });
+        while (received.load(std::memory_order_relaxed) < THROUGHPUT_COUNT && !watchdog.expired()) {
+            if (manager.recv_packet(rx)) {
+                received.fetch_add(1, std::memory_order_release);
+            }
+        }
+        const double elapsed_s = static_cast<double>(now_ns() - begin) / 1e9;
+        watchdog.finish();
+        writer.join();
+
+        const int throughput_received = received.load(std::memory_order_relaxed);
+        if (throughput_received < THROUGHPUT_COUNT) {
+            fmt::print(stderr, "{} {}B: {} of {} pipelined packets lost or stuck after {:.0f} s\n",
+                       backend, N, THROUGHPUT_COUNT - throughput_received, THROUGHPUT_COUNT, elapsed_s);
+        }
+        result.packets_per_s = throughput_received / elapsed_s;
+        return result;
+    }
+
+    template<std::size_t N>
+    RoundtripResult run_pty_roundtrip() {
+        PtyPeer peer;
+        if (!peer.open()) {
+            fmt::print(stderr, "openpty failed\n");
+            return { "pty", N, 0, 0, 0, 0, 0, 0 };
+        }
+        auto uart = std::make_shared<UartProtocol>(peer.slave_name);
+        if (!uart->open()) {
+            fmt::print(stderr, "open {} failed: {}\n", peer.slave_name, uart->error_message());
+            return { "pty", N, 0, 0, 0, 0, 0, 0 };
+        }
+        peer.spawn(PeerMode::LOOPBACK);
+        return run_roundtrip<N>("pty", uart);
+    }
+
+    template<std::size_t N>
+    RoundtripResult run_sim_roundtrip() {
+        serial::sim::McuEmulator::Options options;
+        options.rate_hz = 0.0;
+        options.echo = true;
+        options.log_commands = false;
+        auto sim = std::make_shared<SimProtocol>(options);
+        if (!sim->open()) {
+            fmt::print(stderr, "open sim failed: {}\n", sim->error_message());
+            return { "sim", N, 0, 0, 0, 0, 0, 0 };
+        }
+        return run_roundtrip<N>("sim", sim);
+    }
+
+    /**
+     * @brief 实时发送模式下每个send_packet的CPU开销(含写线程)
+     */
+    template<std::size_t N>
+    CpuResult run_send_cpu(const char* path, typename serial::TransceiverManager<N>::SendMode mode) {
+        CpuResult result { "pty", N, path, 0, 0, 0.0 };
+        PtyPeer peer;
+        if (!peer.open()) {
+            return result;
+        }
+        auto uart = std::make_shared<UartProtocol>(peer.slave_name);
+        if (!uart->open()) {
+            return result;
+        }
+        peer.spawn(PeerMode::SINK);
+        {
+            serial::TransceiverManager<N> manager(uart, mode, 8);
+            manager.enable_realtime_send(true);
+            typename serial::TransceiverManager<N>::PacketType packet;
+            const int64_t cpu_begin = process_cpu_ns();
+            auto next = std::chrono::steady_clock::now();
+            for (int i = 0; i < CPU_SEND_COUNT; ++i) {
+                next += CPU_SEND_INTERVAL;
+                std::this_thread::sleep_until(next);
+                stamp_packet(packet, now_ns());
+                (void)manager.send_packet(packet);
+            }
+            manager.enable_realtime_send(false);
+            const int64_t cpu_ns = process_cpu_ns() - cpu_begin;
+            result.packets = CPU_SEND_COUNT;
+            result.packets_on_wire = manager.link_stats().packets_tx;
+            result.cpu_us_per_packet = static_cast<double>(cpu_ns) / 1000.0 / CPU_SEND_COUNT;
+        }
+        return result;
+    }
+
+    /**
+     * @brief 实时接收线程每收到一个包的CPU开销
+     */
+    template<std::size_t N>
+    CpuResult run_read_cpu() {
+        CpuResult result { "pty", N, "realtime_read", 0, 0, 0.0 };
+        PtyPeer peer;
+        if (!peer.open()) {
+            return result;
+        }
+        auto uart = std::make_shared<UartProtocol>(peer.slave_name);
+        if (!uart->open()) {
+            return result;
+        }
+        serial::FixedPacket<N> packet;
+        stamp_packet(packet, 0);
+        peer.spawn(PeerMode::STREAM, std::vector<uint8_t>(packet.buffer(), packet.buffer() + N), CPU_READ_INTERVAL);
+
+        serial::TransceiverManager<N> manager(uart);
+        std::atomic<uint64_t> received { 0 };
+        manager.set_packet_callback([&](const serial::FixedPacket<N>&, typename serial::TransceiverManager<N>::Clock::time_point) {
+            received.fetch_add(1, std::memory_order_relaxed);
+        });
+        const int64_t cpu_begin = process_cpu_ns();
+        manager.enable_realtime_read(true);
+        std::this_thread::sleep_for(CPU_READ_DURATION);
+        // 对端仍在发包，接收线程能从阻塞的read中返回
+        manager.enable_realtime_read(false);
+        const int64_t cpu_ns = process_cpu_ns() - cpu_begin;
+
+        result.packets = received.load();
+        result.packets_on_wire = manager.link_stats().packets_rx;
+        if (result.packets > 0) {
+            result.cpu_us_per_packet = static_cast<double>(cpu_ns) / 1000.0 / static_cast<double>(result.packets);
+        }
+        return result;
+    }
+
+    template<std::size_t N>
+    void run_size(std::vector<RoundtripResult>& roundtrips, std::vector<CpuResult>& cpus) {
+        using Manager = serial::TransceiverManager<N>;
+        fmt::print(stderr, "FixedPacket{}: roundtrip...\n", N);
+        roundtrips.push_back(run_pty_roundtrip<N>());
+        roundtrips.push_back(run_sim_roundtrip<N>());
+        fmt::print(stderr, "FixedPacket{}: cpu...\n", N);
+        cpus.push_back(run_send_cpu<N>("send_fifo", Manager::SendMode::FIFO));
+        cpus.push_back(run_send_cpu<N>("send_latest_only", Manager::SendMode::LATEST_ONLY));
+        cpus.push_back(run_send_cpu<N>("send_limited_fifo", Manager::SendMode::LIMITED_FIFO));
+        cpus.push_back(run_read_cpu<N>());
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    // 对端子进程退出时不要让写操作杀死本进程
+    signal(SIGPIPE, SIG_IGN);
+
+    std::vector<RoundtripResult> roundtrips;
+    std::vector<CpuResult> cpus;
+    run_size<16>(roundtrips, cpus);
+    run_size<32>(roundtrips, cpus);
+    run_size<64>(roundtrips, cpus);
+
+    std::string json = "{\n  \"benchmark\": \"serial\",\n  \"roundtrip\": [\n";
+    for (std::size_t i = 0; i < roundtrips.size(); ++i) {
+        const auto& r = roundtrips[i];
+        json += fmt::format(
+            "    {{\"backend\": \"{}\", \"packet_size\": {}, \"samples\": {}, "
+            "\"rtt_us\": {{\"p50\": {:.2f}, \"p99\": {:.2f}, \"p99.9\": {:.2f}, \"max\": {:.2f}}}, "
+            "\"packets_per_s\": {:.0f}}}{}\n",
+            r.backend, r.packet_size, r.received, r.p50, r.p99, r.p999, r.max, r.packets_per_s,
+            i + 1 < roundtrips.size() ? "," : "");
+    }
+    json += "  ],\n  \"cpu\": [\n";
+    for (std::size_t i = 0; i < cpus.size(); ++i) {
+        const auto& c = cpus[i];
+        json += fmt::format(
+            "    {{\"backend\": \"{}\", \"packet_size\": {}, \"path\": \"{}\", \"packets\": {}, "
+            "\"packets_on_wire\": {}, \"cpu_us_per_packet\": {:.3f}}}{}\n",
+            c.backend, c.packet_size, c.path, c.packets, c.packets_on_wire, c.cpu_us_per_packet,
+            i + 1 < cpus.size() ? "," : "");
+    }
+    json += "  ]\n}\n";
+
+    for (const auto& r: roundtrips) {
+        fmt::print("{:<4} {:>2}B  rtt p50 {:>7.1f} us  p99 {:>7.1f} us  p99.9 {:>7.1f} us  {:>8.0f} pkt/s\n",
+                   r.backend, r.packet_size, r.p50, r.p99, r.p999, r.packets_per_s);
+    }
+    for (const auto& c: cpus) {
+        fmt::print("{:<4} {:>2}B  {:<18} {:>6.2f} us cpu/pkt  ({} on wire)\n",
+                   c.backend, c.packet_size, c.path, c.cpu_us_per_packet, c.packets_on_wire);
+    }
+
+    const char* path = argc > 1 ? argv[1] : "bench_serial.json";
+    std::FILE* file = std::fopen(path, "w");
+    if (file == nullptr) {
+        fmt::print(stderr, "can't open {}\n", path);
+        return 1;
+    }
+    std::fputs(json.c_str(), file);
+    std::fclose(file);
+    fmt::print("results written to {}\n", path);
+    return 0;
+}
@@ -0,0 +1,120 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// C system headers
+
+// C++ system headers
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+// Third-party library headers
+#include <fmt/core.h>
+
+// Project headers
+#include "hardware/serial/attitude_history.hpp"
+
+namespace {
+    using Clock = serial::AttitudeHistory::Clock;
+    using std::chrono::milliseconds;
+
+    int g_failures = 0;
+
+    void check(bool condition, const char *what) {
+        if (!condition) {
+            fmt::print(stderr, "FAILED: {}\n", what);
+            ++g_failures;
+        }
+    }
+
+    bool near(double a, double b, double tolerance = 1e-6) {
+        return std::abs(a - b) <= tolerance;
+    }
+
+    double yaw_at(const serial::AttitudeHistory &history, Clock::time_point t) {
+        const auto euler = history.query_euler(t);
+        return euler ? (*euler)[0] : std::nan("");
+    }
+
+    void test_empty() {
+        serial::AttitudeHistory history;
+        check(!history.latest(), "empty history has no latest sample");
+        check(!history.query(Clock::now()), "empty history rejects queries");
+    }
+
+    void test_interpolation() {
+        serial::AttitudeHistory history;
+        const auto t0 = Clock::now();
+        // yaw 每 10ms 增加 0.1rad
+        for (int i = 0; i < 10; ++i) {
+            check(history.push(t0 + milliseconds(10 * i), 0.1 * i, 0.0, 0.0), "push in order");
+        }
+        check(near(yaw_at(history, t0 + milliseconds(30)), 0.3), "exact sample");
+        check(near(yaw_at(history, t0 + milliseconds(35)), 0.35), "midpoint slerp");
+        check(near(yaw_at(history, t0 + milliseconds(72)), 0.72), "fractional slerp");
+        check(!history.push(t0 + milliseconds(5), 0.0, 0.0, 0.0), "out-of-order push is rejected");
+        check(history.size() == 10, "rejected push does not change size");
+    }
+
+    void test_extrapolation_limit() {
+        serial::AttitudeHistory history(64, milliseconds(20));
+        const auto t0 = Clock::now();
+        history.push(t0, 0.0, 0.0, 0.0);
+        history.push(t0 + milliseconds(10), 0.1, 0.0, 0.0);
+        check(near(yaw_at(history, t0 + milliseconds(20)), 0.2), "extrapolates with the last angular velocity");
+        check(near(yaw_at(history, t0 + milliseconds(30)), 0.3), "extrapolates up to the limit");
+        check(!history.query(t0 + milliseconds(31)), "rejects queries past the extrapolation limit");
+    }
+
+    void test_out_of_range() {
+        // 容量 8，写入 20 个样本后最旧的已被覆盖
+        serial::AttitudeHistory history(8);
+        const auto t0 = Clock::now();
+        for (int i = 0; i < 20; ++i) {
+            history.push(t0 + milliseconds(i), 0.01 * i, 0.0, 0.0);
+        }
+        check(history.size() == 8, "size is capped at capacity");
+        check(!history.query(t0 - milliseconds(1)), "rejects queries before the first sample");
+        check(!history.query(t0 + milliseconds(5)), "rejects queries older than the retained window");
+        check(near(yaw_at(history, t0 + milliseconds(18)), 0.18), "answers queries inside the retained window");
+    }
+
+    void test_concurrent_readers() {
+        serial::AttitudeHistory history(256);
+        const auto t0 = Clock::now();
+        std::atomic<bool> done { false };
+        std::atomic<int> bad { 0 };
+        std::thread reader([&]() {
+            while (!done.load(std::memory_order_acquire)) {
+                if (const auto latest = history.latest()) {
+                    // 写入的姿态只有 yaw，读到撕裂的四元数时范数会偏离1
+                    if (!near(latest->q.norm(), 1.0, 1e-9)) {
+                        bad.fetch_add(1);
+                    }
+                }
+            }
+        });
+        for (int i = 0; i < 200000; ++i) {
+            history.push(t0 + std::chrono::microseconds(i), std::fmod(0.001 * i, 3.0), 0.0, 0.0);
+        }
+        done.store(true, std::memory_order_release);
+        reader.join();
+        check(bad.load() == 0, "readers never observe a torn sample");
+    }
+} // namespace
+
+int main() {
+    test_empty();
+    test_interpolation();
+    test_extrapolation_limit();
+    test_out_of_range();
+    test_concurrent_readers();
+    if (g_failures != 0) {
+        fmt::print(stderr, "{} check(s) failed\n", g_failures);
+        return 1;
+    }
+    fmt::print("all attitude history checks passed\n");
+    return 0;
+}
@@ -0,0 +1,211 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// C system headers
+
+// C++ system headers
+#include <cstdint>
+#include <vector>
+
+// Third-party library headers
+#include <fmt/core.h>
+
+// Project headers
+#include "hardware/serial/frame_protocol.hpp"
+
+namespace {
+    int g_failures = 0;
+
+    void check(bool condition, const char *what) {
+        if (!condition) {
+            fmt::print(stderr, "FAILED: {}\n", what);
+            ++g_failures;
+        }
+    }
+
+    struct Received {
+        uint16_t msg_id;
+        uint8_t seq;
+        std::vector<uint8_t> payload;
+    };
+
+    /**
+     * @brief 喂入数据并收集解析出的帧
+     */
+    std::size_t feed(serial::FrameDecoder &decoder, const std::vector<uint8_t> &bytes, std::vector<Received> &out) {
+        return decoder.feed(bytes.data(), bytes.size(), [&out](const serial::FrameView &view) {
+            out.push_back({ view.msg_id, view.seq, { view.payload, view.payload + view.size } });
+        });
+    }
+
+    std::vector<uint8_t> payload_of(std::size_t size, uint8_t first) {
+        std::vector<uint8_t> payload(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            payload[i] = static_cast<uint8_t>(first + i);
+        }
+        return payload;
+    }
+
+    void test_round_trip() {
+        serial::FrameEncoder encoder;
+        serial::FrameDecoder decoder;
+        std::vector<uint8_t> stream;
+        const auto a = payload_of(12, 1);
+        const auto b = payload_of(0, 0);
+        check(encoder.encode(0x0301, a.data(), a.size(), stream) == serial::frame::OVERHEAD + 12, "frame length");
+        encoder.encode(0x0102, b.data(), b.size(), stream);
+        std::vector<Received> frames;
+        check(feed(decoder, stream, frames) == 2, "two frames parsed");
+        check(frames.size() == 2 && frames[0].msg_id == 0x0301 && frames[0].payload == a, "payload round trip");
+        check(frames.size() == 2 && frames[1].msg_id == 0x0102 && frames[1].payload.empty(), "empty payload");
+        check(decoder.stats().dropped_bytes == 0, "no bytes dropped on a clean stream");
+    }
+
+    void test_split_frames() {
+        serial::FrameEncoder encoder;
+        serial::FrameDecoder decoder;
+        std::vector<uint8_t> stream;
+        for (int i = 0; i < 3; ++i) {
+            const auto payload = payload_of(20, static_cast<uint8_t>(i));
+            encoder.encode(0x0001, payload.data(), payload.size(), stream);
+        }
+        // 逐字节喂入，帧头、数据区、CRC都会被拆开
+        std::vector<Received> frames;
+        for (const uint8_t byte: stream) {
+            feed(decoder, { byte }, frames);
+        }
+        check(frames.size() == 3, "byte-by-byte feeding yields every frame");
+        check(frames.size() == 3 && frames[2].payload == payload_of(20, 2), "split frame payload intact");
+    }
+
+    void test_resync_after_noise() {
+        serial::FrameEncoder encoder;
+        serial::FrameDecoder decoder;
+        std::vector<uint8_t> stream = { 0x00, 0xa5, 0x13, 0xa5, 0xff };
+        const auto payload = payload_of(8, 0x40);
+        encoder.encode(0x0002, payload.data(), payload.size(), stream);
+        std::vector<Received> frames;
+        feed(decoder, stream, frames);
+        check(frames.size() == 1 && frames[0].payload == payload, "frame after noise is recovered");
+        check(decoder.stats().dropped_bytes == 5, "noise bytes are counted as dropped");
+    }
+
+    void test_crc_failures() {
+        serial::FrameEncoder encoder;
+        serial::FrameDecoder decoder;
+        const auto payload = payload_of(16, 0x10);
+
+        std::vector<uint8_t> bad_header;
+        encoder.encode(0x0003, payload.data(), payload.size(), bad_header);
+        bad_header[4] ^= 0x01;
+        std::vector<uint8_t> bad_body;
+        encoder.encode(0x0003, payload.data(), payload.size(), bad_body);
+        bad_body[serial::frame::HEADER_SIZE + serial::frame::MSG_ID_SIZE + 3] ^= 0x80;
+        std::vector<uint8_t> good;
+        encoder.encode(0x0003, payload.data(), payload.size(), good);
+
+        std::vector<uint8_t> stream = bad_header;
+        stream.insert(stream.end(), bad_body.begin(), bad_body.end());
+        stream.insert(stream.end(), good.begin(), good.end());
+        std::vector<Received> frames;
+        feed(decoder, stream, frames);
+        check(frames.size() == 1 && frames[0].seq == 2, "only the intact frame is delivered");
+        check(decoder.stats().header_crc_errors >= 1, "header CRC failure is counted");
+        check(decoder.stats().frame_crc_errors >= 1, "frame CRC failure is counted");
+    }
+
+    void test_encoder_rejects_oversize() {
+        serial::FrameEncoder encoder(64);
+        std::vector<uint8_t> out;
+        const auto payload = payload_of(65, 0);
+        check(encoder.encode(0x0004, payload.data(), payload.size(), out) == 0, "payload over max_payload is rejected");
+        check(out.empty(), "rejected frame writes nothing");
+
+        serial::FrameEncoder unlimited(1 << 20);
+        const std::vector<uint8_t> huge(serial::frame::MAX_PAYLOAD_LIMIT + 1);
+        check(unlimited.encode(0x0004, huge.data(), huge.size(), out) == 0, "payload over the u16 length field is rejected");
+    }
+
+    void test_seq_accounting() {
+        serial::FrameEncoder encoder;
+        serial::FrameDecoder decoder;
+        const auto payload = payload_of(4, 0);
+        std::vector<std::vector<uint8_t> > encoded(300);
+        for (auto &frame: encoded) {
+            encoder.encode(0x0005, payload.data(), payload.size(), frame);
+        }
+        std::vector<Received> frames;
+        feed(decoder, encoded[0], frames);
+        feed(decoder, encoded[1], frames);
+        // 重传同一帧
+        feed(decoder, encoded[1], frames);
+        // 丢失 2、3
+        feed(decoder, encoded[4], frames);
+        // 迟到的 3
+        feed(decoder, encoded[3], frames);
+        const auto &stats = decoder.stats().messages.at(0x0005);
+        check(stats.received == 5, "every delivered frame is counted as received");
+        check(stats.duplicates == 2, "repeated and late frames are duplicates");
+        check(stats.lost == 2, "a seq gap is counted as lost");
+
+        // seq回绕
+        for (std::size_t i = 5; i < encoded.size(); ++i) {
+            feed(decoder, encoded[i], frames);
+        }
+        check(decoder.stats().messages.at(0x0005).lost == 2, "seq wrap-around is not a loss");
+    }
+
+    void test_seq_resync_after_mcu_reset() {
+        serial::FrameDecoder decoder;
+        const auto payload = payload_of(4, 0);
+        std::vector<Received> frames;
+        // 重启前已发送100帧
+        serial::FrameEncoder before_reset;
+        std::vector<uint8_t> frame;
+        for (int i = 0; i < 100; ++i) {
+            frame.clear();
+            before_reset.encode(0x0006, payload.data(), payload.size(), frame);
+            feed(decoder, frame, frames);
+        }
+        // 下位机重启，seq从0重新计数
+        serial::FrameEncoder after_reset;
+        for (int i = 0; i < 50; ++i) {
+            frame.clear();
+            after_reset.encode(0x0006, payload.data(), payload.size(), frame);
+            feed(decoder, frame, frames);
+        }
+        const auto &stats = decoder.stats().messages.at(0x0006);
+        check(stats.received == 150, "frames after a reset are received");
+        check(stats.resyncs == 1, "a large backward seq jump resyncs once");
+        check(stats.duplicates == 0 && stats.lost == 0, "frames after a reset are neither duplicates nor lost");
+
+        // seq停止前进时每SEQ_RESYNC_DUPLICATES帧重新对齐一次
+        serial::FrameDecoder frozen;
+        serial::FrameEncoder encoder;
+        frame.clear();
+        encoder.encode(0x0007, payload.data(), payload.size(), frame);
+        for (uint32_t i = 0; i <= serial::frame::SEQ_RESYNC_DUPLICATES * 2; ++i) {
+            feed(frozen, frame, frames);
+        }
+        const auto &stuck = frozen.stats().messages.at(0x0007);
+        check(stuck.resyncs == 2, "a run of duplicates resyncs");
+        check(stuck.duplicates == (serial::frame::SEQ_RESYNC_DUPLICATES - 1) * 2, "duplicate runs are bounded");
+    }
+} // namespace
+
+int main() {
+    test_round_trip();
+    test_split_frames();
+    test_resync_after_noise();
+    test_crc_failures();
+    test_encoder_rejects_oversize();
+    test_seq_accounting();
+    test_seq_resync_after_mcu_reset();
+    if (g_failures != 0) {
+        fmt::print(stderr, "{} check(s) failed\n", g_failures);
+        return 1;
+    }
+    fmt::print("all frame protocol checks passed\n");
+    return 0;
+}
@@ -0,0 +1,118 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// C system headers
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+
+// C++ system headers
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+
+// Third-party library headers
+#include <fmt/core.h>
+
+// Project headers
+#include "hardware/serial/frame_transceiver.hpp"
+#include "hardware/serial/protocol/uart_protocol.hpp"
+#include "hardware/serial/transceiver_manager.hpp"
+
+namespace {
+    int g_failures = 0;
+
+    // 析构超过该时间视为读线程卡死
+    constexpr auto SHUTDOWN_TIMEOUT = std::chrono::seconds(2);
+
+    void check(bool condition, const char *what) {
+        if (!condition) {
+            fmt::print(stderr, "FAILED: {}\n", what);
+            ++g_failures;
+        }
+    }
+
+    /**
+     * @brief 在后台线程执行析构，超时说明线程无法退出，直接结束进程
+     */
+    void expect_prompt(const char *what, std::function<void()> work) {
+        std::promise<void> done;
+        auto finished = done.get_future();
+        std::thread([&work, &done]() {
+            work();
+            done.set_value();
+        }).detach();
+        if (finished.wait_for(SHUTDOWN_TIMEOUT) != std::future_status::ready) {
+            fmt::print(stderr, "FAILED: {} (timed out)\n", what);
+            std::_Exit(1);
+        }
+    }
+
+    /**
+     * @brief 打开一对pty，主端保持打开但从不写入，模拟静默的下位机
+     */
+    std::shared_ptr<UartProtocol> open_silent_peer(int &master, int &slave) {
+        char slave_name[128] = {};
+        if (openpty(&master, &slave, slave_name, nullptr, nullptr) != 0) {
+            return nullptr;
+        }
+        termios options {};
+        tcgetattr(master, &options);
+        cfmakeraw(&options);
+        tcsetattr(master, TCSANOW, &options);
+        auto uart = std::make_shared<UartProtocol>(slave_name);
+        if (!uart->open()) {
+            return nullptr;
+        }
+        return uart;
+    }
+
+    void test_manager_shutdown() {
+        int master = -1;
+        int slave = -1;
+        auto uart = open_silent_peer(master, slave);
+        check(uart != nullptr, "pty opened for the manager");
+        if (uart == nullptr) {
+            return;
+        }
+        auto manager = std::make_unique<serial::TransceiverManager<32> >(uart);
+        manager->enable_realtime_read(true);
+        manager->enable_realtime_send(true);
+        // 让读线程进入阻塞的read
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        expect_prompt("manager with a silent peer is destroyed", [&manager]() { manager.reset(); });
+        ::close(master);
+        ::close(slave);
+    }
+
+    void test_frame_transceiver_shutdown() {
+        int master = -1;
+        int slave = -1;
+        auto uart = open_silent_peer(master, slave);
+        check(uart != nullptr, "pty opened for the frame transceiver");
+        if (uart == nullptr) {
+            return;
+        }
+        auto transceiver = std::make_unique<serial::FrameTransceiver>(uart);
+        transceiver->enable_realtime_read(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        expect_prompt("frame transceiver with a silent peer is destroyed", [&transceiver]() { transceiver.reset(); });
+        ::close(master);
+        ::close(slave);
+    }
+} // namespace
+
+int main() {
+    test_manager_shutdown();
+    test_frame_transceiver_shutdown();
+    if (g_failures != 0) {
+        fmt::print(stderr, "{} check(s) failed\n", g_failures);
+        return 1;
+    }
+    fmt::print("all serial shutdown checks passed\n");
+    return 0;
+}
@@ -0,0 +1,328 @@
+//
+// Created by misaka21 on 26-10-16.
+//
+
+// 二进制日志解码工具
+//
+// 用法: rmlog_decode <file.rmlog> [--format text|csv|json] [--node 节点]... [--from 秒] [--to 秒] [--level 等级]
+//   --node   只输出指定节点，可重复
+//   --from   只输出自日志开始后该秒数之后的记录
+//   --to     只输出自日志开始后该秒数之前的记录
+//   --level  只输出不低于该等级的记录(log / info / debug / warning / error)
+//   json 格式每行一个对象
+
+// C system headers
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// C++ system headers
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Third-party library headers
+#include <fmt/args.h>
+#include <fmt/core.h>
+#include <fmt/format.h>
+
+// Project headers
+#include "plugin/debug/binary_log.hpp"
+#include "plugin/debug/timestamp.hpp"
+
+namespace {
+	namespace binlog = debug::binlog;
+
+	// 与 debug::PrintMode 的顺序一致
+	constexpr const char *LEVEL_NAMES[] = {"log", "info", "debug", "warning", "error"};
+	constexpr const char *LEVEL_PREFIXES[] = {"[LOGG]", "[INFO]", "[DBUG]", "[WARN]", "[EROR]"};
+
+	struct Format {
+		std::string signature;
+		std::string text;
+	};
+
+	struct Index {
+		std::unordered_map<uint32_t, std::string> nodes;
+		std::unordered_map<uint32_t, Format> formats;
+	};
+
+	struct Options {
+		std::string path;
+		std::string format = "text";
+		std::set<std::string> nodes;
+		double from = -std::numeric_limits<double>::infinity();
+		double to = std::numeric_limits<double>::infinity();
+		int min_level = 0;
+	};
+
+	std::string unescape(std::string_view text) {
+		std::string result;
+		result.reserve(text.size());
+		for (std::size_t i = 0; i < text.size(); ++i) {
+			if (text[i] == '\\' && i + 1 < text.size()) {
+				++i;
+				result += text[i] == 'n' ? '\n' : text[i];
+			} else {
+				result += text[i];
+			}
+		}
+		return result;
+	}
+
+	bool load_index(const std::string &path, Index &index) {
+		std::ifstream file(path);
+		if (!file.is_open()) {
+			return false;
+		}
+		std::string line;
+		while (std::getline(file, line)) {
+			// "<kind> <id> <signature> <text>"
+			const auto first = line.find(' ');
+			const auto second = line.find(' ', first + 1);
+			const auto third = line.find(' ', second + 1);
+			if (first == std::string::npos || second == std::string::npos || third == std::string::npos) {
+				continue;
+			}
+			const std::string kind = line.substr(0, first);
+			const auto id = static_cast<uint32_t>(std::stoul(line.substr(first + 1, second - first - 1)));
+			std::string signature = line.substr(second + 1, third - second - 1);
+			std::string text = unescape(std::string_view(line).substr(third + 1));
+			if (kind == "node") {
+				index.nodes[id] = std::move(text);
+			} else if (kind == "format") {
+				index.formats[id] = {signature == "-" ? std::string() : std::move(signature), std::move(text)};
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief 按类型签名读出参数并格式化
+	 */
+	std::string render(const Format &format, const char *args, const char *end) {
+		fmt::dynamic_format_arg_store<fmt::format_context> store;
+		for (const char code: format.signature) {
+			const auto read = [&](auto value) {
+				if (args + sizeof(value) > end) {
+					throw fmt::format_error("record truncated");
+				}
+				std::memcpy(&value, args, sizeof(value));
+				args += sizeof(value);
+				return value;
+			};
+			switch (code) {
+				case 'b': store.push_back(read(bool{}));
+					break;
+				case 'c': store.push_back(read(char{}));
+					break;
+				case 'l': store.push_back(read(int64_t{}));
+					break;
+				case 'L': store.push_back(read(uint64_t{}));
+					break;
+				case 'f': store.push_back(read(float{}));
+					break;
+				case 'd': store.push_back(read(double{}));
+					break;
+				case 's': {
+					const auto size = read(uint32_t{});
+					if (args + size > end) {
+						throw fmt::format_error("record truncated");
+					}
+					store.push_back(std::string(args, size));
+					args += size;
+					break;
+				}
+				default:
+					throw fmt::format_error(fmt::format("unknown type code '{}'", code));
+			}
+		}
+		return fmt::vformat(format.text, store);
+	}
+
+	std::string csv_quote(std::string_view text) {
+		std::string result = "\"";
+		for (const char ch: text) {
+			result += ch;
+			if (ch == '"') {
+				result += '"';
+			}
+		}
+		return result + "\"";
+	}
+
+	std::string json_quote(std::string_view text) {
+		std::string result = "\"";
+		for (const char ch: text) {
+			switch (ch) {
+				case '"': result += "\\\"";
+					break;
+				case '\\': result += "\\\\";
+					break;
+				case '\n': result += "\\n";
+					break;
+				case '\t': result += "\\t";
+					break;
+				default:
+					if (static_cast<unsigned char>(ch) < 0x20) {
+						result += fmt::format("\\u{:04x}", static_cast<int>(ch));
+					} else {
+						result += ch;
+					}
+			}
+		}
+		return result + "\"";
+	}
+
+	int level_from_name(std::string_view name) {
+		for (int i = 0; i < static_cast<int>(std::size(LEVEL_NAMES)); ++i) {
+			if (name == LEVEL_NAMES[i]) {
+				return i;
+			}
+		}
+		throw std::invalid_argument(fmt::format("unknown level '{}'", name));
+	}
+
+	bool parse_options(int argc, char **argv, Options &options) {
+		for (int i = 1; i < argc; ++i) {
+			const std::string_view arg = argv[i];
+			const auto value = [&]() -> std::string {
+				if (i + 1 >= argc) {
+					throw std::invalid_argument(fmt::format("{} requires a value", arg));
+				}
+				return argv[++i];
+			};
+			if (arg == "--format") {
+				options.format = value();
+				if (options.format != "text" && options.format != "csv" && options.format != "json") {
+					throw std::invalid_argument("format must be text, csv or json");
+				}
+			} else if (arg == "--node") {
+				options.nodes.insert(value());
+			} else if (arg == "--from") {
+				options.from = std::stod(value());
+			} else if (arg == "--to") {
+				options.to = std::stod(value());
+			} else if (arg == "--level") {
+				options.min_level = level_from_name(value());
+			} else if (arg == "-h" || arg == "--help") {
+				return false;
+			} else if (options.path.empty()) {
+				options.path = std::string(arg);
+			} else {
+				throw std::invalid_argument(fmt::format("unexpected argument '{}'", arg));
+			}
+		}
+		return !options.path.empty();
+	}
+} // namespace
+
+int main(int argc, char **argv) {
+	Options options;
+	try {
+		if (!parse_options(argc, argv, options)) {
+			fmt::print(stderr, "usage: {} <file.rmlog> [--format text|csv|json] [--node NAME]... "
+			           "[--from SEC] [--to SEC] [--level LEVEL]\n", argv[0]);
+			return 2;
+		}
+	} catch (const std::exception &e) {
+		fmt::print(stderr, "{}\n", e.what());
+		return 2;
+	}
+
+	Index index;
+	if (!load_index(options.path + ".rmfmt", index)) {
+		fmt::print(stderr, "cannot open {}.rmfmt\n", options.path);
+		return 1;
+	}
+
+	const int fd = ::open(options.path.c_str(), O_RDONLY | O_CLOEXEC);
+	struct stat info{};
+	if (fd < 0 || ::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(binlog::FileHeader)) {
+		fmt::print(stderr, "cannot read {}\n", options.path);
+		return 1;
+	}
+	const auto file_size = static_cast<std::size_t>(info.st_size);
+	void *mapped = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mapped == MAP_FAILED) {
+		fmt::print(stderr, "cannot mmap {}\n", options.path);
+		return 1;
+	}
+	const char *data = static_cast<const char *>(mapped);
+
+	binlog::FileHeader header{};
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, binlog::MAGIC, sizeof(binlog::MAGIC)) != 0 || header.version != binlog::VERSION) {
+		fmt::print(stderr, "{} is not a version {} binary log\n", options.path, binlog::VERSION);
+		return 1;
+	}
+	const std::size_t end = header.used != 0 ? std::min<std::size_t>(header.used, file_size) : file_size;
+
+	if (options.format == "csv") {
+		fmt::print("seconds,time,thread,level,node,message\n");
+	}
+	uint64_t count = 0;
+	for (std::size_t offset = header.header_size; offset + sizeof(binlog::RecordHeader) <= end;) {
+		binlog::RecordHeader record{};
+		std::memcpy(&record, data + offset, sizeof(record));
+		// 未写完的记录(进程异常退出)或文件结尾
+		if (record.size < sizeof(record) || offset + record.size > end) {
+			break;
+		}
+		const char *args = data + offset + sizeof(record);
+		const char *args_end = data + offset + record.size;
+		offset += record.size;
+
+		const double seconds = static_cast<double>(record.timestamp_ns - header.start_monotonic_ns) * 1e-9;
+		if (seconds < options.from || seconds > options.to || record.level < options.min_level) {
+			continue;
+		}
+		const auto node_iter = index.nodes.find(record.node_id);
+		const std::string node = node_iter == index.nodes.end() ? fmt::format("#{}", record.node_id) : node_iter->second;
+		if (!options.nodes.empty() && options.nodes.count(node) == 0) {
+			continue;
+		}
+
+		std::string message;
+		const auto format_iter = index.formats.find(record.format_id);
+		if (format_iter == index.formats.end()) {
+			message = fmt::format("[未知格式 #{}]", record.format_id);
+		} else {
+			try {
+				message = render(format_iter->second, args, args_end);
+			} catch (const fmt::format_error &e) {
+				message = format_iter->second.text + " [格式化错误: " + e.what() + "]";
+			}
+		}
+
+		const int64_t wall_ns = header.start_wall_ns + (record.timestamp_ns - header.start_monotonic_ns);
+		const std::string time = debug::timestamp::to_string(wall_ns, debug::timestamp::Clock::WALL);
+		const char *level = record.level < std::size(LEVEL_NAMES) ? LEVEL_NAMES[record.level] : "?";
+		if (options.format == "text") {
+			fmt::print("{} {} {}: {}\n", time,
+			           record.level < std::size(LEVEL_PREFIXES) ? LEVEL_PREFIXES[record.level] : "[????]",
+			           node.empty() ? "" : "@" + node, message);
+		} else if (options.format == "csv") {
+			fmt::print("{:.6f},{},{},{},{},{}\n", seconds, csv_quote(time), record.thread_id, level, csv_quote(node),
+			           csv_quote(message));
+		} else {
+			fmt::print("{{\"seconds\":{:.6f},\"time\":\"{}\",\"thread\":{},\"level\":\"{}\",\"node\":{},\"message\":{}}}\n",
+			           seconds, time, record.thread_id, level, json_quote(node), json_quote(message));
+		}
+		++count;
+	}
+	fmt::print(stderr, "{} records, {} dropped while logging\n", count, header.dropped);
+	::munmap(mapped, file_size);
+	::close(fd);
+	return 0;
+}
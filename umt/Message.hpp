@@ -19,6 +19,7 @@
 
 // Project headers
 #include "ObjManager.hpp"
+#include "plugin/debug/trace.hpp"
 
 namespace umt {
     /**
@@ -180,6 +181,7 @@ namespace umt {
    * @return 读取到的消息
    */
         T pop() {
+            TRACE_SCOPE("umt.pop");
             if (!p_msg)
                 throw MessageError_Empty();
             std::unique_lock lock(mtx);
@@ -199,6 +201,7 @@ namespace umt {
    * @return 读取到的消息
    */
         T pop_for(size_t ms) {
+            TRACE_SCOPE("umt.pop");
             if (!p_msg)
                 throw MessageError_Empty();
             using namespace std::chrono;
@@ -224,6 +227,7 @@ namespace umt {
    */
         template<class P>
         T pop_until(P pt) {
+            TRACE_SCOPE("umt.pop");
             if (!p_msg)
                 throw MessageError_Empty();
             std::unique_lock lock(mtx);
@@ -458,6 +462,7 @@ namespace umt {
    * @param obj 待发布的消息消息
    */
         void push(const T &obj) {
+            TRACE_SCOPE("umt.push");
             if (!p_msg)
                 throw MessageError_Empty();
             std::unique_lock subs_lock(p_msg->subs_mtx);